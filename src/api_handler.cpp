@@ -1,6 +1,7 @@
 #include "api_handler.h"
 #include "game_session.h"
 #include <set>
+#include <atomic>
 #include <boost/url.hpp>
 #include "utility_functions.h"
 using namespace boost::urls;
@@ -23,6 +24,10 @@ namespace http_handler
 
 	const std::map<std::string, std::string> invalidEndpointResp{{"code", "badRequest"}, {"message", "Invalid endpoint"}};
 
+	const std::map<std::string, std::string> invalidSinceResp{{"code", "invalidArgument"}, {"message", "Invalid since parameter"}};
+
+	const std::map<std::string, std::string> invalidWaitForTickResp{{"code", "invalidArgument"}, {"message", "Invalid waitForTick parameter"}};
+
 	const std::map<std::string, std::string> failedToParseTickResp{{"code", "invalidArgument"}, {"message", "Failed to parse tick request JSON"}};
 
 	std::string GetAuthToken(std::string_view auth)
@@ -46,7 +51,7 @@ namespace http_handler
 		return std::string(auth.begin(), auth.end());
 	}
 
-	StringResponse MakeStringResponse(http::status status, std::string_view body, unsigned http_version,
+	StringResponse MakeStringResponse(http::status status, std::string body, unsigned http_version,
 									  bool keep_alive, std::string_view content_type,
 									  const std::initializer_list<std::pair<http::field, std::string_view>> &addition_headers)
 	{
@@ -56,8 +61,24 @@ namespace http_handler
 		for (auto it = addition_headers.begin(); it != addition_headers.end(); ++it)
 			response.set(it->first, it->second);
 
-		response.body() = body;
 		response.content_length(body.size());
+		response.body() = std::move(body);
+		response.keep_alive(keep_alive);
+		return response;
+	}
+
+	SharedResponse MakeSharedResponse(http::status status, std::shared_ptr<const std::string> body, unsigned http_version,
+									  bool keep_alive, std::string_view content_type,
+									  const std::initializer_list<std::pair<http::field, std::string_view>> &addition_headers)
+	{
+		SharedResponse response(status, http_version);
+		response.set(http::field::content_type, content_type);
+
+		for (auto it = addition_headers.begin(); it != addition_headers.end(); ++it)
+			response.set(it->first, it->second);
+
+		response.content_length(SharedStringBody::size(body));
+		response.body() = std::move(body);
 		response.keep_alive(keep_alive);
 		return response;
 	}
@@ -85,17 +106,473 @@ namespace http_handler
 		return result;
 	}
 
-	StringResponse ApiHandler::HandleApiRequest(const std::string &request, http::verb method, std::string_view auth_type, const std::string &body, unsigned http_version, bool keep_alive)
+	bool IsBinaryFormat(const std::map<std::string, std::string> &params)
+	{
+		auto it = params.find("format");
+		return it != params.end() && it->second == "bin";
+	}
+
+	void ApiHandler::HandleApiRequest(const std::string &request, http::verb method, std::string_view auth_type, std::string_view accept,
+									  std::string body, unsigned http_version, bool keep_alive, ApiResponder respond)
 	{
-		StringResponse resp;
 		std::string np_request = GetRequestStringWithoutParameters(request);
+		if (np_request == Endpoints::tick_endpoint)
+		{
+			return net::dispatch(strand_, [this, method, body = std::move(body), http_version, keep_alive, respond = std::move(respond)]() mutable
+								 { HandleTickAction(method, body, http_version, keep_alive, std::move(respond)); });
+		}
+
 		auto it_handler = resp_map_.find(np_request);
-		if (it_handler != resp_map_.end())
+		if (it_handler == resp_map_.end())
+			return respond(StringResponse{});
+
+		if (const auto core = runtime_ ? runtime_->CurrentCore() : std::nullopt)
 		{
-			auto parameters = GetRequestParameters(request);
-			return it_handler->second(method, auth_type, body, http_version, keep_alive, parameters);
+			// Ответ отправляет ядро, которому принадлежит соединение
+			respond = [runtime = runtime_, core = *core, respond = std::move(respond)](ApiResponse &&response)
+			{
+				runtime->Execute(core, [respond, response = std::move(response)]() mutable
+								 { respond(std::move(response)); });
+			};
+		}
+
+		// С ядрами запрос игрока передаётся ядру доли индекса, где лежит его токен: strand карты
+		// найдёт уже оно. Остальные запросы сразу направляются в выбранный strand
+		const bool by_token = runtime_ && (np_request == Endpoints::players_endpoint || np_request == Endpoints::state_endpoint ||
+										   np_request == Endpoints::action_endpoint);
+		Strand *strand = by_token ? nullptr : &SelectStrand(np_request, auth_type, body);
+		auto execute = [this, strand, auth_token = by_token ? GetAuthToken(auth_type) : std::string{}](std::function<void()> task)
+		{
+			if (strand)
+				return Execute(*strand, std::move(task));
+			ExecuteForPlayer(auth_token, std::move(task));
+		};
+
+		auto parameters = GetRequestParameters(request);
+		// Формат из Accept передаётся обработчикам как параметр, явный format в запросе важнее
+		if (accept.find(ContentType::DOGSTORY_BIN) != std::string_view::npos)
+			parameters.emplace("format", "bin");
+		if (np_request == Endpoints::state_endpoint && parameters.count("waitForTick"))
+		{
+			return execute([this, method, auth = std::string(auth_type), parameters = std::move(parameters),
+							http_version, keep_alive, respond = std::move(respond)]() mutable
+						   { HandleWaitForState(method, auth, parameters, http_version, keep_alive, std::move(respond)); });
+		}
+
+		execute([&handler = it_handler->second, parameters = std::move(parameters), method, auth = std::string(auth_type),
+				 body = std::move(body), http_version, keep_alive, respond = std::move(respond)]
+				{ respond(handler(method, auth, body, http_version, keep_alive, parameters)); });
+	}
+
+	void ApiHandler::ExecuteForPlayer(const std::string &auth_token, std::function<void()> task)
+	{
+		auto find_and_execute = [this, auth_token, task = std::move(task)]() mutable
+		{
+			// Если игрок не найден или покинет игру раньше, чем запрос дойдёт до strand, ответ об ошибке сформирует обработчик
+			const auto player_session = game_.FindPlayerSession(auth_token);
+			Execute(player_session ? GetMapStrand(player_session->session->GetMap()) : strand_, std::move(task));
+		};
+
+		if (!runtime_)
+			return find_and_execute();
+		runtime_->Execute(game_.GetTokenCore(auth_token), std::move(find_and_execute));
+	}
+
+	void ApiHandler::Execute(Strand &strand, std::function<void()> task)
+	{
+		// Поток ядра выполняет все strand своего io_context по очереди, поэтому задача,
+		// выполненная на ядре вне strand, не пересекается с обработчиками strand
+		if (runtime_)
+		{
+			if (const auto core = runtime_->FindCore(net::query(strand.get_inner_executor(), net::execution::context)))
+				return runtime_->Execute(*core, std::move(task));
+		}
+		net::dispatch(strand, std::move(task));
+	}
+
+	Strand &ApiHandler::SelectStrand(const std::string &endpoint, std::string_view auth_type, const std::string &body)
+	{
+		if (endpoint == Endpoints::game_endpoint)
+		{
+			try
+			{
+				return GetMapStrand(json_loader::ParseJoinGameRequest(body).at("mapId"));
+			}
+			catch (std::exception &)
+			{
+				// Ошибку разбора запроса сообщит обработчик
+				return strand_;
+			}
+		}
+
+		if (endpoint == Endpoints::players_endpoint || endpoint == Endpoints::state_endpoint || endpoint == Endpoints::action_endpoint)
+		{
+			// Если игрок не найден или покинет игру раньше, чем запрос дойдёт до strand, ответ об ошибке сформирует обработчик
+			if (const auto player_session = game_.FindPlayerSession(GetAuthToken(auth_type)))
+				return GetMapStrand(player_session->session->GetMap());
+		}
+
+		return strand_;
+	}
+
+	Strand &ApiHandler::GetMapStrand(const std::string &map_id)
+	{
+		if (auto it = map_strands_.find(map_id); it != map_strands_.end())
+			return it->second;
+
+		return strand_;
+	}
+
+	// Собирает тело ответа о состоянии сессии и публикует его. Вызывается на strand
+	// карты сессии шагом публикации тика, если сессия изменилась за тик
+	std::shared_ptr<const std::string> PublishSessionState(const std::shared_ptr<model::GameSession> &session)
+	{
+		auto body = std::make_shared<const std::string>(
+			json_serializer::GetPlayersDogInfoResponce(session->GetPlayers(), session->GetLootsInfo()));
+		session->PublishStateSnapshot(body);
+		return body;
+	}
+
+	// Возвращает тело ответа о состоянии сессии, опубликованное последним тиком.
+	// Собирает его здесь только для сессии, которая ещё не прошла ни одного тика,
+	// или если тик не собирал его в режиме ограниченной видимости
+	std::shared_ptr<const std::string> GetSessionStateBody(const std::shared_ptr<model::GameSession> &session)
+	{
+		if (auto body = session->GetStateSnapshot())
+			return body;
+		return PublishSessionState(session);
+	}
+
+	// Возвращает изменения состояния сессии с версии since либо полное состояние,
+	// если эта версия выпала из истории. Изменения с предыдущей версии нужны
+	// большинству клиентов, поэтому их тело собирается один раз на версию
+	std::shared_ptr<const std::string> GetSessionStateDeltaBody(const std::shared_ptr<model::GameSession> &session,
+																 std::uint64_t since)
+	{
+		const auto version = session->GetStateVersion();
+		const bool from_previous = since + 1 == version;
+		if (from_previous)
+		{
+			if (auto body = session->GetDeltaSnapshot())
+				return body;
+		}
+
+		const auto delta = session->GetStateDelta(since);
+		auto body = std::make_shared<const std::string>(json_serializer::GetPlayersDogDeltaResponce(
+			version, session->GetPlayers(), session->GetLootsInfo(), delta ? &*delta : nullptr));
+		if (from_previous)
+			session->PublishDeltaSnapshot(body);
+		return body;
+	}
+
+	// Состояние в режиме ограниченной видимости: у каждого игрока своё, поэтому не кэшируется,
+	// а его размер и стоимость сборки зависят от числа объектов рядом с собакой игрока.
+	// Полное тело сессии для него не нужно: версию фиксирует тик.
+	// Изменения с версии since по области не считаются: клиент с since получает область
+	// целиком в формате изменений (full = true), так что ответ не растёт с числом игроков сессии
+	std::shared_ptr<const std::string> GetInterestAreaBody(const std::shared_ptr<model::GameSession> &session,
+															const model::Player &player, double radius, bool binary,
+															bool as_delta = false)
+	{
+		const auto area = session->GetInterestArea(player, radius);
+		if (as_delta)
+			return std::make_shared<const std::string>(
+				json_serializer::GetPlayersDogDeltaResponce(session->GetStateVersion(), area.players, area.loots, nullptr));
+		if (binary)
+			return std::make_shared<const std::string>(
+				binary_serializer::GetPlayersDogInfoBinary(session->GetStateVersion(), area.players, area.loots));
+		return std::make_shared<const std::string>(json_serializer::GetPlayersDogInfoResponce(area.players, area.loots));
+	}
+
+	// Двоичное полное состояние версии собирается, как и JSON, один раз на все запросы
+	std::shared_ptr<const std::string> GetSessionBinaryBody(const std::shared_ptr<model::GameSession> &session)
+	{
+		auto body = session->GetBinarySnapshot();
+		if (!body)
+		{
+			body = std::make_shared<const std::string>(binary_serializer::GetPlayersDogInfoBinary(
+				session->GetStateVersion(), session->GetPlayers(), session->GetLootsInfo()));
+			session->PublishBinarySnapshot(body);
+		}
+		return body;
+	}
+
+	bool ApiHandler::IsWebSocketRequest(const std::string &request) const
+	{
+		return GetRequestStringWithoutParameters(request) == Endpoints::socket_endpoint;
+	}
+
+	void ApiHandler::HandleWebSocket(http::request<http::string_body> &&request, beast::tcp_stream &&stream)
+	{
+		const std::string target{request.target().begin(), request.target().end()};
+		std::string auth_token = GetAuthToken(request[http::field::authorization]);
+		if (auth_token.empty())
+		{
+			const auto params = GetRequestParameters(target);
+			if (auto it = params.find("token"); it != params.end())
+				auth_token = it->second;
+		}
+
+		const auto player_session = auth_token.empty() ? std::nullopt : game_.FindPlayerSession(auth_token);
+		if (!player_session)
+		{
+			// Без известного токена соединение не переводится на WebSocket: отвечаем как обычный API
+			auto response = std::make_shared<StringResponse>(
+				MakeStringResponse(http::status::unauthorized, json_serializer::MakeMappedResponce(playerTokenNotFoundResp),
+								   request.version(), false, ContentType::APPLICATION_JSON,
+								   {{http::field::cache_control, "no-cache"sv}}));
+			auto rejected = std::make_shared<beast::tcp_stream>(std::move(stream));
+			http::async_write(*rejected, *response, [response, rejected](beast::error_code, std::size_t)
+							  {
+				beast::error_code ec;
+				rejected->socket().shutdown(net::ip::tcp::socket::shutdown_send, ec); });
+			return;
+		}
+
+		auto socket = std::make_shared<GameSocket>(std::move(stream), [this, auth_token](std::string message)
+												   { HandleSocketMessage(auth_token, message); });
+		const auto &session = player_session->session;
+		net::dispatch(GetMapStrand(session->GetMap()), [this, socket, session, player = player_session->player]
+					  {
+			auto it = subscribers_.find(session->GetMap());
+			if (it == subscribers_.end())
+				return;
+			it->second.push_back(Subscriber{session, player, socket});
+			socket->Send(GetSubscriberFrame(session, *player)); });
+		socket->Run(std::move(request));
+	}
+
+	void ApiHandler::HandleSocketMessage(const std::string &auth_token, const std::string &message)
+	{
+		// Сообщение клиента имеет тот же вид, что и тело запроса /api/v1/game/player/action
+		ExecuteForPlayer(auth_token, [this, auth_token, message]
+						 {
+			const auto player_session = game_.FindPlayerSession(auth_token);
+			if (!player_session)
+				return;
+			try
+			{
+				MovePlayer(*player_session, message);
+			}
+			catch (std::exception &)
+			{
+				// Некорректное сообщение игнорируется, соединение остаётся открытым
+			} });
+	}
+
+	std::shared_ptr<const std::string> ApiHandler::GetSubscriberFrame(const std::shared_ptr<model::GameSession> &session,
+																	   const model::Player &player) const
+	{
+		if (const double radius = game_.GetInterestRadius(); radius > 0.0)
+			return GetInterestAreaBody(session, player, radius, false);
+		return GetSessionStateBody(session);
+	}
+
+	void ApiHandler::PushState(const std::shared_ptr<model::GameSession> &session)
+	{
+		auto it = subscribers_.find(session->GetMap());
+		if (it == subscribers_.end() || it->second.empty())
+			return;
+
+		// Без ограничения видимости все подписчики получают один общий кадр,
+		// с ним - каждый свою область, найденную по сеткам текущего тика
+		const bool filtered = game_.GetInterestRadius() > 0.0;
+		const auto frame = filtered ? nullptr : GetSessionStateBody(session);
+		auto &subscribers = it->second;
+		std::erase_if(subscribers, [this, &session, &frame, filtered](const Subscriber &subscriber)
+					  {
+			auto socket = subscriber.socket.lock();
+			auto subscribed_session = subscriber.session.lock();
+			auto player = subscriber.player.lock();
+			if (!socket || !subscribed_session || !player)
+				return true;
+			if (subscribed_session == session)
+				socket->Send(filtered ? GetSubscriberFrame(session, *player) : frame);
+			return false; });
+	}
+
+	void ApiHandler::HandleWaitForState(http::verb method, const std::string &auth_type, const std::map<std::string, std::string> &params,
+										unsigned http_version, bool keep_alive, ApiResponder respond)
+	{
+		std::uint64_t wait_for = 0;
+		try
+		{
+			const auto &value = params.at("waitForTick");
+			size_t parsed = 0;
+			wait_for = std::stoull(value, &parsed);
+			if (parsed != value.size())
+				throw std::invalid_argument("waitForTick");
+		}
+		catch (std::exception &)
+		{
+			return respond(MakeStringResponse(http::status::bad_request,
+											  json_serializer::MakeMappedResponce(invalidWaitForTickResp),
+											  http_version, keep_alive, ContentType::APPLICATION_JSON,
+											  {{http::field::cache_control, "no-cache"sv}}));
+		}
+
+		// Ошибки авторизации, неверный метод и уже наступившая версия обрабатываются как обычный запрос
+		const auto player_session = method == http::verb::get ? game_.FindPlayerSession(GetAuthToken(auth_type)) : std::nullopt;
+		auto it_waiting = player_session ? waiting_states_.find(player_session->session->GetMap()) : waiting_states_.end();
+		if (it_waiting == waiting_states_.end())
+			return respond(HandleGetGameState(method, auth_type, {}, http_version, keep_alive, params));
+
+		const auto &session = player_session->session;
+		if (session->GetStateVersion() > wait_for)
+			return respond(HandleGetGameState(method, auth_type, {}, http_version, keep_alive, params));
+
+		auto waiting = std::make_shared<WaitingState>(GetMapStrand(session->GetMap()));
+		waiting->session = session;
+		waiting->wait_for = wait_for;
+		waiting->method = method;
+		waiting->auth_type = auth_type;
+		waiting->params = params;
+		waiting->http_version = http_version;
+		waiting->keep_alive = keep_alive;
+		waiting->respond = std::move(respond);
+		waiting->timer.expires_after(stateWaitTimeout);
+		waiting->timer.async_wait([this, waiting](sys::error_code)
+								  {
+			if (waiting->answered)
+				return;
+			waiting->answered = true;
+			waiting->respond(HandleGetGameState(waiting->method, waiting->auth_type, {}, waiting->http_version,
+												waiting->keep_alive, waiting->params)); });
+		it_waiting->second.push_back(std::move(waiting));
+	}
+
+	void ApiHandler::ReleaseWaitingStates(const std::shared_ptr<model::GameSession> &session)
+	{
+		auto it = waiting_states_.find(session->GetMap());
+		if (it == waiting_states_.end())
+			return;
+
+		const auto version = session->GetStateVersion();
+		std::erase_if(it->second, [this, &session, version](const std::shared_ptr<WaitingState> &waiting)
+					  {
+			if (waiting->answered)
+				return true;
+			if (waiting->session.lock() != session || version <= waiting->wait_for)
+				return false;
+
+			waiting->answered = true;
+			waiting->timer.cancel();
+			waiting->respond(HandleGetGameState(waiting->method, waiting->auth_type, {}, waiting->http_version,
+												waiting->keep_alive, waiting->params));
+			return true; });
+	}
+
+	void ApiHandler::Tick(std::chrono::milliseconds delta, std::function<void()> on_complete)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		// Результаты сессий складываются по их номерам, поэтому общий шаг
+		// не зависит от того, в каком порядке сессии завершили тик
+		struct SessionTickResult
+		{
+			std::optional<model::GameSessionState> state;
+			RetiredSessionPlayers retired;
+			TickTimings timings;
+		};
+
+		struct TickState
+		{
+			std::atomic<size_t> pending_sessions;
+			bool save;
+			Clock::time_point start;
+			std::vector<SessionTickResult> results;
+			std::function<void()> on_complete;
+		};
+
+		const auto sessions = game_.GetSessions();
+		auto tick = std::make_shared<TickState>();
+		tick->pending_sessions = sessions.size();
+		tick->save = game_.IsTimeToSave(delta.count());
+		tick->start = Clock::now();
+		tick->results.resize(sessions.size());
+		tick->on_complete = std::move(on_complete);
+
+		auto finish_tick = [this, tick]
+		{
+			const auto merge_start = Clock::now();
+			std::vector<RetiredSessionPlayers> retired;
+			model::GameSessionsStates states;
+			TickTimings timings;
+			timings.sessions = tick->results.size();
+			for (auto &result : tick->results)
+			{
+				if (!result.retired.second.empty())
+					retired.push_back(std::move(result.retired));
+				if (result.state)
+					states.states.push_back(std::move(*result.state));
+				for (size_t phase = 0; phase < tickPhasesCount; ++phase)
+					timings.phases[phase] = std::max(timings.phases[phase], result.timings.phases[phase]);
+			}
+
+			game_.SaveRetiredPlayers(retired);
+			if (tick->save)
+				game_.SaveSessionsStates(states);
+
+			const auto tick_end = Clock::now();
+			timings[TickPhase::Merge] = tick_end - merge_start;
+			timings[TickPhase::Total] = tick_end - tick->start;
+			if (auto report = tick_timings_.Add(timings))
+				event_logger::LogTickTimings(*report);
+
+			if (tick->on_complete)
+				tick->on_complete();
+		};
+
+		if (sessions.empty())
+			return finish_tick();
+
+		for (size_t i = 0; i < sessions.size(); ++i)
+		{
+			net::post(GetMapStrand(sessions[i]->GetMap()), [this, tick, finish_tick, session = sessions[i], i, delta]
+					  {
+				SessionTickResult &result = tick->results[i];
+				auto phase_start = Clock::now();
+				auto finish_phase = [&result, &phase_start](TickPhase phase)
+				{
+					const auto now = Clock::now();
+					result.timings[phase] = now - phase_start;
+					phase_start = now;
+				};
+
+				game_.GenerateLoot(session, delta.count());
+				finish_phase(TickPhase::LootGeneration);
+
+				session->MoveDogs(delta.count());
+				finish_phase(TickPhase::Movement);
+
+				if (tick->save && session->GetNumPlayers() > 0)
+					result.state = session->GetState();
+				finish_phase(TickPhase::Snapshot);
+
+				result.retired = game_.RetireExpiredPlayers(session);
+				finish_phase(TickPhase::Retirement);
+
+				// Состояние собирается один раз за тик, опрашивающие игроки получают готовое тело
+				session->CommitTick();
+				if (session->IsStateChanged())
+				{
+					// В режиме ограниченной видимости и опрашивающие игроки, и подписчики
+					// получают свою область, поэтому полное тело не собирается
+					if (game_.GetInterestRadius() > 0.0)
+						session->PublishStateSnapshot(nullptr);
+					else
+						PublishSessionState(session);
+				}
+				if (session->GetNumPlayers() > 0)
+				{
+					PushState(session);
+					ReleaseWaitingStates(session);
+				}
+				finish_phase(TickPhase::StatePublish);
+
+				if (tick->pending_sessions.fetch_sub(1, std::memory_order_acq_rel) == 1)
+					net::dispatch(strand_, finish_tick); });
 		}
-		return resp;
 	}
 
 	void ApiHandler::InitApiRequestHandlers()
@@ -113,7 +590,7 @@ namespace http_handler
 		};
 
 		auto get_state_handler = [this](http::verb method, std::string_view auth_type, const std::string &body,
-										unsigned http_version, bool keep_alive, const std::map<std::string, std::string> &params) -> StringResponse
+										unsigned http_version, bool keep_alive, const std::map<std::string, std::string> &params) -> ApiResponse
 		{
 			return HandleGetGameState(method, auth_type, body, http_version, keep_alive, params);
 		};
@@ -124,12 +601,6 @@ namespace http_handler
 			return HandlePlayerAction(method, auth_type, body, http_version, keep_alive, params);
 		};
 
-		auto tick_handler = [this](http::verb method, std::string_view auth_type, const std::string &body,
-								   unsigned http_version, bool keep_alive, const std::map<std::string, std::string> &params) -> StringResponse
-		{
-			return HandleTickAction(method, auth_type, body, http_version, keep_alive, params);
-		};
-
 		auto records_handler = [this](http::verb method, std::string_view auth_type, const std::string &body,
 									  unsigned http_version, bool keep_alive, const std::map<std::string, std::string> &params) -> StringResponse
 		{
@@ -139,7 +610,6 @@ namespace http_handler
 		resp_map_[std::string(Endpoints::players_endpoint)] = get_players_handler;
 		resp_map_[std::string(Endpoints::state_endpoint)] = get_state_handler;
 		resp_map_[std::string(Endpoints::action_endpoint)] = action_handler;
-		resp_map_[std::string(Endpoints::tick_endpoint)] = tick_handler;
 		resp_map_[std::string(Endpoints::records_endpoint)] = records_handler;
 	}
 
@@ -153,7 +623,7 @@ namespace http_handler
 		}
 		else if (method == http::verb::head)
 		{
-			resp = MakeStringResponse(http::status::method_not_allowed, ""sv,
+			resp = MakeStringResponse(http::status::method_not_allowed, "",
 									  http_version, keep_alive,
 									  ContentType::APPLICATION_JSON,
 									  {{http::field::cache_control, "no-cache"sv},
@@ -190,8 +660,9 @@ namespace http_handler
 		{
 			auto [token, playerId] = game_.AddPlayer(respMap["mapId"], respMap["userName"]);
 
-			auto player = game_.GetPlayerWithAuthToken(token);
-			player->GetDog()->SpawnDogInMap(game_.GetSpawnInRandomPoint());
+			const auto player_session = game_.FindPlayerSession(token).value();
+			player_session.player->GetDog()->SpawnDogInMap(game_.GetSpawnInRandomPoint());
+			player_session.session->MarkStateChanged();
 
 			auto resp = MakeStringResponse(http::status::ok,
 										   json_serializer::MakeAuthResponce(token, playerId), http_version,
@@ -246,7 +717,8 @@ namespace http_handler
 									  http_version, keep_alive, ContentType::APPLICATION_JSON,
 									  {{http::field::cache_control, "no-cache"sv}});
 		}
-		if (!game_.HasSessionWithAuthInfo(auth_token))
+		const auto player_session = game_.FindPlayerSession(auth_token);
+		if (!player_session)
 		{
 			return MakeStringResponse(http::status::unauthorized,
 									  json_serializer::MakeMappedResponce(playerTokenNotFoundResp),
@@ -254,14 +726,19 @@ namespace http_handler
 									  {{http::field::cache_control, "no-cache"sv}});
 		}
 
-		auto players = game_.FindAllPlayersForAuthInfo(auth_token);
+		const bool binary = IsBinaryFormat(params);
+		const auto content_type = binary ? ContentType::DOGSTORY_BIN : ContentType::APPLICATION_JSON;
 		StringResponse resp;
 		if (method == http::verb::get)
-			resp = MakeStringResponse(http::status::ok, json_serializer::GetPlayerInfoResponce(players), http_version, keep_alive,
-									  ContentType::APPLICATION_JSON, {{http::field::cache_control, "no-cache"sv}});
+		{
+			const auto &players = player_session->session->GetPlayers();
+			resp = MakeStringResponse(http::status::ok,
+									  binary ? binary_serializer::GetPlayerInfoBinary(players) : json_serializer::GetPlayerInfoResponce(players),
+									  http_version, keep_alive, content_type, {{http::field::cache_control, "no-cache"sv}});
+		}
 		else
 			resp = MakeStringResponse(http::status::ok, "", http_version, keep_alive,
-									  ContentType::APPLICATION_JSON, {{http::field::cache_control, "no-cache"sv}});
+									  content_type, {{http::field::cache_control, "no-cache"sv}});
 		return resp;
 	}
 
@@ -276,8 +753,8 @@ namespace http_handler
 		return true;
 	}
 
-	StringResponse ApiHandler::HandleGetGameState(http::verb method, std::string_view auth_type, const std::string &body,
-												  unsigned http_version, bool keep_alive, const std::map<std::string, std::string> &params)
+	ApiResponse ApiHandler::HandleGetGameState(http::verb method, std::string_view auth_type, const std::string &body,
+											   unsigned http_version, bool keep_alive, const std::map<std::string, std::string> &params)
 	{
 		if ((method != http::verb::get) && (method != http::verb::head))
 		{
@@ -289,7 +766,8 @@ namespace http_handler
 			return resp;
 		}
 		std::string auth_token = GetAuthToken(auth_type);
-		if (auth_token.empty() || !game_.HasSessionWithAuthInfo(auth_token))
+		const auto player_session = auth_token.empty() ? std::nullopt : game_.FindPlayerSession(auth_token);
+		if (!player_session)
 		{
 			StringResponse resp;
 			if (auth_token.empty() || !IsValidAuthToken(auth_token, 32))
@@ -304,19 +782,51 @@ namespace http_handler
 									  {{http::field::cache_control, "no-cache"sv}});
 		}
 
+		std::optional<std::uint64_t> since;
+		if (auto it = params.find("since"); it != params.end())
+		{
+			try
+			{
+				size_t parsed = 0;
+				since = std::stoull(it->second, &parsed);
+				if (parsed != it->second.size())
+					throw std::invalid_argument("since");
+			}
+			catch (std::exception &)
+			{
+				return MakeStringResponse(http::status::bad_request,
+										  json_serializer::MakeMappedResponce(invalidSinceResp),
+										  http_version, keep_alive, ContentType::APPLICATION_JSON,
+										  {{http::field::cache_control, "no-cache"sv}});
+			}
+		}
+
+		// Изменения с версии since передаются только в JSON
+		const bool binary = !since && IsBinaryFormat(params);
+		const auto content_type = binary ? ContentType::DOGSTORY_BIN : ContentType::APPLICATION_JSON;
 		if (method == http::verb::get)
 		{
-			auto players = game_.FindAllPlayersForAuthInfo(auth_token);
-			auto loots = game_.GetLootsForAuthInfo(auth_token);
-			auto resp = MakeStringResponse(http::status::ok, json_serializer::GetPlayersDogInfoResponce(players, loots),
-										   http_version, keep_alive, ContentType::APPLICATION_JSON,
+			const auto &session = player_session->session;
+			std::shared_ptr<const std::string> body;
+			if (const double radius = game_.GetInterestRadius(); radius > 0.0)
+				body = GetInterestAreaBody(session, *player_session->player, radius, binary, since.has_value());
+			else if (since)
+				body = GetSessionStateDeltaBody(session, *since);
+			else if (binary)
+				body = GetSessionBinaryBody(session);
+			else
+				body = GetSessionStateBody(session);
+			// Тело, общее для всех запросов версии, передаётся в ответ по указателю, а не копируется
+			auto resp = MakeSharedResponse(http::status::ok, std::move(body),
+										   http_version, keep_alive, content_type,
 										   {{http::field::cache_control, "no-cache"sv}});
+			resp.set(HeaderType::GAME_TICK, std::to_string(session->GetStateVersion()));
 			return resp;
 		}
 		else
 		{
 			auto resp = MakeStringResponse(http::status::ok, "", http_version, keep_alive,
-										   ContentType::APPLICATION_JSON, {{http::field::cache_control, "no-cache"sv}});
+										   content_type, {{http::field::cache_control, "no-cache"sv}});
 			return resp;
 		}
 	}
@@ -344,7 +854,9 @@ namespace http_handler
 
 			return resp;
 		}
-		else if (!game_.HasSessionWithAuthInfo(auth_token))
+
+		const auto player_session = game_.FindPlayerSession(auth_token);
+		if (!player_session)
 		{
 			auto resp = MakeStringResponse(http::status::unauthorized,
 										   json_serializer::MakeMappedResponce(playerTokenNotFoundResp),
@@ -354,64 +866,58 @@ namespace http_handler
 			return resp;
 		}
 
-		auto session = game_.GetSessionWithAuthInfo(auth_token);
-		auto map = game_.FindMap(model::Map::Id(session->GetMap()));
-		auto map_speed = map->GetDogSpeed();
-		auto player = game_.GetPlayerWithAuthToken(auth_token);
-
-		DogDirection dir = json_loader::GetMoveDirection(body);
-		player->GetDog()->SetSpeed(dir, map_speed > 0.0 ? map_speed : game_.GetDefaultDogSpeed());
+		MovePlayer(*player_session, body);
 
 		auto resp = MakeStringResponse(http::status::ok, "{}", http_version, keep_alive, ContentType::APPLICATION_JSON,
 									   {{http::field::cache_control, "no-cache"sv}});
 		return resp;
 	}
 
-	StringResponse ApiHandler::HandleTickAction(http::verb method, std::string_view auth_type,
-												const std::string &body, unsigned http_version,
-												bool keep_alive, const std::map<std::string, std::string> &params)
+	void ApiHandler::MovePlayer(const model::Game::PlayerSession &player_session, const std::string &body)
 	{
-		StringResponse resp;
+		auto map = game_.FindMap(model::Map::Id(player_session.session->GetMap()));
+		auto map_speed = map->GetDogSpeed();
+
+		DogDirection dir = json_loader::GetMoveDirection(body);
+		player_session.player->GetDog()->SetSpeed(dir, map_speed > 0.0 ? map_speed : game_.GetDefaultDogSpeed());
+		player_session.session->MarkStateChanged();
+	}
 
+	void ApiHandler::HandleTickAction(http::verb method, const std::string &body, unsigned http_version, bool keep_alive,
+									  ApiResponder respond)
+	{
 		if (method != http::verb::post)
 		{
-			resp = MakeStringResponse(http::status::method_not_allowed,
-									  json_serializer::MakeMappedResponce(invaliMethodResp),
-									  http_version, keep_alive, ContentType::APPLICATION_JSON,
-									  {{http::field::cache_control, "no-cache"sv}});
-
-			return resp;
+			return respond(MakeStringResponse(http::status::method_not_allowed,
+											  json_serializer::MakeMappedResponce(invaliMethodResp),
+											  http_version, keep_alive, ContentType::APPLICATION_JSON,
+											  {{http::field::cache_control, "no-cache"sv}}));
 		}
 		if (ticker_)
 		{
-			resp = MakeStringResponse(http::status::bad_request,
-									  json_serializer::MakeMappedResponce(invalidEndpointResp),
-									  http_version, keep_alive, ContentType::APPLICATION_JSON,
-									  {{http::field::cache_control, "no-cache"sv}});
+			return respond(MakeStringResponse(http::status::bad_request,
+											  json_serializer::MakeMappedResponce(invalidEndpointResp),
+											  http_version, keep_alive, ContentType::APPLICATION_JSON,
+											  {{http::field::cache_control, "no-cache"sv}}));
 		}
-		else
+
+		int deltaTime = 0;
+		try
 		{
-			try
-			{
-				int deltaTime = json_loader::ParseDeltaTimeRequest(body);
-
-				game_.GenerateLoot(deltaTime);
-				game_.MoveDogs(deltaTime);
-				game_.SaveSessions(deltaTime);
-				game_.HandleRetiredPlayers();
-				resp = MakeStringResponse(http::status::ok, "{}", http_version, keep_alive,
-										  ContentType::APPLICATION_JSON, {{http::field::cache_control, "no-cache"sv}});
-			}
-			catch (BadDeltaTimeException &ex)
-			{
-				resp = MakeStringResponse(http::status::bad_request,
-										  json_serializer::MakeMappedResponce(failedToParseTickResp),
-										  http_version, keep_alive, ContentType::APPLICATION_JSON,
-										  {{http::field::cache_control, "no-cache"sv}});
-			}
+			deltaTime = json_loader::ParseDeltaTimeRequest(body);
+		}
+		catch (BadDeltaTimeException &ex)
+		{
+			return respond(MakeStringResponse(http::status::bad_request,
+											  json_serializer::MakeMappedResponce(failedToParseTickResp),
+											  http_version, keep_alive, ContentType::APPLICATION_JSON,
+											  {{http::field::cache_control, "no-cache"sv}}));
 		}
 
-		return resp;
+		// Отвечаем, когда тик завершится во всех сессиях
+		Tick(std::chrono::milliseconds(deltaTime), [respond = std::move(respond), http_version, keep_alive]
+			 { respond(MakeStringResponse(http::status::ok, "{}", http_version, keep_alive,
+										  ContentType::APPLICATION_JSON, {{http::field::cache_control, "no-cache"sv}})); });
 	}
 
 	std::pair<int, int> ParseParameters(const std::map<std::string, std::string> &params)
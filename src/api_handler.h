@@ -2,11 +2,18 @@
 #include "http_server.h"
 #include "model.h"
 #include "json_serializer.h"
+#include "binary_serializer.h"
 #include "json_loader.h"
 #include "event_logger.h"
 #include "server_exceptions.h"
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include "ticker.h"
+#include "tick_timings.h"
+#include "game_socket.h"
+#include "core_runtime.h"
+#include "shared_string_body.h"
+#include <variant>
 
 namespace net = boost::asio;
 
@@ -20,7 +27,12 @@ namespace http_handler
     using namespace std::literals;
 
     using StringResponse = http::response<http::string_body>;
+    // Ответ с общим телом: опубликованное тиком состояние сессии отправляется без копирования
+    using SharedResponse = http::response<SharedStringBody>;
+    using ApiResponse = std::variant<StringResponse, SharedResponse>;
     using Strand = boost::asio::strand<boost::asio::io_context::executor_type>;
+    // Ответ на API-запрос отправляется из strand, в котором запрос был обработан
+    using ApiResponder = std::function<void(ApiResponse &&)>;
 
     struct Endpoints
     {
@@ -31,6 +43,7 @@ namespace http_handler
         constexpr static std::string_view action_endpoint = "/api/v1/game/player/action";
         constexpr static std::string_view tick_endpoint = "/api/v1/game/tick";
         constexpr static std::string_view records_endpoint = "/api/v1/game/records";
+        constexpr static std::string_view socket_endpoint = "/api/v1/game/socket";
     };
 
     struct ContentType
@@ -38,6 +51,8 @@ namespace http_handler
         ContentType() = delete;
         constexpr static std::string_view APPLICATION_JSON = "application/json"sv;
         constexpr static std::string_view TEXT_PLAIN = "text/plain"sv;
+        // Двоичное состояние игры, см. binary_serializer.h
+        constexpr static std::string_view DOGSTORY_BIN = "application/x-dogstory-bin"sv;
     };
 
     struct HeaderType
@@ -45,27 +60,56 @@ namespace http_handler
         HeaderType() = delete;
         constexpr static std::string_view ALLOW_HEADERS = "GET, HEAD"sv;
         constexpr static std::string_view ALLOW_POST = "POST"sv;
+        // Версия состояния сессии, которую можно передать в since и waitForTick
+        constexpr static std::string_view GAME_TICK = "X-Game-Tick"sv;
     };
 
-    StringResponse MakeStringResponse(http::status status, std::string_view body, unsigned http_version,
+    // Тело принимается по значению: готовая строка ответа, например от json_serializer, переносится в ответ без копирования
+    StringResponse MakeStringResponse(http::status status, std::string body, unsigned http_version,
+                                      bool keep_alive, std::string_view content_type = ContentType::APPLICATION_JSON,
+                                      const std::initializer_list<std::pair<http::field, std::string_view>> &addition_headers = {});
+    // Ответ, тело которого разделяется со всеми запросами, получившими ту же строку
+    SharedResponse MakeSharedResponse(http::status status, std::shared_ptr<const std::string> body, unsigned http_version,
                                       bool keep_alive, std::string_view content_type = ContentType::APPLICATION_JSON,
                                       const std::initializer_list<std::pair<http::field, std::string_view>> &addition_headers = {});
 
+    // Состояние каждой карты (её игровая сессия) обслуживается в собственном strand,
+    // поэтому запросы к разным картам выполняются параллельно. Запросы с токеном
+    // направляются в strand карты игрока, запрос на вход в игру - в strand карты из тела запроса.
+    // Тик выполняется в общем strand_ и раздаётся по strand-ам карт: сессии обрабатываются
+    // параллельно потоками io_context, а общие для игры действия (запись покинувших игру
+    // в базу, сохранение состояния) выполняются после них в strand_ в порядке сессий.
+    // Подписчики WebSocket хранятся по картам и тоже обслуживаются в strand карты:
+    // после тика сессии её состояние рассылается им одним общим кадром, а в режиме
+    // ограниченной видимости - каждому кадром с его областью.
+    // Там же ждут запросы состояния с waitForTick: их отпускает тик, изменивший версию
+    // состояния, или таймер; ни один поток при этом не блокируется.
+    // С набором ядер runtime сессия каждой карты принадлежит одному ядру (Game::GetMapCore):
+    // strand карты создаётся в io_context этого ядра, и всё состояние карты меняет только его поток.
+    // Запрос, принятый другим ядром, передаётся через почтовый ящик ядру, в доле индекса которого
+    // лежит токен игрока, а от него - ядру карты (для новых игроков это одно ядро). Ответ возвращается
+    // ядру, принявшему запрос, тем же путём. Тик и общие для игры действия остаются в strand_ общего ioc
     class ApiHandler
     {
     public:
-        explicit ApiHandler(model::Game &game, Strand &strand) : game_{game}, strand_{strand}
+        explicit ApiHandler(model::Game &game, net::io_context &ioc, core_runtime::CoreRuntime *runtime = nullptr)
+            : game_{game}, strand_{net::make_strand(ioc)}, runtime_{runtime}
         {
+            for (const auto &map : game_.GetMaps())
+            {
+                auto &map_context = runtime_ ? runtime_->GetContext(game_.GetMapCore(*map.GetId())) : ioc;
+                map_strands_.emplace(*map.GetId(), net::make_strand(map_context));
+                subscribers_.emplace(*map.GetId(), std::vector<Subscriber>{});
+                waiting_states_.emplace(*map.GetId(), std::vector<std::shared_ptr<WaitingState>>{});
+            }
+
             InitApiRequestHandlers();
             if (game_.GetTickPeriod() > 0)
             {
                 ticker_ = std::make_shared<Ticker>(strand_, std::chrono::milliseconds(game_.GetTickPeriod()),
                                                    [this](std::chrono::milliseconds ticks)
                                                    {
-                                                       game_.GenerateLoot(ticks.count());
-                                                       game_.MoveDogs(ticks.count());
-                                                       game_.SaveSessions(ticks.count());
-                                                       game_.HandleRetiredPlayers();
+                                                       Tick(ticks, {});
                                                    });
             }
         }
@@ -74,22 +118,53 @@ namespace http_handler
         ApiHandler &operator=(const ApiHandler &) = delete;
 
         bool IsApiRequest(const std::string &request);
-        StringResponse HandleApiRequest(const std::string &request, http::verb method, std::string_view auth_type,
-                                        const std::string &body, unsigned http_version, bool keep_alive);
+        // Клиент, принимающий DOGSTORY_BIN (заголовок Accept), получает состояние и список игроков
+        // в двоичном виде. То же можно запросить параметром format=bin
+        void HandleApiRequest(const std::string &request, http::verb method, std::string_view auth_type, std::string_view accept,
+                              std::string body, unsigned http_version, bool keep_alive, ApiResponder respond);
+        bool IsWebSocketRequest(const std::string &request) const;
+        // Переводит соединение на WebSocket и подписывает его на состояние сессии игрока.
+        // Токен передаётся в заголовке Authorization или, для браузеров, в параметре token
+        void HandleWebSocket(http::request<http::string_body> &&request, beast::tcp_stream &&stream);
 
     private:
         void InitApiRequestHandlers();
+        Strand &SelectStrand(const std::string &endpoint, std::string_view auth_type, const std::string &body);
+        Strand &GetMapStrand(const std::string &map_id);
+        // Выполняет task в strand: на ядре strand - через его почтовый ящик, вне ядер - через dispatch
+        void Execute(Strand &strand, std::function<void()> task);
+        // Выполняет task в strand карты игрока с токеном auth_token или в strand_, если игрок не найден.
+        // С ядрами игрока ищет ядро, в доле индекса которого лежит токен
+        void ExecuteForPlayer(const std::string &auth_token, std::function<void()> task);
+        // Выполняет тик во всех сессиях, каждую в strand её карты. on_complete вызывается
+        // в strand_ после завершения тика во всех сессиях. Время фаз тика раз в
+        // ticksPerTimingsReport тиков выводится в журнал
+        void Tick(std::chrono::milliseconds delta, std::function<void()> on_complete);
+        // Рассылает состояние сессии её подписчикам. Вызывается в strand карты сессии
+        void PushState(const std::shared_ptr<model::GameSession> &session);
+        // Кадр состояния для подписчика-игрока player: общее тело сессии или, в режиме
+        // ограниченной видимости, его область. Вызывается в strand карты сессии
+        std::shared_ptr<const std::string> GetSubscriberFrame(const std::shared_ptr<model::GameSession> &session,
+                                                              const model::Player &player) const;
+        void HandleSocketMessage(const std::string &auth_token, const std::string &message);
+        // Запрос состояния с waitForTick=n: отвечает, как только версия состояния сессии
+        // превысит n, или по истечении stateWaitTimeout. Вызывается в strand карты игрока
+        void HandleWaitForState(http::verb method, const std::string &auth_type, const std::map<std::string, std::string> &params,
+                                unsigned http_version, bool keep_alive, ApiResponder respond);
+        // Отвечает на дождавшиеся нового состояния запросы. Вызывается в strand карты сессии
+        void ReleaseWaitingStates(const std::shared_ptr<model::GameSession> &session);
+        void MovePlayer(const model::Game::PlayerSession &player_session, const std::string &body);
         StringResponse HandleJoinGameRequest(http::verb method, std::string_view auth_type,
                                              const std::string &body, unsigned http_version, bool keep_alive, const std::map<std::string, std::string> &params);
         StringResponse HandleAuthRequest(const std::string &body, unsigned http_version, bool keep_alive);
         StringResponse HandleGetPlayersRequest(http::verb method, std::string_view auth_type, const std::string &body,
                                                unsigned http_version, bool keep_alive, const std::map<std::string, std::string> &params);
-        StringResponse HandleGetGameState(http::verb method, std::string_view auth_type, const std::string &body,
+        ApiResponse HandleGetGameState(http::verb method, std::string_view auth_type, const std::string &body,
                                           unsigned http_version, bool keep_alive, const std::map<std::string, std::string> &params);
         StringResponse HandlePlayerAction(http::verb method, std::string_view auth_type, const std::string &body,
                                           unsigned http_version, bool keep_alive, const std::map<std::string, std::string> &params);
-        StringResponse HandleTickAction(http::verb method, std::string_view auth_type, const std::string &body,
-                                        unsigned http_version, bool keep_alive, const std::map<std::string, std::string> &params);
+        void HandleTickAction(http::verb method, const std::string &body, unsigned http_version, bool keep_alive,
+                              ApiResponder respond);
 
         StringResponse HandleGetRecordsAction(http::verb method, std::string_view auth_type, const std::string &body,
                                               unsigned http_version, bool keep_alive, const std::map<std::string, std::string> &params);
@@ -97,9 +172,43 @@ namespace http_handler
     private:
         model::Game &game_;
         std::map<std::string,
-                 std::function<StringResponse(http::verb, std::string_view, const std::string &, unsigned, bool, const std::map<std::string, std::string> &)>>
+                 std::function<ApiResponse(http::verb, std::string_view, const std::string &, unsigned, bool, const std::map<std::string, std::string> &)>>
             resp_map_;
         std::shared_ptr<Ticker> ticker_;
-        Strand &strand_;
+        static constexpr size_t ticksPerTimingsReport = 100;
+        // Используется только в strand_
+        TickTimingsCollector tick_timings_{ticksPerTimingsReport};
+        Strand strand_;
+        std::unordered_map<std::string, Strand> map_strands_;
+        core_runtime::CoreRuntime *runtime_;
+
+        struct Subscriber
+        {
+            std::weak_ptr<model::GameSession> session;
+            std::weak_ptr<model::Player> player;
+            std::weak_ptr<GameSocket> socket;
+        };
+        // Набор карт неизменен, список подписчиков карты используется только в её strand
+        std::unordered_map<std::string, std::vector<Subscriber>> subscribers_;
+
+        struct WaitingState
+        {
+            WaitingState(const Strand &strand) : timer{strand} {}
+
+            std::weak_ptr<model::GameSession> session;
+            std::uint64_t wait_for{0};
+            http::verb method;
+            std::string auth_type;
+            std::map<std::string, std::string> params;
+            unsigned http_version{11};
+            bool keep_alive{false};
+            ApiResponder respond;
+            net::steady_timer timer;
+            bool answered{false};
+        };
+        // Ответ должен успеть до таймаута чтения HTTP-сессии (30 секунд)
+        static constexpr std::chrono::seconds stateWaitTimeout{20};
+        // Как и подписчики, ожидающие запросы хранятся по картам и используются в strand карты
+        std::unordered_map<std::string, std::vector<std::shared_ptr<WaitingState>>> waiting_states_;
     };
 } // namespace http_handler
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "binary_serializer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "game_session.h"
+
+namespace binary_serializer
+{
+	namespace
+	{
+		// Собирает сообщение в строку: байты пишутся по одному, поэтому порядок
+		// байтов не зависит от платформы
+		class Writer
+		{
+		public:
+			explicit Writer(MessageKind kind, size_t reserve)
+			{
+				buffer_.reserve(reserve);
+				buffer_.append("DSB");
+				WriteByte(formatVersion);
+				WriteByte(static_cast<std::uint8_t>(kind));
+			}
+
+			void WriteByte(std::uint8_t value) { buffer_.push_back(static_cast<char>(value)); }
+
+			void WriteVarint(std::uint64_t value)
+			{
+				while (value >= 0x80)
+				{
+					WriteByte(static_cast<std::uint8_t>(value | 0x80));
+					value >>= 7;
+				}
+				WriteByte(static_cast<std::uint8_t>(value));
+			}
+
+			void WriteInt32(std::int32_t value)
+			{
+				const auto bits = static_cast<std::uint32_t>(value);
+				char bytes[4] = {static_cast<char>(bits), static_cast<char>(bits >> 8),
+								 static_cast<char>(bits >> 16), static_cast<char>(bits >> 24)};
+				buffer_.append(bytes, sizeof(bytes));
+			}
+
+			void WriteFixed(double value)
+			{
+				constexpr double maxValue = std::numeric_limits<std::int32_t>::max();
+				constexpr double minValue = std::numeric_limits<std::int32_t>::min();
+				const double scaled = std::round(value * fixedPointScale);
+				WriteInt32(static_cast<std::int32_t>(std::clamp(scaled, minValue, maxValue)));
+			}
+
+			void WriteString(std::string_view value)
+			{
+				WriteVarint(value.size());
+				buffer_.append(value);
+			}
+
+			std::string Release() { return std::move(buffer_); }
+
+		private:
+			std::string buffer_;
+		};
+
+		std::uint8_t EncodeDirection(model::DogDirection direction)
+		{
+			switch (direction)
+			{
+			case model::DogDirection::NORTH:
+				return 0;
+			case model::DogDirection::SOUTH:
+				return 1;
+			case model::DogDirection::WEST:
+				return 2;
+			case model::DogDirection::EAST:
+				return 3;
+			default:
+				return 4;
+			}
+		}
+	}
+
+	std::string GetPlayersDogInfoBinary(std::uint64_t tick, const std::vector<std::shared_ptr<model::Player>> &players,
+										const std::vector<model::LootInfo> &loots)
+	{
+		// Игрок с пустым рюкзаком занимает не больше 28 байт, трофей - не больше 13
+		Writer writer(MessageKind::STATE, 32 + players.size() * 28 + loots.size() * 13);
+		writer.WriteVarint(tick);
+
+		writer.WriteVarint(players.size());
+		for (const auto &player : players)
+		{
+			const auto dog = player->GetDog();
+			const auto pos = dog->GetPosition();
+			const auto speed = dog->GetSpeed();
+
+			writer.WriteVarint(player->GetId());
+			writer.WriteFixed(pos.x);
+			writer.WriteFixed(pos.y);
+			writer.WriteFixed(speed.vx);
+			writer.WriteFixed(speed.vy);
+			writer.WriteByte(EncodeDirection(dog->GetDirection()));
+			writer.WriteVarint(static_cast<std::uint32_t>(dog->GetScore()));
+
+			const auto &bag = dog->GetGatheredLoot();
+			writer.WriteVarint(bag.size());
+			for (const auto &loot : bag)
+			{
+				writer.WriteVarint(loot.id);
+				writer.WriteVarint(loot.type);
+			}
+		}
+
+		writer.WriteVarint(loots.size());
+		for (const auto &loot : loots)
+		{
+			writer.WriteVarint(loot.type);
+			writer.WriteFixed(loot.x);
+			writer.WriteFixed(loot.y);
+		}
+
+		return writer.Release();
+	}
+
+	std::string GetPlayerInfoBinary(const std::vector<std::shared_ptr<model::Player>> &players)
+	{
+		Writer writer(MessageKind::PLAYERS, 16 + players.size() * 16);
+		writer.WriteVarint(players.size());
+		for (const auto &player : players)
+		{
+			writer.WriteVarint(player->GetId());
+			writer.WriteString(player->GetName());
+		}
+		return writer.Release();
+	}
+} // namespace binary_serializer
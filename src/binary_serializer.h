@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "model.h"
+
+namespace model
+{
+	class Player;
+}
+
+// Компактное двоичное представление состояния игры - альтернатива JSON для клиентов,
+// приславших Accept: application/x-dogstory-bin. Формат (все числа little-endian):
+//   заголовок:  "DSB", версия формата (1 байт), вид сообщения (1 байт, MessageKind)
+//   состояние:  varint tick, varint число игроков, затем для каждого игрока
+//               varint id, int32 x, int32 y, int32 vx, int32 vy, u8 направление,
+//               varint очки, varint размер рюкзака и пары varint id, varint тип трофея;
+//               varint число трофеев на карте, затем для каждого varint тип, int32 x, int32 y
+//   игроки:     varint число игроков, затем для каждого varint id, varint длина имени, имя в UTF-8
+// Координаты и скорости передаются в фиксированной точке: значение, умноженное на fixedPointScale.
+// Направление - номер в строке "UDLR", 4 - собака стоит. Тип трофея - номер в lootTypes карты,
+// поэтому описание типов клиент берёт один раз из ответа о карте.
+// Справочный декодер - static/js/state_decoder.js. Эталонные сообщения в tests/data проверяют
+// и кодировщик (tests/binary_serializer_tests.cpp), и декодер (node tests/state_decoder_test.js)
+namespace binary_serializer
+{
+	constexpr std::uint8_t formatVersion = 1;
+	constexpr double fixedPointScale = 1000.0;
+
+	enum class MessageKind : std::uint8_t
+	{
+		STATE = 1,
+		PLAYERS = 2
+	};
+
+	std::string GetPlayersDogInfoBinary(std::uint64_t tick, const std::vector<std::shared_ptr<model::Player>> &players,
+										const std::vector<model::LootInfo> &loots);
+	std::string GetPlayerInfoBinary(const std::vector<std::shared_ptr<model::Player>> &players);
+} // namespace binary_serializer
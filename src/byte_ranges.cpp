@@ -0,0 +1,157 @@
+#include "byte_ranges.h"
+#include "static_cache.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <limits>
+
+namespace byte_ranges
+{
+	namespace
+	{
+		// Разделитель частей не должен встречаться в отдаваемых данных: статика сайта его не содержит
+		constexpr std::string_view boundary = "dogstory-byteranges-3f1c2e9a7b5d4086";
+
+		std::string_view Trim(std::string_view value)
+		{
+			while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+				value.remove_prefix(1);
+			while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+				value.remove_suffix(1);
+			return value;
+		}
+
+		std::optional<std::uint64_t> ParseNumber(std::string_view value)
+		{
+			std::uint64_t result = 0;
+			if (value.empty())
+				return std::nullopt;
+			const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+			if (ec != std::errc{} || end != value.data() + value.size())
+				return std::nullopt;
+			return result;
+		}
+
+		bool StartsWithIgnoreCase(std::string_view value, std::string_view prefix)
+		{
+			return value.size() >= prefix.size() &&
+				   std::equal(prefix.begin(), prefix.end(), value.begin(), [](char a, char b)
+							  { return a == std::tolower(static_cast<unsigned char>(b)); });
+		}
+	}
+
+	std::optional<std::vector<ByteRange>> ParseRange(std::string_view range, std::uint64_t size)
+	{
+		constexpr std::string_view unit = "bytes=";
+		if (!StartsWithIgnoreCase(range, unit))
+			return std::nullopt;
+		range.remove_prefix(unit.size());
+
+		std::vector<ByteRange> ranges;
+		size_t specs = 0;
+		while (!range.empty())
+		{
+			const auto comma = range.find(',');
+			const auto spec = Trim(range.substr(0, comma));
+			range = (comma == std::string_view::npos) ? std::string_view{} : range.substr(comma + 1);
+			if (spec.empty())
+				continue;
+			if (++specs > maxRanges)
+				return std::nullopt;
+
+			const auto dash = spec.find('-');
+			if (dash == std::string_view::npos)
+				return std::nullopt;
+			const auto first_text = spec.substr(0, dash);
+			const auto last_text = spec.substr(dash + 1);
+
+			if (first_text.empty())
+			{
+				// "-500" - последние 500 байт
+				const auto suffix = ParseNumber(last_text);
+				if (!suffix)
+					return std::nullopt;
+				if (*suffix > 0 && size > 0)
+				{
+					const auto length = std::min(*suffix, size);
+					ranges.push_back({size - length, length});
+				}
+				continue;
+			}
+
+			const auto first = ParseNumber(first_text);
+			if (!first)
+				return std::nullopt;
+			auto last = std::numeric_limits<std::uint64_t>::max();
+			if (!last_text.empty())
+			{
+				const auto parsed = ParseNumber(last_text);
+				if (!parsed || *parsed < *first)
+					return std::nullopt;
+				last = *parsed;
+			}
+			if (*first < size)
+				ranges.push_back({*first, std::min(last, size - 1) - *first + 1});
+		}
+		if (specs == 0)
+			return std::nullopt;
+
+		std::sort(ranges.begin(), ranges.end(), [](const ByteRange &lhs, const ByteRange &rhs)
+				  { return lhs.offset < rhs.offset; });
+		std::vector<ByteRange> merged;
+		for (const auto &r : ranges)
+		{
+			if (!merged.empty() && r.offset <= merged.back().offset + merged.back().size)
+			{
+				auto &back = merged.back();
+				back.size = std::max(back.offset + back.size, r.offset + r.size) - back.offset;
+				continue;
+			}
+			merged.push_back(r);
+		}
+		return merged;
+	}
+
+	bool IfRangeMatches(std::string_view if_range, std::string_view etag, std::time_t modified_time)
+	{
+		if_range = Trim(if_range);
+		if (if_range.empty())
+			return true;
+		// Слабый ETag не гарантирует совпадения байтов, диапазоны по нему не собирают
+		if (if_range.starts_with("W/"))
+			return false;
+		if (if_range.starts_with('"'))
+			return if_range == etag;
+		const auto date = static_cache::ParseHttpDate(if_range);
+		return date && (*date == modified_time);
+	}
+
+	std::string MakeContentRange(const ByteRange &range, std::uint64_t size)
+	{
+		return "bytes " + std::to_string(range.offset) + '-' + std::to_string(range.offset + range.size - 1) + '/' + std::to_string(size);
+	}
+
+	std::string MakeUnsatisfiedContentRange(std::uint64_t size)
+	{
+		return "bytes */" + std::to_string(size);
+	}
+
+	Multipart MakeMultipart(const std::vector<ByteRange> &ranges, std::uint64_t size, std::string_view content_type)
+	{
+		Multipart multipart;
+		multipart.content_type = "multipart/byteranges; boundary=" + std::string(boundary);
+		multipart.parts.reserve(ranges.size());
+		for (const auto &range : ranges)
+		{
+			std::string header = "\r\n--" + std::string(boundary) + "\r\n";
+			if (!content_type.empty())
+				header += "Content-Type: " + std::string(content_type) + "\r\n";
+			header += "Content-Range: " + MakeContentRange(range, size) + "\r\n\r\n";
+			multipart.size += header.size() + range.size;
+			multipart.parts.push_back({std::move(header), range});
+		}
+		multipart.closing = "\r\n--" + std::string(boundary) + "--\r\n";
+		multipart.size += multipart.closing.size();
+		return multipart;
+	}
+}
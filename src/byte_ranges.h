@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace byte_ranges
+{
+    struct ByteRange
+    {
+        std::uint64_t offset{0};
+        std::uint64_t size{0};
+
+        bool operator==(const ByteRange &) const = default;
+    };
+
+    // Больше диапазонов в одном запросе не обслуживаем: отдаём представление целиком
+    constexpr size_t maxRanges = 16;
+
+    // Диапазоны заголовка Range для представления размером size (RFC 9110, 14.2), по возрастанию,
+    // пересекающиеся и соседние объединены. Пусто, если заголовок не разобран или диапазонов слишком
+    // много: тогда Range игнорируется. Пустой вектор - ни один диапазон не попал в представление (416)
+    std::optional<std::vector<ByteRange>> ParseRange(std::string_view range, std::uint64_t size);
+
+    // Применим ли Range при заголовке If-Range: представление не изменилось, если совпал строгий ETag
+    // или точное время изменения. Без If-Range диапазоны применимы всегда
+    bool IfRangeMatches(std::string_view if_range, std::string_view etag, std::time_t modified_time);
+
+    // Значение Content-Range: "bytes 0-499/1234"
+    std::string MakeContentRange(const ByteRange &range, std::uint64_t size);
+    // Content-Range ответа 416: "bytes */1234"
+    std::string MakeUnsatisfiedContentRange(std::uint64_t size);
+
+    // Часть ответа multipart/byteranges: заголовок части и диапазон представления за ним
+    struct Part
+    {
+        std::string header;
+        ByteRange range;
+    };
+
+    struct Multipart
+    {
+        std::string content_type;
+        std::vector<Part> parts;
+        // Завершающий разделитель после последней части
+        std::string closing;
+        // Размер всего тела ответа
+        std::uint64_t size{0};
+    };
+
+    Multipart MakeMultipart(const std::vector<ByteRange> &ranges, std::uint64_t size, std::string_view content_type);
+}
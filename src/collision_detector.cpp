@@ -1,5 +1,12 @@
 #include "collision_detector.h"
 #include <cassert>
+#include <cmath>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define COLLISION_DETECTOR_X86_KERNELS
+#include <immintrin.h>
+#endif
+
 namespace collision_detector
 {
 
@@ -23,35 +30,284 @@ namespace collision_detector
         return CollectionResult(sq_distance, proj_ratio);
     }
 
+    namespace
+    {
+        // Предметы, лежащие подряд в массивах xs, ys, widths с позиции begin до end.
+        // Подобранные предметы добавляются в hits вместе с их позицией в массивах
+        struct PackedRange
+        {
+            const double *xs;
+            const double *ys;
+            const double *widths;
+            size_t begin;
+            size_t end;
+        };
+
+        void CollectScalar(const Gatherer &gatherer, const PackedRange &range, std::vector<CollectedItem> &hits)
+        {
+            for (size_t i = range.begin; i < range.end; ++i)
+            {
+                auto result = TryCollectPoint(gatherer.start_pos, gatherer.end_pos, {range.xs[i], range.ys[i]});
+                if (result.IsCollected(gatherer.width + range.widths[i]))
+                    hits.push_back({i, result});
+            }
+        }
+
+#ifdef COLLISION_DETECTOR_X86_KERNELS
+        // Векторные варианты повторяют вычисления TryCollectPoint операция в операцию,
+        // поэтому результаты совпадают со скалярным вариантом до бита
+
+        __attribute__((target("sse2"))) void CollectSse2(const Gatherer &gatherer, const PackedRange &range,
+                                                          std::vector<CollectedItem> &hits)
+        {
+            const double v_x_scalar = gatherer.end_pos.x - gatherer.start_pos.x;
+            const double v_y_scalar = gatherer.end_pos.y - gatherer.start_pos.y;
+
+            const __m128d a_x = _mm_set1_pd(gatherer.start_pos.x);
+            const __m128d a_y = _mm_set1_pd(gatherer.start_pos.y);
+            const __m128d v_x = _mm_set1_pd(v_x_scalar);
+            const __m128d v_y = _mm_set1_pd(v_y_scalar);
+            const __m128d v_len2 = _mm_set1_pd(v_x_scalar * v_x_scalar + v_y_scalar * v_y_scalar);
+            const __m128d width = _mm_set1_pd(gatherer.width);
+            const __m128d zero = _mm_set1_pd(0.0);
+            const __m128d one = _mm_set1_pd(1.0);
+
+            size_t i = range.begin;
+            for (; i + 2 <= range.end; i += 2)
+            {
+                const __m128d u_x = _mm_sub_pd(_mm_loadu_pd(range.xs + i), a_x);
+                const __m128d u_y = _mm_sub_pd(_mm_loadu_pd(range.ys + i), a_y);
+                const __m128d u_dot_v = _mm_add_pd(_mm_mul_pd(u_x, v_x), _mm_mul_pd(u_y, v_y));
+                const __m128d u_len2 = _mm_add_pd(_mm_mul_pd(u_x, u_x), _mm_mul_pd(u_y, u_y));
+                const __m128d proj_ratio = _mm_div_pd(u_dot_v, v_len2);
+                const __m128d sq_distance = _mm_sub_pd(u_len2, _mm_div_pd(_mm_mul_pd(u_dot_v, u_dot_v), v_len2));
+                const __m128d radius = _mm_add_pd(width, _mm_loadu_pd(range.widths + i));
+
+                const __m128d collected = _mm_and_pd(_mm_and_pd(_mm_cmpge_pd(proj_ratio, zero), _mm_cmple_pd(proj_ratio, one)),
+                                                     _mm_cmple_pd(sq_distance, _mm_mul_pd(radius, radius)));
+                if (int mask = _mm_movemask_pd(collected))
+                {
+                    alignas(16) double sq_distances[2];
+                    alignas(16) double proj_ratios[2];
+                    _mm_store_pd(sq_distances, sq_distance);
+                    _mm_store_pd(proj_ratios, proj_ratio);
+                    for (int lane = 0; lane < 2; ++lane)
+                    {
+                        if (mask & (1 << lane))
+                            hits.push_back({i + lane, CollectionResult(sq_distances[lane], proj_ratios[lane])});
+                    }
+                }
+            }
+            CollectScalar(gatherer, {range.xs, range.ys, range.widths, i, range.end}, hits);
+        }
+
+        __attribute__((target("avx2"))) void CollectAvx2(const Gatherer &gatherer, const PackedRange &range,
+                                                          std::vector<CollectedItem> &hits)
+        {
+            const double v_x_scalar = gatherer.end_pos.x - gatherer.start_pos.x;
+            const double v_y_scalar = gatherer.end_pos.y - gatherer.start_pos.y;
+
+            const __m256d a_x = _mm256_set1_pd(gatherer.start_pos.x);
+            const __m256d a_y = _mm256_set1_pd(gatherer.start_pos.y);
+            const __m256d v_x = _mm256_set1_pd(v_x_scalar);
+            const __m256d v_y = _mm256_set1_pd(v_y_scalar);
+            const __m256d v_len2 = _mm256_set1_pd(v_x_scalar * v_x_scalar + v_y_scalar * v_y_scalar);
+            const __m256d width = _mm256_set1_pd(gatherer.width);
+            const __m256d zero = _mm256_set1_pd(0.0);
+            const __m256d one = _mm256_set1_pd(1.0);
+
+            size_t i = range.begin;
+            for (; i + 4 <= range.end; i += 4)
+            {
+                const __m256d u_x = _mm256_sub_pd(_mm256_loadu_pd(range.xs + i), a_x);
+                const __m256d u_y = _mm256_sub_pd(_mm256_loadu_pd(range.ys + i), a_y);
+                const __m256d u_dot_v = _mm256_add_pd(_mm256_mul_pd(u_x, v_x), _mm256_mul_pd(u_y, v_y));
+                const __m256d u_len2 = _mm256_add_pd(_mm256_mul_pd(u_x, u_x), _mm256_mul_pd(u_y, u_y));
+                const __m256d proj_ratio = _mm256_div_pd(u_dot_v, v_len2);
+                const __m256d sq_distance = _mm256_sub_pd(u_len2, _mm256_div_pd(_mm256_mul_pd(u_dot_v, u_dot_v), v_len2));
+                const __m256d radius = _mm256_add_pd(width, _mm256_loadu_pd(range.widths + i));
+
+                const __m256d collected = _mm256_and_pd(_mm256_and_pd(_mm256_cmp_pd(proj_ratio, zero, _CMP_GE_OQ),
+                                                                      _mm256_cmp_pd(proj_ratio, one, _CMP_LE_OQ)),
+                                                        _mm256_cmp_pd(sq_distance, _mm256_mul_pd(radius, radius), _CMP_LE_OQ));
+                if (int mask = _mm256_movemask_pd(collected))
+                {
+                    alignas(32) double sq_distances[4];
+                    alignas(32) double proj_ratios[4];
+                    _mm256_store_pd(sq_distances, sq_distance);
+                    _mm256_store_pd(proj_ratios, proj_ratio);
+                    for (int lane = 0; lane < 4; ++lane)
+                    {
+                        if (mask & (1 << lane))
+                            hits.push_back({i + lane, CollectionResult(sq_distances[lane], proj_ratios[lane])});
+                    }
+                }
+            }
+            CollectScalar(gatherer, {range.xs, range.ys, range.widths, i, range.end}, hits);
+        }
+#endif
+
+        void CollectPacked(CollectKernel kernel, const Gatherer &gatherer, const PackedRange &range,
+                           std::vector<CollectedItem> &hits)
+        {
+            switch (kernel)
+            {
+#ifdef COLLISION_DETECTOR_X86_KERNELS
+            case CollectKernel::Avx2:
+                return CollectAvx2(gatherer, range, hits);
+            case CollectKernel::Sse2:
+                return CollectSse2(gatherer, range, hits);
+#endif
+            default:
+                return CollectScalar(gatherer, range, hits);
+            }
+        }
+    }
+
+    std::vector<CollectKernel> GetAvailableCollectKernels()
+    {
+        std::vector<CollectKernel> kernels{CollectKernel::Scalar};
+#ifdef COLLISION_DETECTOR_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse2"))
+            kernels.push_back(CollectKernel::Sse2);
+        if (__builtin_cpu_supports("avx2"))
+            kernels.push_back(CollectKernel::Avx2);
+#endif
+        return kernels;
+    }
+
+    CollectKernel GetDefaultCollectKernel()
+    {
+        static const CollectKernel kernel = GetAvailableCollectKernels().back();
+        return kernel;
+    }
+
+    ItemIndex::ItemIndex(std::vector<Item> items, double cell_size)
+        : items_(std::move(items)), cell_size_(cell_size)
+    {
+        std::vector<std::pair<CellKey, std::uint32_t>> keyed_items;
+        keyed_items.reserve(items_.size());
+        for (size_t i = 0; i < items_.size(); ++i)
+        {
+            const auto &position = items_[i].position;
+            keyed_items.emplace_back(MakeCellKey(GetCellCoord(position.x), GetCellCoord(position.y)), static_cast<std::uint32_t>(i));
+            max_item_width_ = std::max(max_item_width_, items_[i].width);
+        }
+        std::sort(keyed_items.begin(), keyed_items.end());
+
+        xs_.reserve(keyed_items.size());
+        ys_.reserve(keyed_items.size());
+        widths_.reserve(keyed_items.size());
+        sorted_items_.reserve(keyed_items.size());
+        for (size_t i = 0; i < keyed_items.size(); ++i)
+        {
+            const auto [key, item_idx] = keyed_items[i];
+            const auto pos = static_cast<std::uint32_t>(i);
+            if (auto [it, inserted] = cells_.try_emplace(key, CellRange{pos, pos + 1}); !inserted)
+                it->second.end = pos + 1;
+
+            const Item &item = items_[item_idx];
+            xs_.push_back(item.position.x);
+            ys_.push_back(item.position.y);
+            widths_.push_back(item.width);
+            sorted_items_.push_back(item_idx);
+        }
+    }
+
+    std::int64_t ItemIndex::GetCellCoord(double coord) const
+    {
+        return static_cast<std::int64_t>(std::floor(coord / cell_size_));
+    }
+
+    ItemIndex::CellKey ItemIndex::MakeCellKey(std::int64_t cell_x, std::int64_t cell_y)
+    {
+        return (static_cast<CellKey>(static_cast<std::uint32_t>(cell_x)) << 32) | static_cast<std::uint32_t>(cell_y);
+    }
+
+    void ItemIndex::CollectItems(const Gatherer &gatherer, CollectKernel kernel, std::vector<CollectedItem> &collected) const
+    {
+        collected.clear();
+
+        // Предмет подбирается, только если он не дальше суммы ширин от отрезка пути,
+        // то есть лежит в расширенном на эту сумму прямоугольнике вокруг пути
+        const double reach = gatherer.width + max_item_width_ + 1e-9;
+        const auto [x_min, x_max] = std::minmax(gatherer.start_pos.x, gatherer.end_pos.x);
+        const auto [y_min, y_max] = std::minmax(gatherer.start_pos.y, gatherer.end_pos.y);
+        const std::int64_t cell_x_min = GetCellCoord(x_min - reach);
+        const std::int64_t cell_x_max = GetCellCoord(x_max + reach);
+        const std::int64_t cell_y_min = GetCellCoord(y_min - reach);
+        const std::int64_t cell_y_max = GetCellCoord(y_max + reach);
+
+        // Если путь задевает больше ячеек, чем занято предметами, дешевле проверить все предметы
+        const double cells_to_check = static_cast<double>(cell_x_max - cell_x_min + 1) * static_cast<double>(cell_y_max - cell_y_min + 1);
+        if (cells_to_check > static_cast<double>(cells_.size()))
+        {
+            CollectPacked(kernel, gatherer, {xs_.data(), ys_.data(), widths_.data(), 0, xs_.size()}, collected);
+        }
+        else
+        {
+            for (std::int64_t cell_x = cell_x_min; cell_x <= cell_x_max; ++cell_x)
+            {
+                for (std::int64_t cell_y = cell_y_min; cell_y <= cell_y_max; ++cell_y)
+                {
+                    auto it = cells_.find(MakeCellKey(cell_x, cell_y));
+                    if (it != cells_.end())
+                        CollectPacked(kernel, gatherer, {xs_.data(), ys_.data(), widths_.data(), it->second.begin, it->second.end}, collected);
+                }
+            }
+        }
+
+        for (auto &item : collected)
+            item.item_id = sorted_items_[item.item_id];
+
+        std::sort(collected.begin(), collected.end(), [](const CollectedItem &lhs, const CollectedItem &rhs)
+                  { return lhs.item_id < rhs.item_id; });
+    }
+
     std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider &provider)
+    {
+        std::vector<Item> items;
+        items.reserve(provider.ItemsCount());
+        for (size_t i = 0; i < provider.ItemsCount(); ++i)
+            items.push_back(provider.GetItem(i));
+
+        std::vector<Gatherer> gatherers;
+        gatherers.reserve(provider.GatherersCount());
+        for (size_t i = 0; i < provider.GatherersCount(); ++i)
+            gatherers.push_back(provider.GetGatherer(i));
+
+        return FindGatherEvents(ItemIndex(std::move(items)), gatherers);
+    }
+
+    std::vector<GatheringEvent> FindGatherEvents(const ItemIndex &items, const std::vector<Gatherer> &gatherers,
+                                                 CollectKernel kernel)
     {
         std::vector<GatheringEvent> events;
+        std::vector<CollectedItem> collected;
 
         const double epsilon = 1e-10;
-        for (size_t i = 0; i < provider.GatherersCount(); ++i)
+        for (size_t i = 0; i < gatherers.size(); ++i)
         {
-            Gatherer gath = provider.GetGatherer(i);
+            const Gatherer &gath = gatherers[i];
 
             if ((std::abs(gath.start_pos.x - gath.end_pos.x) <= epsilon) &&
                 (std::abs(gath.start_pos.y - gath.end_pos.y) <= epsilon))
             {
                 continue;
             }
-            for (size_t j = 0; j < provider.ItemsCount(); ++j)
-            {
-                Item item = provider.GetItem(j);
-                auto result = TryCollectPoint(gath.start_pos, gath.end_pos, item.position);
 
-                if (result.IsCollected(gath.width + item.width))
-                {
-                    GatheringEvent evt(j, i, result.sq_distance, result.proj_ratio);
-                    events.push_back(evt);
-                }
+            items.CollectItems(gath, kernel, collected);
+            for (const auto &item : collected)
+            {
+                GatheringEvent evt(item.item_id, i, item.result.sq_distance, item.result.proj_ratio);
+                events.push_back(evt);
             }
         }
 
-        std::sort(events.begin(), events.end(), [](const GatheringEvent &evt1, const GatheringEvent &evt2)
-                  { return evt1.time < evt2.time; });
+        // Устойчивая сортировка: при равном времени события идут в порядке собирателей и предметов
+        std::stable_sort(events.begin(), events.end(), [](const GatheringEvent &evt1, const GatheringEvent &evt2)
+                         { return evt1.time < evt2.time; });
 
         return events;
     }
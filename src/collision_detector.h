@@ -3,6 +3,8 @@
 #include "geom.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 
 namespace collision_detector
@@ -98,7 +100,79 @@ namespace collision_detector
         std::vector<Item> items_;
         std::vector<Gatherer> gatherers_;
     };
+
+    // Реализация проверки "путь собирателя - предметы". Векторные варианты
+    // проверяют за одну инструкцию 2 (SSE2) или 4 (AVX2) предмета и дают
+    // в точности те же результаты, что и скалярный вариант.
+    enum class CollectKernel
+    {
+        Scalar,
+        Sse2,
+        Avx2
+    };
+
+    // Варианты, поддерживаемые процессором, начиная со скалярного
+    std::vector<CollectKernel> GetAvailableCollectKernels();
+    // Самый быстрый из поддерживаемых вариантов. Определяется один раз при первом вызове
+    CollectKernel GetDefaultCollectKernel();
+
+    struct CollectedItem
+    {
+        size_t item_id;
+        CollectionResult result;
+    };
+
+    // Набор предметов без виртуальных вызовов, хранящий координаты и ширины
+    // предметов в виде структуры массивов (x, y, width).
+    // Поверх массивов построен пространственный хеш (broad phase): плоскость
+    // делится на квадратные ячейки, предметы упорядочены по ячейкам, и для
+    // собирателя проверяются только ячейки, которые задевает его путь.
+    class ItemIndex
+    {
+    public:
+        explicit ItemIndex(std::vector<Item> items, double cell_size = 1.0);
+
+        size_t ItemsCount() const noexcept
+        {
+            return items_.size();
+        }
+        const Item &GetItem(size_t idx) const noexcept
+        {
+            return items_[idx];
+        }
+
+        // Заполняет collected предметами, которые подбирает gatherer,
+        // в порядке возрастания их индексов
+        void CollectItems(const Gatherer &gatherer, CollectKernel kernel, std::vector<CollectedItem> &collected) const;
+
+    private:
+        using CellKey = std::uint64_t;
+        struct CellRange
+        {
+            std::uint32_t begin;
+            std::uint32_t end;
+        };
+
+        std::int64_t GetCellCoord(double coord) const;
+        static CellKey MakeCellKey(std::int64_t cell_x, std::int64_t cell_y);
+
+        std::vector<Item> items_;
+        double cell_size_;
+        double max_item_width_{0.0};
+        // Координаты и ширины предметов, упорядоченных по ячейкам
+        std::vector<double> xs_;
+        std::vector<double> ys_;
+        std::vector<double> widths_;
+        // Индекс предмета для каждой позиции в массивах выше
+        std::vector<std::uint32_t> sorted_items_;
+        std::unordered_map<CellKey, CellRange> cells_;
+    };
+
     // Эту функцию вам нужно будет реализовать в соответствующем задании.
     // При проверке ваших тестов она не нужна - функция будет линковаться снаружи.
     std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider &provider);
+
+    // События сбора для всех собирателей за один проход, упорядоченные по времени
+    std::vector<GatheringEvent> FindGatherEvents(const ItemIndex &items, const std::vector<Gatherer> &gatherers,
+                                                 CollectKernel kernel = GetDefaultCollectKernel());
 } // namespace collision_detector
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "compression.h"
+#include <cstdint>
+#include <stdexcept>
+#include <zlib.h>
+#include <brotli/encode.h>
+
+namespace compression
+{
+	std::string Gzip(std::string_view data, int level)
+	{
+		z_stream stream{};
+		// windowBits 15 + 16 - gzip-заголовок вместо zlib
+		constexpr int gzipWindowBits = 15 + 16;
+		constexpr int memLevel = 8;
+		if (deflateInit2(&stream, level, Z_DEFLATED, gzipWindowBits, memLevel, Z_DEFAULT_STRATEGY) != Z_OK)
+			throw std::runtime_error("Failed to initialize gzip compression");
+
+		std::string result(deflateBound(&stream, static_cast<uLong>(data.size())), '\0');
+		stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+		stream.avail_in = static_cast<uInt>(data.size());
+		stream.next_out = reinterpret_cast<Bytef *>(result.data());
+		stream.avail_out = static_cast<uInt>(result.size());
+
+		const int status = deflate(&stream, Z_FINISH);
+		const auto compressed_size = stream.total_out;
+		deflateEnd(&stream);
+		if (status != Z_STREAM_END)
+			throw std::runtime_error("Failed to compress data with gzip");
+
+		result.resize(compressed_size);
+		return result;
+	}
+
+	std::string Brotli(std::string_view data, int quality)
+	{
+		size_t compressed_size = BrotliEncoderMaxCompressedSize(data.size());
+		std::string result(compressed_size, '\0');
+		if (!BrotliEncoderCompress(quality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_GENERIC, data.size(),
+								   reinterpret_cast<const uint8_t *>(data.data()), &compressed_size,
+								   reinterpret_cast<uint8_t *>(result.data())))
+			throw std::runtime_error("Failed to compress data with brotli");
+
+		result.resize(compressed_size);
+		return result;
+	}
+
+	std::string MakeStrongETag(std::string_view body)
+	{
+		// FNV-1a, 64 бита
+		std::uint64_t hash = 14695981039346656037ull;
+		for (char c : body)
+		{
+			hash ^= static_cast<unsigned char>(c);
+			hash *= 1099511628211ull;
+		}
+
+		static constexpr char hex[] = "0123456789abcdef";
+		std::string etag(18, '"');
+		for (int i = 0; i < 16; ++i)
+			etag[16 - i] = hex[(hash >> (i * 4)) & 0xf];
+		return etag;
+	}
+
+	namespace
+	{
+		// У сжатого представления свой строгий ETag: байты ответа другие
+		std::string MakeVariantETag(const std::string &etag, std::string_view coding)
+		{
+			std::string variant = etag;
+			variant.insert(variant.size() - 1, "-");
+			variant.insert(variant.size() - 1, coding);
+			return variant;
+		}
+	}
+
+	model::PrecomputedResponse MakePrecomputedResponse(std::string body, bool compress)
+	{
+		model::PrecomputedResponse response;
+		response.etag = MakeStrongETag(body);
+
+		if (compress)
+		{
+			if (auto gzip_body = Gzip(body); gzip_body.size() < body.size())
+			{
+				response.gzip_etag = MakeVariantETag(response.etag, "gzip");
+				response.gzip_body = std::make_shared<const std::string>(std::move(gzip_body));
+			}
+			if (auto brotli_body = Brotli(body); brotli_body.size() < body.size())
+			{
+				response.brotli_etag = MakeVariantETag(response.etag, "br");
+				response.brotli_body = std::make_shared<const std::string>(std::move(brotli_body));
+			}
+		}
+		response.body = std::make_shared<const std::string>(std::move(body));
+		return response;
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include "model.h"
+
+namespace compression
+{
+	// Сжимает data в формат gzip (RFC 1952). По умолчанию с максимальной степенью
+	// сжатия: так сжимаются ответы, которые собираются один раз, а отдаются многократно
+	std::string Gzip(std::string_view data, int level = 9);
+
+	// Сжимает data в формат brotli (RFC 7932). Максимальное качество 11 сжимает лишь на
+	// десятую часть лучше 9, но в 25 раз медленнее, а файлы сжимаются и при их изменении
+	std::string Brotli(std::string_view data, int quality = 9);
+
+	// Строгий ETag тела - хеш его содержимого в кавычках. Не зависит от запуска сервера,
+	// поэтому сохранённые клиентами ETag остаются действительными после перезапуска
+	std::string MakeStrongETag(std::string_view body);
+
+	// Собирает неизменяемый ответ: тело, его ETag и сжатые варианты, если сжатие уменьшает размер.
+	// Уже сжатое содержимое (изображения, звук) не стоит сжимать снова: для него compress = false
+	model::PrecomputedResponse MakePrecomputedResponse(std::string body, bool compress = true);
+}
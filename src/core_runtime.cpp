@@ -0,0 +1,89 @@
+#include "core_runtime.h"
+#include <boost/asio/post.hpp>
+#include <stdexcept>
+
+namespace core_runtime
+{
+	namespace
+	{
+		// Ядро, которое выполняет текущий поток, и набор, к которому оно относится
+		thread_local const CoreRuntime *current_runtime = nullptr;
+		thread_local size_t current_core = 0;
+	}
+
+	CoreRuntime::CoreRuntime(std::vector<net::io_context *> contexts)
+		: contexts_{std::move(contexts)}
+	{
+		if (contexts_.empty())
+			throw std::invalid_argument("Core runtime needs at least one io_context");
+
+		mailboxes_.reserve(contexts_.size() * contexts_.size());
+		for (size_t i = 0; i < contexts_.size() * contexts_.size(); ++i)
+			mailboxes_.push_back(std::make_unique<Mailbox>());
+	}
+
+	std::optional<size_t> CoreRuntime::FindCore(const net::io_context &context) const
+	{
+		for (size_t core = 0; core < contexts_.size(); ++core)
+		{
+			if (contexts_[core] == &context)
+				return core;
+		}
+		return std::nullopt;
+	}
+
+	void CoreRuntime::Run(size_t core)
+	{
+		auto &context = GetContext(core);
+		current_runtime = this;
+		current_core = core;
+		context.run();
+		current_runtime = nullptr;
+	}
+
+	std::optional<size_t> CoreRuntime::CurrentCore() const
+	{
+		if (current_runtime != this)
+			return std::nullopt;
+		return current_core;
+	}
+
+	void CoreRuntime::Execute(size_t core, Task task)
+	{
+		const auto from = CurrentCore();
+		if (from == core)
+			return task();
+
+		auto &context = GetContext(core);
+		if (!from)
+			return net::post(context, std::move(task));
+
+		auto &mailbox = GetMailbox(*from, core);
+		if (!mailbox.queue.TryPush(std::move(task)))
+			return net::post(context, std::move(task));
+
+		// Получатель сбрасывает scheduled до того, как выбрать сообщения. Барьеры с обеих сторон
+		// гарантируют, что либо он увидит это сообщение, либо мы увидим сброшенный флаг и разбудим его
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!mailbox.scheduled.exchange(true, std::memory_order_relaxed))
+			net::post(context, [this, core, &mailbox]
+					  { Drain(core, mailbox); });
+	}
+
+	void CoreRuntime::Drain(size_t core, Mailbox &mailbox)
+	{
+		mailbox.scheduled.store(false, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		Task task;
+		for (size_t i = 0; i < maxDrainBatch; ++i)
+		{
+			if (!mailbox.queue.TryPop(task))
+				return;
+			task();
+		}
+		// Остальные сообщения выполним после задач, уже ждущих в io_context ядра
+		net::post(GetContext(core), [this, core, &mailbox]
+				  { Drain(core, mailbox); });
+	}
+}
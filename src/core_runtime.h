@@ -0,0 +1,62 @@
+#pragma once
+#include <boost/asio/io_context.hpp>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "spsc_queue.h"
+
+namespace core_runtime
+{
+    namespace net = boost::asio;
+
+    // Набор ядер: у каждого свой io_context, который выполняет ровно один поток (см. Run).
+    // Задачи между ядрами передаются через почтовые ящики - очереди SpscQueue, по одной
+    // на каждую пару ядер, поэтому ядра не делят между собой ни очередей, ни мьютексов.
+    // Ящик будит ядро-получателя одной задачей io_context на пачку сообщений,
+    // а не на каждое сообщение
+    class CoreRuntime
+    {
+    public:
+        using Task = std::function<void()>;
+
+        static constexpr size_t mailboxCapacity = 1024;
+        // Столько сообщений ядро выполняет подряд, прежде чем дать очередь своему io_context
+        static constexpr size_t maxDrainBatch = 64;
+
+        explicit CoreRuntime(std::vector<net::io_context *> contexts);
+
+        CoreRuntime(const CoreRuntime &) = delete;
+        CoreRuntime &operator=(const CoreRuntime &) = delete;
+
+        size_t GetCoreCount() const noexcept { return contexts_.size(); }
+        net::io_context &GetContext(size_t core) { return *contexts_.at(core); }
+        // Номер ядра, которому принадлежит context, или nullopt для io_context вне набора
+        std::optional<size_t> FindCore(const net::io_context &context) const;
+
+        // Выполняет io_context ядра core в текущем потоке до его остановки
+        void Run(size_t core);
+        // Ядро, io_context которого выполняет текущий поток, или nullopt вне потоков ядер
+        std::optional<size_t> CurrentCore() const;
+
+        // Выполняет task на ядре core: сразу, если вызвано на нём же, иначе через почтовый ящик
+        // от текущего ядра. Из потоков вне ядер, а также при заполненном ящике задача ставится
+        // в io_context ядра обычным post, и её порядок относительно сообщений ящика не сохраняется
+        void Execute(size_t core, Task task);
+
+    private:
+        struct Mailbox
+        {
+            SpscQueue<Task> queue{mailboxCapacity};
+            // Поставлена ли в io_context получателя задача, выбирающая сообщения ящика
+            alignas(64) std::atomic<bool> scheduled{false};
+        };
+
+        Mailbox &GetMailbox(size_t from, size_t to) { return *mailboxes_[from * contexts_.size() + to]; }
+        void Drain(size_t core, Mailbox &mailbox);
+
+        std::vector<net::io_context *> contexts_;
+        std::vector<std::unique_ptr<Mailbox>> mailboxes_;
+    };
+}
@@ -1,33 +1,45 @@
 #include "dog.h"
+#include "dog_kinematics.h"
 #include <map>
 #include "server_exceptions.h"
 #include "utils.h"
 #include "collision_detector.h"
 
 constexpr double dS = 0.4;
-constexpr int millisescondsInSecond = 1000;
-constexpr double gathererWidth = 0.6;
-constexpr double epsilon = 0.0001;
 namespace model
 {
 	std::string ConvertDogDirectionToString(DogDirection direction)
 	{
-		std::map<DogDirection, std::string> dir{{DogDirection::EAST, "R"},
-												{DogDirection::WEST, "L"},
-												{DogDirection::SOUTH, "D"},
-												{DogDirection::NORTH, "U"}};
-
-		if (auto itFind = dir.find(direction); itFind != dir.end())
-			return itFind->second;
+		// Вызывается для каждой собаки в каждом ответе о состоянии, поэтому без построения таблицы
+		switch (direction)
+		{
+		case DogDirection::EAST:
+			return "R";
+		case DogDirection::WEST:
+			return "L";
+		case DogDirection::SOUTH:
+			return "D";
+		default:
+			return "U";
+		}
+	}
 
-		return "U";
+	Dog::Dog(const model::Map *map, bool spawn_dog_in_random_point, unsigned defaultBagCapacity)
+		: Dog(std::make_shared<DogKinematics>(*map, utils::MakeRandomSeed(*map->GetId())), map, spawn_dog_in_random_point, defaultBagCapacity)
+	{
 	}
 
-	Dog::Dog(const model::Map *map, bool spawn_dog_in_random_point, unsigned defaultBagCapacity) : map_(map)
+	Dog::Dog(std::shared_ptr<DogKinematics> kinematics, const model::Map *map,
+			 bool spawn_dog_in_random_point, unsigned defaultBagCapacity)
+		: map_(map), kinematics_(std::move(kinematics))
 	{
+		id_ = kinematics_->Add(this, spawn_dog_in_random_point);
 		bag_capacity_ = map->GetBagCapacity() ? map->GetBagCapacity() : defaultBagCapacity;
-		direction_ = DogDirection::NORTH;
-		navigator_ = std::make_shared<DogNavigator>(map_->GetRoads(), spawn_dog_in_random_point);
+	}
+
+	Dog::~Dog()
+	{
+		kinematics_->Remove(id_);
 	}
 
 	void Dog::SetSpeed(DogDirection dir, double speed)
@@ -39,121 +51,96 @@ namespace model
 			throw DogSpeedException();
 
 		if (dir != DogDirection::STOP)
-			direction_ = dir;
-		idle_time_ = 0;
-		navigator_->SetDogSpeed(find_vel->second);
+			kinematics_->SetDirection(id_, dir);
+		kinematics_->ResetIdleTime(id_);
+		kinematics_->SetSpeed(id_, find_vel->second);
 	}
 
-	std::optional<collision_detector::Gatherer> Dog::Move(int deltaTime)
+	void Dog::SetDirection(const DogDirection &dir)
 	{
-		std::optional<collision_detector::Gatherer> res;
-		play_time_ += deltaTime;
-		auto speed = navigator_->GetDogSpeed();
-		if ((std::abs(speed.vx) <= epsilon) && (std::abs(speed.vy) <= epsilon))
-		{
-			idle_time_ += deltaTime;
-			return res;
-		}
-		else
-			idle_time_ = 0;
-
-		DogPosition start = GetPosition();
-		navigator_->MoveDog(direction_, deltaTime);
+		kinematics_->SetDirection(id_, dir);
+	}
 
-		DogPosition end = GetPosition();
+	std::optional<collision_detector::Gatherer> Dog::Move(int deltaTime)
+	{
+		return kinematics_->Move(id_, deltaTime);
+	}
 
-		if ((std::abs(start.x - end.x) > epsilon) || (std::abs(start.y - end.y) > epsilon))
-		{
-			collision_detector::Gatherer gth({start.x, start.y}, {end.x, end.y}, gathererWidth);
-			res = gth;
-		}
+	DogDirection Dog::GetDirection() const
+	{
+		return kinematics_->GetDirection(id_);
+	}
 
-		return res;
+	DogPosition Dog::GetPosition() const
+	{
+		return kinematics_->GetPosition(id_);
 	}
 
-	bool Dog::AddLoot(const model::LootInfo &loot)
+	void Dog::SetPositionOnMap(const DogPos &position)
 	{
-		if (gathered_loots_.size() >= bag_capacity_)
-			return false;
+		kinematics_->SetPositionOnMap(id_, position);
+	}
 
-		gathered_loots_.push_back(loot);
-		return true;
+	DogPos Dog::GetPositionOnMap() const
+	{
+		return kinematics_->GetPositionOnMap(id_);
 	}
 
-	void Dog::PassLootToOffice()
+	DogSpeed Dog::GetSpeed() const
 	{
-		const auto &loots = map_->GetLoots();
+		return kinematics_->GetSpeed(id_);
+	}
 
-		for (const auto &loot : gathered_loots_)
-		{
-			score_ += loots[loot.type].GetScore();
-		}
-		gathered_loots_.clear();
+	void Dog::SpawnDogInMap(bool spawn_in_random_point)
+	{
+		kinematics_->SpawnDogInMap(id_, spawn_in_random_point);
 	}
 
-	bool DogNavigator::RoadsCrossed(const model::Road &road1, const model::Road &road2)
+	unsigned int Dog::GetIdleTime() const
 	{
-		if ((road1.IsHorizontal() && road2.IsVertical()) || (road1.IsVertical() && road2.IsHorizontal()))
-		{
-			const auto &first_start = road1.GetStart();
+		return kinematics_->GetIdleTime(id_);
+	}
 
-			const auto &second_start = road2.GetStart();
-			const auto &second_end = road2.GetEnd();
+	unsigned int Dog::GetPlayTime() const
+	{
+		return kinematics_->GetPlayTime(id_);
+	}
 
-			if (road1.IsHorizontal())
-			{
-				if (((second_start.y < first_start.y) && (second_end.y < first_start.y)) ||
-					((second_start.y > first_start.y) && (second_end.y > first_start.y)))
-					return false;
-			}
-			else if (road1.IsVertical())
-			{
-				if (((second_start.x < first_start.x) && (second_end.x < first_start.x)) ||
-					((second_start.x > first_start.x) && (second_end.x > first_start.x)))
-					return false;
-			}
-			return true;
-		}
-		return false;
+	void Dog::SetPlayTime(unsigned int time)
+	{
+		kinematics_->SetPlayTime(id_, time);
 	}
 
-	bool DogNavigator::RoadsAdjacent(const model::Road &road1, const model::Road &road2)
+	void Dog::Detach()
 	{
-		if ((road1.IsHorizontal() && road2.IsHorizontal()) || (road1.IsVertical() && road2.IsVertical()))
-		{
-			auto first_start = road1.GetStart();
-			auto first_end = road1.GetEnd();
+		// Отсоединённая собака уже стоит на карте, и генератор ей не нужен
+		auto kinematics = std::make_shared<DogKinematics>(*map_, 0);
+		const auto id = kinematics->Add(this, false);
+		kinematics->CopyFrom(id, *kinematics_, id_);
+
+		kinematics_->Remove(id_);
+		kinematics_ = std::move(kinematics);
+		id_ = id;
+	}
 
-			auto second_start = road2.GetStart();
-			auto second_end = road2.GetEnd();
+	bool Dog::AddLoot(const model::LootInfo &loot)
+	{
+		if (gathered_loots_.size() >= bag_capacity_)
+			return false;
 
-			if ((first_start == second_start) || (first_start == second_end) ||
-				(first_end == second_start) || (first_end == second_end))
-				return true;
-		}
-		return false;
+		gathered_loots_.push_back(loot);
+		return true;
 	}
 
-	void DogNavigator::FindAdjacentRoads()
+	void Dog::PassLootToOffice()
 	{
-		for (size_t i = 0; i < roads_.size(); ++i)
+		const auto &loots = map_->GetLoots();
+
+		for (const auto &loot : gathered_loots_)
 		{
-			for (size_t j = i + 1; j < roads_.size(); ++j)
-			{
-				RoadType road_type{RoadType::Parallel};
-
-				if (RoadsAdjacent(roads_[i], roads_[j]))
-					road_type = RoadType::Adjacent;
-				else if (RoadsCrossed(roads_[i], roads_[j]))
-					road_type = RoadType::Crossed;
-
-				if (road_type != RoadType::Parallel)
-				{
-					adjacent_roads_[i].push_back(RoadInfo(j, road_type));
-					adjacent_roads_[j].push_back(RoadInfo(i, road_type));
-				}
-			}
+			score_ += loots[loot.type].GetScore();
 		}
+		gathered_loots_.clear();
 	}
 
 	void DogNavigator::SetStartPositionFirstRoad()
@@ -163,9 +150,9 @@ namespace model
 		dog_info_.curr_position = DogPosition(start.x, start.y);
 	}
 
-	void DogNavigator::SetStartPositionRandomRoad()
+	void DogNavigator::SetStartPositionRandomRoad(utils::FastRandom &random)
 	{
-		dog_info_.current_road_index = utils::GetRandomNumber<size_t>(0, roads_.size() - 1);
+		dog_info_.current_road_index = utils::GetRandomNumber<size_t>(random, 0, roads_.size() - 1);
 		auto start = roads_[dog_info_.current_road_index].GetStart();
 		auto end = roads_[dog_info_.current_road_index].GetEnd();
 
@@ -173,13 +160,13 @@ namespace model
 		{
 			if (start.x > end.x)
 				std::swap(start, end);
-			dog_info_.curr_position = DogPosition(utils::GetRandomNumber<int>(start.x, end.x), start.y);
+			dog_info_.curr_position = DogPosition(utils::GetRandomNumber<int>(random, start.x, end.x), start.y);
 		}
 		else
 		{
 			if (start.y > end.y)
 				std::swap(start, end);
-			dog_info_.curr_position = DogPosition(start.x, utils::GetRandomNumber<int>(start.y, end.y));
+			dog_info_.curr_position = DogPosition(start.x, utils::GetRandomNumber<int>(random, start.y, end.y));
 		}
 	}
 
@@ -234,12 +221,9 @@ namespace model
 	{
 		std::optional<size_t> res;
 
-		const auto &adj_roads = adjacent_roads_[dog_info_.current_road_index];
+		const auto adj_roads = road_graph_.GetCrossRoads(dog_info_.current_road_index, newPos.x - dS, newPos.x + dS);
 		for (const auto &road_info : adj_roads)
 		{
-			if (road_info.road_type != RoadType::Crossed)
-				continue;
-
 			const auto &adj_road = roads_[road_info.road_index];
 
 			if ((newPos.y < static_cast<double>(adj_road.GetStart().y)) && (newPos.y < static_cast<double>(adj_road.GetEnd().y)))
@@ -248,13 +232,8 @@ namespace model
 			if ((newPos.y > static_cast<double>(adj_road.GetStart().y)) && (newPos.y > static_cast<double>(adj_road.GetEnd().y)))
 				continue;
 
-			double dist = std::abs(static_cast<double>(adj_road.GetStart().x) - newPos.x);
-
-			if (dist <= dS)
-			{
-				res = road_info.road_index;
-				return res;
-			}
+			res = road_info.road_index;
+			return res;
 		}
 
 		return res;
@@ -264,20 +243,10 @@ namespace model
 	{
 		std::optional<size_t> res;
 
-		const auto &adj_roads = adjacent_roads_[dog_info_.current_road_index];
+		const auto adj_roads = road_graph_.GetCrossRoads(dog_info_.current_road_index, edge_point.x - dS, edge_point.x + dS);
 		for (const auto &road_info : adj_roads)
 		{
-			if (road_info.road_type != RoadType::Crossed)
-				continue;
-
-			const auto &adj_road = roads_[road_info.road_index]; // dog_info_.current_road_index];
-			if (!adj_road.IsVertical())
-				continue;
-
-			double dist1 = std::abs(static_cast<double>(adj_road.GetStart().x) - edge_point.x);
-			double dist2 = std::abs(static_cast<double>(adj_road.GetEnd().x) - edge_point.x);
-
-			if ((dist1 <= dS) || (dist2 <= dS))
+			if (roads_[road_info.road_index].IsVertical())
 			{
 				res = road_info.road_index;
 				return res;
@@ -338,20 +307,10 @@ namespace model
 	{
 		std::optional<size_t> res;
 
-		const auto &adj_roads = adjacent_roads_[dog_info_.current_road_index];
+		const auto adj_roads = road_graph_.GetCrossRoads(dog_info_.current_road_index, edge_point.y - dS, edge_point.y + dS);
 		for (const auto &road_info : adj_roads)
 		{
-			if (road_info.road_type != RoadType::Crossed)
-				continue;
-
-			const auto &adj_road = roads_[road_info.road_index];
-			if (!adj_road.IsHorizontal())
-				continue;
-
-			double dist1 = std::abs(static_cast<double>(adj_road.GetStart().y) - edge_point.y);
-			double dist2 = std::abs(static_cast<double>(adj_road.GetEnd().y) - edge_point.y);
-
-			if ((dist1 <= dS) || (dist2 <= dS))
+			if (roads_[road_info.road_index].IsHorizontal())
 			{
 				res = road_info.road_index;
 				return res;
@@ -365,12 +324,9 @@ namespace model
 	{
 		std::optional<size_t> res;
 
-		const auto &adj_roads = adjacent_roads_[dog_info_.current_road_index];
+		const auto adj_roads = road_graph_.GetCrossRoads(dog_info_.current_road_index, newPos.y - dS, newPos.y + dS);
 		for (const auto &road_info : adj_roads)
 		{
-			if (road_info.road_type != RoadType::Crossed)
-				continue;
-
 			const auto &adj_road = roads_[road_info.road_index];
 
 			if ((newPos.x < static_cast<double>(adj_road.GetStart().x)) && (newPos.x < static_cast<double>(adj_road.GetEnd().x)))
@@ -379,12 +335,7 @@ namespace model
 			if ((newPos.x > static_cast<double>(adj_road.GetStart().x)) && (newPos.x > static_cast<double>(adj_road.GetEnd().x)))
 				continue;
 
-			double dist = std::abs(static_cast<double>(adj_road.GetStart().y) - newPos.y);
-
-			if (dist <= dS)
-			{
-				return road_info.road_index;
-			}
+			return road_info.road_index;
 		}
 
 		return res;
@@ -434,34 +385,37 @@ namespace model
 		dog_info_.curr_position = newPos;
 	}
 
-	void DogNavigator::MoveDog(DogDirection direction, int time)
+	DogPos DogNavigator::MoveDog(const DogPos &position, DogDirection direction, const DogPosition &newPos)
 	{
+		dog_info_ = position;
 		const auto &road = roads_[dog_info_.current_road_index];
-		double dt = static_cast<double>(time) / millisescondsInSecond;
-
-		DogPosition newPos{dog_info_.curr_position.x + dt * dog_info_.curr_speed.vx,
-						   dog_info_.curr_position.y + dt * dog_info_.curr_speed.vy};
+		DogPosition pos = newPos;
 
 		if (road.IsHorizontal())
 		{
 			if ((direction == DogDirection::WEST) || (direction == DogDirection::EAST))
-				FindNewPosMovingHorizontal(road, newPos);
+				FindNewPosMovingHorizontal(road, pos);
 			else
-				FindNewPosPerpendicularHorizontal(road, direction, newPos);
+				FindNewPosPerpendicularHorizontal(road, direction, pos);
 		}
 		else
 		{
 			if ((direction == DogDirection::NORTH) || (direction == DogDirection::SOUTH))
-				FindNewPosMovingVertical(road, newPos);
+				FindNewPosMovingVertical(road, pos);
 			else
-				FindNewPosPerpendicularVertical(road, direction, newPos);
+				FindNewPosPerpendicularVertical(road, direction, pos);
 		}
+		return dog_info_;
 	}
 
-	void DogNavigator::SpawnDogInMap(bool spawn_in_random_point)
+	DogPos DogNavigator::GetStartPosition(bool spawn_in_random_point, utils::FastRandom &random)
 	{
+		dog_info_ = DogPos{};
 		if (spawn_in_random_point)
-			SetStartPositionRandomRoad();
+			SetStartPositionRandomRoad(random);
+		else
+			SetStartPositionFirstRoad();
+		return dog_info_;
 	}
 
 	void DogNavigator::CorrectDogPosition()
@@ -1,5 +1,9 @@
 #pragma once
 #include "model.h"
+#include "road_graph.h"
+#include "utils.h"
+#include <cstdint>
+#include <memory>
 #include <optional>
 
 using namespace model;
@@ -17,84 +21,65 @@ namespace model
     class Map;
     class Road;
     struct LootInfo;
-    enum class RoadType
-    {
-        Parallel,
-        Adjacent,
-        Crossed
-    };
-
-    struct RoadInfo
-    {
-        size_t road_index{};
-        RoadType road_type{RoadType::Parallel};
-        RoadInfo(size_t index, RoadType rdType) : road_index(index), road_type(rdType) {}
-    };
-
+    class DogKinematics;
     std::string ConvertDogDirectionToString(DogDirection direction);
 
     class DogNavigator
     {
     public:
-        DogNavigator(const std::vector<model::Road> &roads, bool spawn_dog_in_random_point) : roads_(roads)
+        explicit DogNavigator(const model::Map &map)
+            : roads_(map.GetRoads()), road_graph_(map.GetRoadGraph())
         {
-            adjacent_roads_ = std::vector<std::vector<RoadInfo>>(roads.size());
-            FindAdjacentRoads();
-            if (spawn_dog_in_random_point)
-            {
-                SetStartPositionRandomRoad();
-            }
-            else
-            {
-                SetStartPositionFirstRoad();
-            }
         }
 
     public:
-        void MoveDog(DogDirection direction, int time);
-        DogPos GetDogPosOnMap() { return dog_info_; }
-        void SetDogPosOnMap(const DogPos &position) { dog_info_ = position; }
-        DogPosition GetDogPosition() { return dog_info_.curr_position; }
-        DogSpeed GetDogSpeed() { return dog_info_.curr_speed; }
-        void SpawnDogInMap(bool spawn_in_random_point);
-        void SetDogSpeed(const DogSpeed &speed) { dog_info_.curr_speed = speed; }
+        // Переносит собаку из position в newPos, не давая ей сойти с дорог
+        DogPos MoveDog(const DogPos &position, DogDirection direction, const DogPosition &newPos);
+        // Случайную точку выбирает генератор random сессии
+        DogPos GetStartPosition(bool spawn_in_random_point, utils::FastRandom &random);
 
     private:
         void FindNewPosMovingHorizontal(const model::Road &road, DogPosition &newPos);
         void FindNewPosMovingVertical(const model::Road &road, DogPosition &newPos);
 
-        void FindAdjacentRoads();
         void SetStartPositionFirstRoad();
-        bool RoadsCrossed(const model::Road &road1, const model::Road &road2);
-        bool RoadsAdjacent(const model::Road &road1, const model::Road &road2);
         std::optional<size_t> FindNearestAdjacentVerticalRoad(const DogPosition &edge_point);
         std::optional<size_t> FindNearestVerticalCrossRoad(const DogPosition &newPos);
         void FindNewPosPerpendicularHorizontal(const model::Road &road, DogDirection direction, DogPosition &newPos);
         std::optional<size_t> FindNearestHorizontalCrossRoad(const DogPosition &newPos);
         std::optional<size_t> FindNearestAdjacentHorizontalRoad(const DogPosition &edge_point);
         void FindNewPosPerpendicularVertical(const model::Road &road, DogDirection direction, DogPosition &newPos);
-        void SetStartPositionRandomRoad();
+        void SetStartPositionRandomRoad(utils::FastRandom &random);
         void CorrectDogPosition();
 
     private:
         const std::vector<model::Road> &roads_;
-        std::vector<std::vector<RoadInfo>> adjacent_roads_;
+        const RoadGraph &road_graph_;
+        // Положение перемещаемой собаки; сами собаки хранятся в DogKinematics
         DogPos dog_info_;
     };
 
+    // Собака - лёгкий дескриптор: координаты, скорость, направление и время хранятся
+    // в DogKinematics сессии, а здесь остаются только рюкзак и очки
     class Dog
     {
     public:
         Dog(const model::Map *map, bool spawn_dog_in_random_point, unsigned defaultBagCapacity);
+        Dog(std::shared_ptr<DogKinematics> kinematics, const model::Map *map,
+            bool spawn_dog_in_random_point, unsigned defaultBagCapacity);
+        Dog(const Dog &) = delete;
+        Dog &operator=(const Dog &) = delete;
+        ~Dog();
+
         void SetSpeed(DogDirection dir, double speed);
-        void SetDirection(const DogDirection &dir) { direction_ = dir; }
+        void SetDirection(const DogDirection &dir);
         std::optional<collision_detector::Gatherer> Move(int deltaTime);
-        DogDirection GetDirection() const { return direction_; }
-        DogPosition GetPosition() const { return navigator_->GetDogPosition(); }
-        void SetPositionOnMap(const DogPos &position) { navigator_->SetDogPosOnMap(position); }
-        DogPos GetPositionOnMap() { return navigator_->GetDogPosOnMap(); }
-        DogSpeed GetSpeed() { return navigator_->GetDogSpeed(); }
-        void SpawnDogInMap(bool spawn_in_random_point) { navigator_->SpawnDogInMap(spawn_in_random_point); }
+        DogDirection GetDirection() const;
+        DogPosition GetPosition() const;
+        void SetPositionOnMap(const DogPos &position);
+        DogPos GetPositionOnMap() const;
+        DogSpeed GetSpeed() const;
+        void SpawnDogInMap(bool spawn_in_random_point);
         const std::vector<model::LootInfo> &GetGatheredLoot() const { return gathered_loots_; }
         void SetGatheredLoot(const std::vector<model::LootInfo> &loots) { gathered_loots_ = loots; }
         bool AddLoot(const model::LootInfo &loot);
@@ -103,18 +88,19 @@ namespace model
         void SetScore(int score) { score_ = score; }
         unsigned GetBagCapacity() const { return bag_capacity_; }
         void SetBagCapacity(unsigned capacity) { bag_capacity_ = capacity; }
-        unsigned int GetIdleTime() const { return idle_time_; }
-        unsigned int GetPlayTime() const { return play_time_; }
-        void SetPlayTime(unsigned int time) { play_time_ = time; }
+        unsigned int GetIdleTime() const;
+        unsigned int GetPlayTime() const;
+        void SetPlayTime(unsigned int time);
+        // Переносит состояние собаки из хранилища сессии в собственное,
+        // чтобы покинувшую сессию собаку можно было читать с любого потока
+        void Detach();
 
     private:
-        DogDirection direction_;
         const model::Map *map_;
-        std::shared_ptr<model::DogNavigator> navigator_;
+        std::shared_ptr<DogKinematics> kinematics_;
+        std::uint32_t id_;
         std::vector<model::LootInfo> gathered_loots_;
         unsigned bag_capacity_{};
         int score_{0};
-        unsigned int idle_time_{0};
-        unsigned int play_time_{0};
     };
 }
\ No newline at end of file
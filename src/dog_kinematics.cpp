@@ -0,0 +1,219 @@
+#include "dog_kinematics.h"
+#include "collision_detector.h"
+#include <cmath>
+
+constexpr int millisescondsInSecond = 1000;
+constexpr double gathererWidth = 0.6;
+constexpr double epsilon = 0.0001;
+
+namespace model
+{
+	DogKinematics::DogKinematics(const model::Map &map, std::uint64_t seed)
+		: navigator_(map), random_(seed)
+	{
+	}
+
+	DogKinematics::Id DogKinematics::Add(Dog *dog, bool spawn_in_random_point)
+	{
+		Id id;
+		if (!free_ids_.empty())
+		{
+			id = free_ids_.back();
+			free_ids_.pop_back();
+		}
+		else
+		{
+			id = static_cast<Id>(indices_.size());
+			indices_.push_back(0);
+		}
+		indices_[id] = static_cast<std::uint32_t>(dogs_.size());
+
+		const auto position = navigator_.GetStartPosition(spawn_in_random_point, random_);
+		xs_.push_back(position.curr_position.x);
+		ys_.push_back(position.curr_position.y);
+		vxs_.push_back(0.0);
+		vys_.push_back(0.0);
+		directions_.push_back(DogDirection::NORTH);
+		road_indices_.push_back(position.current_road_index);
+		idle_times_.push_back(0);
+		play_times_.push_back(0);
+		dogs_.push_back(dog);
+		ids_.push_back(id);
+
+		return id;
+	}
+
+	void DogKinematics::Remove(Id id) noexcept
+	{
+		const size_t index = Index(id);
+		const size_t last = dogs_.size() - 1;
+		if (index != last)
+		{
+			xs_[index] = xs_[last];
+			ys_[index] = ys_[last];
+			vxs_[index] = vxs_[last];
+			vys_[index] = vys_[last];
+			directions_[index] = directions_[last];
+			road_indices_[index] = road_indices_[last];
+			idle_times_[index] = idle_times_[last];
+			play_times_[index] = play_times_[last];
+			dogs_[index] = dogs_[last];
+			ids_[index] = ids_[last];
+			indices_[ids_[index]] = static_cast<std::uint32_t>(index);
+		}
+
+		xs_.pop_back();
+		ys_.pop_back();
+		vxs_.pop_back();
+		vys_.pop_back();
+		directions_.pop_back();
+		road_indices_.pop_back();
+		idle_times_.pop_back();
+		play_times_.pop_back();
+		dogs_.pop_back();
+		ids_.pop_back();
+		free_ids_.push_back(id);
+	}
+
+	void DogKinematics::CopyFrom(Id id, const DogKinematics &other, Id from_id)
+	{
+		SetPositionOnMap(id, other.GetPositionOnMap(from_id));
+		SetDirection(id, other.GetDirection(from_id));
+		idle_times_[Index(id)] = other.GetIdleTime(from_id);
+		SetPlayTime(id, other.GetPlayTime(from_id));
+	}
+
+	DogPos DogKinematics::GetPositionOnMap(Id id) const
+	{
+		const size_t index = Index(id);
+		DogPos position;
+		position.current_road_index = road_indices_[index];
+		position.curr_position = DogPosition(xs_[index], ys_[index]);
+		position.curr_speed = DogSpeed{vxs_[index], vys_[index]};
+		return position;
+	}
+
+	void DogKinematics::SetPositionOnMap(Id id, const DogPos &position)
+	{
+		const size_t index = Index(id);
+		road_indices_[index] = position.current_road_index;
+		xs_[index] = position.curr_position.x;
+		ys_[index] = position.curr_position.y;
+		vxs_[index] = position.curr_speed.vx;
+		vys_[index] = position.curr_speed.vy;
+	}
+
+	DogPosition DogKinematics::GetPosition(Id id) const
+	{
+		const size_t index = Index(id);
+		return DogPosition(xs_[index], ys_[index]);
+	}
+
+	DogSpeed DogKinematics::GetSpeed(Id id) const
+	{
+		const size_t index = Index(id);
+		return DogSpeed{vxs_[index], vys_[index]};
+	}
+
+	void DogKinematics::SetSpeed(Id id, const DogSpeed &speed)
+	{
+		const size_t index = Index(id);
+		vxs_[index] = speed.vx;
+		vys_[index] = speed.vy;
+	}
+
+	void DogKinematics::SpawnDogInMap(Id id, bool spawn_in_random_point)
+	{
+		if (!spawn_in_random_point)
+			return;
+
+		const auto start = navigator_.GetStartPosition(true, random_);
+		const size_t index = Index(id);
+		road_indices_[index] = start.current_road_index;
+		xs_[index] = start.curr_position.x;
+		ys_[index] = start.curr_position.y;
+	}
+
+	bool DogKinematics::IsMoving(size_t index) const
+	{
+		return (std::abs(vxs_[index]) > epsilon) || (std::abs(vys_[index]) > epsilon);
+	}
+
+	std::optional<collision_detector::Gatherer> DogKinematics::FinishMove(size_t index, double new_x, double new_y)
+	{
+		std::optional<collision_detector::Gatherer> res;
+
+		const DogPosition start(xs_[index], ys_[index]);
+		DogPos position;
+		position.current_road_index = road_indices_[index];
+		position.curr_position = start;
+		position.curr_speed = DogSpeed{vxs_[index], vys_[index]};
+
+		position = navigator_.MoveDog(position, directions_[index], DogPosition(new_x, new_y));
+
+		road_indices_[index] = position.current_road_index;
+		xs_[index] = position.curr_position.x;
+		ys_[index] = position.curr_position.y;
+		vxs_[index] = position.curr_speed.vx;
+		vys_[index] = position.curr_speed.vy;
+
+		const DogPosition &end = position.curr_position;
+		if ((std::abs(start.x - end.x) > epsilon) || (std::abs(start.y - end.y) > epsilon))
+		{
+			collision_detector::Gatherer gth({start.x, start.y}, {end.x, end.y}, gathererWidth);
+			res = gth;
+		}
+
+		return res;
+	}
+
+	std::optional<collision_detector::Gatherer> DogKinematics::Move(Id id, int deltaTime)
+	{
+		const size_t index = Index(id);
+		play_times_[index] += deltaTime;
+		if (!IsMoving(index))
+		{
+			idle_times_[index] += deltaTime;
+			return std::nullopt;
+		}
+		idle_times_[index] = 0;
+
+		const double dt = static_cast<double>(deltaTime) / millisescondsInSecond;
+		return FinishMove(index, xs_[index] + dt * vxs_[index], ys_[index] + dt * vys_[index]);
+	}
+
+	void DogKinematics::MoveAll(int deltaTime, std::vector<collision_detector::Gatherer> &gatherers,
+								std::vector<Dog *> &gatherer_dogs)
+	{
+		const size_t count = dogs_.size();
+		const double dt = static_cast<double>(deltaTime) / millisescondsInSecond;
+		const unsigned int delta = static_cast<unsigned int>(deltaTime);
+
+		// Сначала без ветвлений обновляем время и считаем желаемые координаты всех собак:
+		// эти циклы идут по непрерывным массивам и векторизуются компилятором
+		new_xs_.resize(count);
+		new_ys_.resize(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			play_times_[i] += delta;
+			const bool moving = (std::abs(vxs_[i]) > epsilon) | (std::abs(vys_[i]) > epsilon);
+			idle_times_[i] = moving ? 0 : idle_times_[i] + delta;
+			new_xs_[i] = xs_[i] + dt * vxs_[i];
+			new_ys_[i] = ys_[i] + dt * vys_[i];
+		}
+
+		// Затем ограничиваем дорогами только движущихся собак
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (!IsMoving(i))
+				continue;
+
+			auto gatherer = FinishMove(i, new_xs_[i], new_ys_[i]);
+			if (!gatherer)
+				continue;
+
+			gatherers.push_back(*gatherer);
+			gatherer_dogs.push_back(dogs_[i]);
+		}
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "dog.h"
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace model
+{
+    // Хранилище движения собак одной сессии в виде структуры массивов: координаты,
+    // скорости, направления, дороги и время лежат в отдельных непрерывных векторах,
+    // поэтому тик проходит по ним подряд, не разыменовывая собак по одной.
+    // Идентификатор собаки постоянен, а её место в массивах меняется при удалении соседей
+    class DogKinematics
+    {
+    public:
+        using Id = std::uint32_t;
+
+        // seed - зерно генератора случайных точек появления собак
+        DogKinematics(const model::Map &map, std::uint64_t seed);
+        DogKinematics(const DogKinematics &) = delete;
+        DogKinematics &operator=(const DogKinematics &) = delete;
+
+        Id Add(Dog *dog, bool spawn_in_random_point);
+        void Remove(Id id) noexcept;
+        // Копирует состояние собаки from_id из другого хранилища
+        void CopyFrom(Id id, const DogKinematics &other, Id from_id);
+        size_t Size() const noexcept { return dogs_.size(); }
+
+        DogPos GetPositionOnMap(Id id) const;
+        void SetPositionOnMap(Id id, const DogPos &position);
+        DogPosition GetPosition(Id id) const;
+        DogSpeed GetSpeed(Id id) const;
+        void SetSpeed(Id id, const DogSpeed &speed);
+        DogDirection GetDirection(Id id) const { return directions_[Index(id)]; }
+        void SetDirection(Id id, DogDirection direction) { directions_[Index(id)] = direction; }
+        unsigned int GetIdleTime(Id id) const { return idle_times_[Index(id)]; }
+        void ResetIdleTime(Id id) { idle_times_[Index(id)] = 0; }
+        unsigned int GetPlayTime(Id id) const { return play_times_[Index(id)]; }
+        void SetPlayTime(Id id, unsigned int time) { play_times_[Index(id)] = time; }
+        void SpawnDogInMap(Id id, bool spawn_in_random_point);
+
+        // Двигает одну собаку; возвращает её путь, если она сместилась
+        std::optional<collision_detector::Gatherer> Move(Id id, int deltaTime);
+        // Двигает всех собак хранилища. Пути сместившихся собак дописываются
+        // в gatherers, сами собаки - в том же порядке в gatherer_dogs
+        void MoveAll(int deltaTime, std::vector<collision_detector::Gatherer> &gatherers,
+                     std::vector<Dog *> &gatherer_dogs);
+
+    private:
+        size_t Index(Id id) const { return indices_[id]; }
+        bool IsMoving(size_t index) const;
+        // Ограничивает перемещение собаки index в new_x, new_y дорогами карты
+        std::optional<collision_detector::Gatherer> FinishMove(size_t index, double new_x, double new_y);
+
+        DogNavigator navigator_;
+        utils::FastRandom random_;
+
+        std::vector<double> xs_;
+        std::vector<double> ys_;
+        std::vector<double> vxs_;
+        std::vector<double> vys_;
+        std::vector<DogDirection> directions_;
+        std::vector<size_t> road_indices_;
+        std::vector<unsigned int> idle_times_;
+        std::vector<unsigned int> play_times_;
+        std::vector<Dog *> dogs_;
+        std::vector<Id> ids_;
+
+        // Место каждого идентификатора в массивах и освободившиеся идентификаторы
+        std::vector<std::uint32_t> indices_;
+        std::vector<Id> free_ids_;
+
+        // Рабочие массивы MoveAll, чтобы не выделять память на каждом тике
+        std::vector<double> new_xs_;
+        std::vector<double> new_ys_;
+    };
+}
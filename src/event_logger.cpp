@@ -127,4 +127,29 @@ namespace event_logger
     BOOST_LOG_TRIVIAL(warning) << logging::add_value(additional_data, error_object);
   }
 
+  void LogTickTimings(const http_handler::TickTimingsReport &report)
+  {
+    json::object resp_object;
+    resp_object["message"] = "tick timings";
+    resp_object["timestamp"] = GetLogTime();
+
+    json::object data_object;
+    data_object["ticks"] = report.ticks;
+    data_object["sessions"] = report.max_sessions;
+
+    json::object phases_object;
+    for (size_t i = 0; i < http_handler::tickPhasesCount; ++i)
+    {
+      json::object phase_object;
+      phase_object["mean_ms"] = report.mean_ms[i];
+      phase_object["max_ms"] = report.max_ms[i];
+      phases_object[http_handler::GetTickPhaseName(static_cast<http_handler::TickPhase>(i))] = phase_object;
+    }
+    data_object["phases"] = phases_object;
+
+    resp_object["data"] = data_object;
+
+    BOOST_LOG_TRIVIAL(info) << logging::add_value(additional_data, resp_object);
+  }
+
 } // namespace event_logger
@@ -1,6 +1,7 @@
 #pragma once
 #include <boost/asio.hpp>
 #include <boost/system.hpp>
+#include "tick_timings.h"
 
 namespace sys = boost::system;
 namespace net = boost::asio;
@@ -22,4 +23,5 @@ namespace event_logger
     void LogServerRequestReceived(const std::string &uri, const std::string &http_method);
     void LogServerResponseSend(int response_time, unsigned code, const std::string &content_type);
     void LogServerError(const sys::error_code ec, std::string_view where);
+    void LogTickTimings(const http_handler::TickTimingsReport &report);
 }
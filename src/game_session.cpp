@@ -6,38 +6,38 @@
 #include "utils.h"
 #include "collision_detector.h"
 #include <algorithm>
-constexpr double baseWidth = 0.5;
+#include <tuple>
 constexpr double lootWidth = 0.0;
 
 namespace model
 {
 	Player::Player(unsigned int id, const std::string &name, const std::string &token,
-				   const model::Map *map, bool spawn_dog_in_random_point, unsigned defaultBagCapacity)
+				   std::shared_ptr<DogKinematics> kinematics, const model::Map *map,
+				   bool spawn_dog_in_random_point, unsigned defaultBagCapacity)
 		: id_(id), name_(name), token_(token)
 	{
-		dog_ = std::make_shared<Dog>(map, spawn_dog_in_random_point, defaultBagCapacity);
+		dog_ = std::make_shared<Dog>(std::move(kinematics), map, spawn_dog_in_random_point, defaultBagCapacity);
 	}
 
 	std::shared_ptr<Player> GameSession::AddPlayer(const std::string player_name, model::Map *map,
 												   bool spawn_dog_in_random_point, unsigned defaultBagCapacity)
 	{
 		map_ = map;
-		auto itFind = std::find_if(players_.begin(), players_.end(),
-								   [&player_name](std::shared_ptr<Player> &player)
-								   {
-									   return player->GetName() == player_name;
-								   });
+		if (auto itFind = players_by_name_.find(player_name); itFind != players_by_name_.end())
+			return itFind->second;
 
-		if (itFind != players_.end())
-			return *itFind;
+		if (!dogs_)
+			dogs_ = std::make_shared<DogKinematics>(*map, random_());
 
 		PlayerTokens tk;
 		auto token = tk.GetToken();
-		auto player = std::make_shared<Player>(player_id, player_name, token, map,
+		auto player = std::make_shared<Player>(player_id, player_name, token, dogs_, map,
 											   spawn_dog_in_random_point, defaultBagCapacity);
 
 		players_.push_back(player);
+		players_by_name_.emplace(player_name, player);
 		player_id++;
+		MarkStateChanged();
 
 		return players_.back();
 	}
@@ -72,73 +72,72 @@ namespace model
 		return players_;
 	}
 
-	void AddLootToDog(std::shared_ptr<Dog> dog, std::vector<LootInfo> &loots, const std::vector<collision_detector::Item> &items)
+	std::vector<collision_detector::Item> MakeLootItems(const std::vector<LootInfo> &loots)
 	{
-		for (const auto &item : items)
+		std::vector<collision_detector::Item> items;
+		items.reserve(loots.size());
+		for (size_t i = 0; i < loots.size(); ++i)
 		{
-			if (item.item_type == collision_detector::ItemType::Office)
-			{
-				dog->PassLootToOffice();
-			}
-			else
-			{
-				auto itFind = std::find_if(loots.begin(), loots.end(),
-										   [id = item.id](const auto &elem)
-										   {
-											   return elem.id == id;
-										   });
-
-				if (itFind == loots.end())
-					continue;
-
-				if (dog->AddLoot(*itFind))
-					loots.erase(itFind);
-			}
+			items.emplace_back(static_cast<unsigned>(i), geom::Point2D{loots[i].x, loots[i].y}, lootWidth);
 		}
+		return items;
 	}
 
-	std::vector<collision_detector::Item> GetGatheredItems(const collision_detector::Gatherer &gatherer, std::vector<LootInfo> &loots, model::Map *map)
+	void GameSession::MoveDogs(int deltaTime)
 	{
-		std::vector<collision_detector::Item> items;
-		for (const auto &cur_loot : loots)
+		if (!dogs_ || !map_)
+			return;
+		MarkStateChanged();
+
+		// Сначала двигаем всех собак, запоминая их пути
+		std::vector<collision_detector::Gatherer> gatherers;
+		std::vector<Dog *> gatherer_dogs;
+		dogs_->MoveAll(deltaTime, gatherers, gatherer_dogs);
+
+		if (gatherers.empty())
+			return;
+
+		// Затем одним проходом находим все события сбора. Слой офисов построен
+		// картой заранее, на каждом тике индексируются только трофеи сессии
+		const auto &loots = loots_.GetLoots();
+		const collision_detector::ItemIndex loot_items(MakeLootItems(loots));
+		const auto loot_events = collision_detector::FindGatherEvents(loot_items, gatherers);
+		const auto office_events = collision_detector::FindGatherEvents(map_->GetOfficeLayer(), gatherers);
+
+		// При равном времени события одного собирателя идут в прежнем порядке: сначала трофеи, потом офисы
+		std::vector<std::pair<collision_detector::GatheringEvent, collision_detector::ItemType>> events;
+		events.reserve(loot_events.size() + office_events.size());
+		auto loot_it = loot_events.begin();
+		auto office_it = office_events.begin();
+		while (loot_it != loot_events.end() || office_it != office_events.end())
 		{
-			collision_detector::Item item(cur_loot.id, {cur_loot.x, cur_loot.y}, lootWidth);
-			items.push_back(item);
+			const bool take_office = loot_it == loot_events.end() ||
+									 (office_it != office_events.end() &&
+									  std::tie(office_it->time, office_it->gatherer_id) < std::tie(loot_it->time, loot_it->gatherer_id));
+			if (take_office)
+				events.emplace_back(*office_it++, collision_detector::ItemType::Office);
+			else
+				events.emplace_back(*loot_it++, collision_detector::ItemType::Loot);
 		}
 
-		if (map)
+		std::vector<bool> collected(loots.size(), false);
+		std::vector<LootStorage::Id> collected_ids;
+		for (const auto &[event, item_type] : events)
 		{
-			const auto &offices = map->GetOffices();
-			for (const auto &office : offices)
+			Dog *dog = gatherer_dogs[event.gatherer_id];
+			if (item_type == collision_detector::ItemType::Office)
 			{
-				collision_detector::Item item(0, {(double)office.GetPosition().x, (double)office.GetPosition().y},
-											  baseWidth, collision_detector::ItemType::Office);
-				items.push_back(item);
+				dog->PassLootToOffice();
+			}
+			else if (!collected[event.item_id] && dog->AddLoot(loots[event.item_id]))
+			{
+				collected[event.item_id] = true;
+				collected_ids.push_back(loots[event.item_id].id);
 			}
-		}
-		collision_detector::ItemGatherer item_gath(items, {gatherer});
-		const auto &ev = collision_detector::FindGatherEvents(item_gath);
-
-		std::vector<collision_detector::Item> result;
-
-		for (size_t i = 0; i < ev.size(); ++i)
-		{
-			result.push_back(item_gath.GetItem(ev[i].item_id));
 		}
 
-		return result;
-	}
-
-	void GameSession::MoveDogs(int deltaTime)
-	{
-		std::for_each(players_.begin(), players_.end(), [this, deltaTime](std::shared_ptr<Player> &player)
-					  {
-		std::optional<collision_detector::Gatherer> gatherer = player->GetDog()->Move(deltaTime);
-		if(!gatherer)
-			return;
-
-		auto items = GetGatheredItems(*gatherer, loots_info_, map_);
-		AddLootToDog(player->GetDog(), loots_info_, items); });
+		for (auto id : collected_ids)
+			loots_.Remove(id);
 	}
 
 	void GameSession::InitLootGenerator(double loot_period, double loot_probability)
@@ -156,7 +155,7 @@ namespace model
 		return pMap->GetRoads();
 	}
 
-	model::LootInfo GenerateLootInfo(const Map *pMap)
+	model::LootInfo GenerateLootInfo(const Map *pMap, utils::FastRandom &random)
 	{
 		const auto &roads = GetRoads(pMap);
 
@@ -164,14 +163,13 @@ namespace model
 		if (num_loots == 0)
 			throw logic_error("No loot specified for the map!");
 
-		static unsigned loot_id = 0;
-		auto loot_type = utils::GetRandomNumber<size_t>(0, num_loots - 1);
+		auto loot_type = utils::GetRandomNumber<size_t>(random, 0, num_loots - 1);
 
 		size_t num_roads = pMap->GetNumRoads();
 		if (num_roads == 0)
 			throw logic_error("No roads specified for the map!");
 
-		auto road_index = utils::GetRandomNumber<size_t>(0, num_roads - 1);
+		auto road_index = utils::GetRandomNumber<size_t>(random, 0, num_roads - 1);
 
 		auto start = roads[road_index].GetStart();
 		auto end = roads[road_index].GetEnd();
@@ -181,7 +179,7 @@ namespace model
 			if (start.x > end.x)
 				std::swap(start, end);
 
-			x = utils::GetRandomNumber<int>(start.x, end.x);
+			x = utils::GetRandomNumber<int>(random, start.x, end.x);
 			y = start.y;
 		}
 		else
@@ -190,21 +188,22 @@ namespace model
 				std::swap(start, end);
 
 			x = start.x;
-			y = utils::GetRandomNumber<int>(start.y, end.y);
+			y = utils::GetRandomNumber<int>(random, start.y, end.y);
 		}
 
-		model::LootInfo loot_info(loot_id, loot_type, x, y);
-		loot_id++;
-		return loot_info;
+		// Идентификатор трофею назначает хранилище сессии
+		return model::LootInfo(0, loot_type, x, y);
 	}
 
 	void GameSession::GenerateLoot(int deltaTime, const Map *pMap)
 	{
-		auto num_loot_to_generate = lootGen_->Generate(loot_gen::LootGenerator::TimeInterval{deltaTime}, loots_info_.size(), players_.size());
+		auto num_loot_to_generate = lootGen_->Generate(loot_gen::LootGenerator::TimeInterval{deltaTime}, loots_.Size(), players_.size());
+		if (num_loot_to_generate > 0)
+			MarkStateChanged();
 
 		while (num_loot_to_generate > 0)
 		{
-			loots_info_.push_back(GenerateLootInfo(pMap));
+			loots_.Add(GenerateLootInfo(pMap, random_));
 			num_loot_to_generate--;
 		}
 	}
@@ -213,7 +212,7 @@ namespace model
 	{
 		GameSessionState state;
 
-		state.loots_info_state = loots_info_;
+		state.loots_state_ = loots_;
 		state.map_id_ = map_id_;
 		state.player_id_ = player_id;
 
@@ -223,6 +222,61 @@ namespace model
 		return state;
 	}
 
+	std::uint64_t GameSession::CommitTick()
+	{
+		const auto version = history_.Commit(players_, loots_);
+		// Тела изменений и двоичного состояния содержат номер версии
+		delta_snapshot_.reset();
+		binary_snapshot_.reset();
+		return version;
+	}
+
+	void GameSession::PublishStateSnapshot(std::shared_ptr<const std::string> snapshot)
+	{
+		state_snapshot_ = std::move(snapshot);
+		state_changed_ = false;
+		delta_snapshot_.reset();
+		binary_snapshot_.reset();
+		dogs_grid_.reset();
+		loots_grid_.reset();
+	}
+
+	InterestArea GameSession::GetInterestArea(const Player &player, double radius)
+	{
+		// Сетка с клеткой, равной радиусу, отвечает на запрос просмотром 3x3 клеток
+		if (!dogs_grid_)
+		{
+			std::vector<geom::Point2D> points;
+			points.reserve(players_.size());
+			for (const auto &pl : players_)
+			{
+				const auto pos = pl->GetDog()->GetPosition();
+				points.emplace_back(pos.x, pos.y);
+			}
+			dogs_grid_ = std::make_shared<const SpatialGrid>(radius, std::move(points));
+		}
+		if (!loots_grid_)
+		{
+			std::vector<geom::Point2D> points;
+			points.reserve(loots_.Size());
+			for (const auto &loot : loots_.GetLoots())
+				points.emplace_back(loot.x, loot.y);
+			loots_grid_ = std::make_shared<const SpatialGrid>(radius, std::move(points));
+		}
+
+		InterestArea area;
+		const auto pos = player.GetDog()->GetPosition();
+		const geom::Point2D center{pos.x, pos.y};
+		for (auto index : dogs_grid_->Query(center, radius))
+			area.players.push_back(players_[index]);
+
+		const auto &loots = loots_.GetLoots();
+		for (auto index : loots_grid_->Query(center, radius))
+			area.loots.push_back(loots[index]);
+
+		return area;
+	}
+
 	PlayerState Player::GetState()
 	{
 		return PlayerState(name_, token_, id_, dog_);
@@ -235,6 +289,12 @@ namespace model
 			auto findIt = std::find(std::begin(players_), std::end(players_), *it);
 			if (findIt != std::end(players_))
 			{
+				// Удалённого игрока ещё читают при записи в базу, уже вне потока сессии
+				(*findIt)->GetDog()->Detach();
+				players_by_name_.erase((*findIt)->GetName());
+				MarkStateChanged();
+				// Сетки хранят номера игроков, которые после удаления сдвигаются
+				dogs_grid_.reset();
 				const auto new_end{std::remove(std::begin(players_), std::end(players_), *findIt)};
 				players_.erase(new_end, std::end(players_));
 			}
@@ -1,8 +1,14 @@
 #pragma once
 #include "dog.h"
+#include "dog_kinematics.h"
+#include "loot_storage.h"
+#include "state_history.h"
+#include "spatial_grid.h"
 #include <memory>
+#include <unordered_map>
 #include <fstream>
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/version.hpp>
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
 
@@ -63,13 +69,14 @@ namespace model
 	{
 	public:
 		Player(unsigned int id, const std::string &name, const std::string &token,
-			   const model::Map *map, bool spawn_dog_in_random_point, unsigned defaultBagCapacity);
+			   std::shared_ptr<DogKinematics> kinematics, const model::Map *map,
+			   bool spawn_dog_in_random_point, unsigned defaultBagCapacity);
 		const std::string &GetToken() const { return token_; }
 		void SetToken(const std::string &token) { token_ = token; }
 		const std::string &GetName() const { return name_; }
 		unsigned int GetId() const { return id_; }
 		void SetId(unsigned int id) { id_ = id; }
-		std::shared_ptr<Dog> GetDog() { return dog_; }
+		std::shared_ptr<Dog> GetDog() const { return dog_; }
 		PlayerState GetState();
 
 	private:
@@ -82,7 +89,7 @@ namespace model
 	struct GameSessionState
 	{
 		std::vector<PlayerState> player_state_;
-		std::vector<LootInfo> loots_info_state;
+		LootStorage loots_state_;
 		std::string map_id_;
 		unsigned int player_id_;
 
@@ -97,7 +104,19 @@ namespace model
 			ar &map_id_;
 			ar &player_id_;
 			ar &player_state_;
-			ar &loots_info_state;
+			if (version == 0)
+			{
+				// До версии 1 трофеи сохранялись вектором с общей для всех сессий нумерацией
+				std::vector<LootInfo> loots;
+				ar &loots;
+				loots_state_ = LootStorage{};
+				for (const auto &loot : loots)
+					loots_state_.Add(loot);
+			}
+			else
+			{
+				ar &loots_state_;
+			}
 		}
 	};
 
@@ -117,11 +136,18 @@ namespace model
 		}
 	};
 
+	// Игроки и трофеи, которые видит игрок в режиме ограниченной видимости
+	struct InterestArea
+	{
+		std::vector<std::shared_ptr<Player>> players;
+		std::vector<LootInfo> loots;
+	};
+
 	class GameSession
 	{
 	public:
 		GameSession(const std::string &map_id, double loot_period, double loot_probability)
-			: map_id_(map_id)
+			: map_id_(map_id), random_(utils::MakeRandomSeed(map_id))
 		{
 			InitLootGenerator(loot_period, loot_probability);
 		}
@@ -133,22 +159,64 @@ namespace model
 		std::shared_ptr<Player> GetPlayerWithAuthToken(const std::string &auth_token);
 		void MoveDogs(int deltaTime);
 		size_t GetNumPlayers() { return players_.size(); }
-		const std::vector<model::LootInfo> &GetLootsInfo() { return loots_info_; };
+		const std::vector<model::LootInfo> &GetLootsInfo() const { return loots_.GetLoots(); };
 		void GenerateLoot(int deltaTime, const Map *pMap);
 		GameSessionState GetState() const;
 		void SetPlayerId(unsigned int id) { player_id = id; }
-		void SetLootsInfo(const std::vector<LootInfo> &loots) { loots_info_ = loots; }
+		void SetLoots(const LootStorage &loots)
+		{
+			loots_ = loots;
+			MarkStateChanged();
+		}
 		const std::vector<std::shared_ptr<Player>> &GetPlayers() { return players_; }
 		void DeleteRetiredPlayers(const std::vector<std::shared_ptr<model::Player>> &retired_players);
+		// Готовое тело ответа о состоянии сессии, общее для всех её игроков.
+		// Публикуется шагом тика, если сессия изменилась, поэтому между тиками
+		// запросы получают состояние на момент последнего тика
+		std::shared_ptr<const std::string> GetStateSnapshot() const { return state_snapshot_; }
+		// Публикует тело ответа для текущего состояния
+		void PublishStateSnapshot(std::shared_ptr<const std::string> snapshot);
+		// Фиксирует состояние на конец тика как новую версию. Вызывается ровно раз за тик,
+		// поэтому версия состояния - это номер тика сессии
+		std::uint64_t CommitTick();
+		// Отмечает изменение сессии. Запросы его не пересобирают: новое тело опубликует следующий тик
+		void MarkStateChanged() { state_changed_ = true; }
+		bool IsStateChanged() const { return state_changed_; }
+		std::uint64_t GetStateVersion() const { return history_.GetVersion(); }
+		std::optional<StateDelta> GetStateDelta(std::uint64_t since) const { return history_.GetDelta(since); }
+		// Готовое тело изменений с предыдущей версии: его запрашивают клиенты, не пропустившие ни одной версии
+		std::shared_ptr<const std::string> GetDeltaSnapshot() const { return delta_snapshot_; }
+		void PublishDeltaSnapshot(std::shared_ptr<const std::string> snapshot) { delta_snapshot_ = std::move(snapshot); }
+		// Готовое двоичное тело полного состояния текущей версии
+		std::shared_ptr<const std::string> GetBinarySnapshot() const { return binary_snapshot_; }
+		void PublishBinarySnapshot(std::shared_ptr<const std::string> snapshot) { binary_snapshot_ = std::move(snapshot); }
+		// Игроки и трофеи не дальше radius от собаки player. Сетки для поиска строятся
+		// при первом запросе после публикации состояния, то есть не чаще раза за тик
+		InterestArea GetInterestArea(const Player &player, double radius);
 
 	private:
 		void InitLootGenerator(double loot_period, double loot_probability);
 		std::vector<std::shared_ptr<Player>> players_;
-		std::vector<LootInfo> loots_info_;
+		std::unordered_map<std::string, std::shared_ptr<Player>> players_by_name_;
+		// Движение собак сессии; создаётся вместе с первым игроком, когда известна карта
+		std::shared_ptr<DogKinematics> dogs_;
+		LootStorage loots_;
 		std::string map_id_;
 		unsigned int player_id = 0;
 		model::Map *map_{};
 		std::shared_ptr<loot_gen::LootGenerator> lootGen_;
+		// Генератор случайных чисел сессии: в воспроизводимом режиме его зерно зависит
+		// только от зерна запуска и карты, а не от того, какой поток выполняет сессию
+		utils::FastRandom random_;
+		std::shared_ptr<const std::string> state_snapshot_;
+		std::shared_ptr<const std::string> delta_snapshot_;
+		std::shared_ptr<const std::string> binary_snapshot_;
+		bool state_changed_{false};
+		StateHistory history_;
+		std::shared_ptr<const SpatialGrid> dogs_grid_;
+		std::shared_ptr<const SpatialGrid> loots_grid_;
 		const int thousand_for_generation = 1000;
 	};
-}
\ No newline at end of file
+}
+
+BOOST_CLASS_VERSION(model::GameSessionState, 1)
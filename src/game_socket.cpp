@@ -0,0 +1,90 @@
+#include "game_socket.h"
+#include <boost/asio/dispatch.hpp>
+
+namespace http_handler
+{
+	GameSocket::GameSocket(beast::tcp_stream &&stream, MessageHandler on_message)
+		: ws_(std::move(stream)), on_message_(std::move(on_message))
+	{
+	}
+
+	void GameSocket::Run(http::request<http::string_body> &&upgrade_request)
+	{
+		// Таймауты HTTP-сессии не подходят долгоживущему соединению, WebSocket следит за ним сам
+		beast::get_lowest_layer(ws_).expires_never();
+		ws_.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
+		ws_.text(true);
+
+		auto request = std::make_shared<http::request<http::string_body>>(std::move(upgrade_request));
+		net::dispatch(ws_.get_executor(), [self = shared_from_this(), request]
+					  { self->ws_.async_accept(*request, [self, request](beast::error_code ec)
+											   { self->OnAccept(ec); }); });
+	}
+
+	void GameSocket::Send(Frame frame)
+	{
+		net::dispatch(ws_.get_executor(), [self = shared_from_this(), frame = std::move(frame)]() mutable
+					  {
+			if (self->closed_)
+				return;
+			self->pending_ = std::move(frame);
+			if (self->accepted_ && !self->writing_)
+				self->Write(); });
+	}
+
+	void GameSocket::OnAccept(beast::error_code ec)
+	{
+		if (ec)
+		{
+			closed_ = true;
+			return event_logger::LogServerError(ec, event_logger::Where::ACCEPT);
+		}
+
+		accepted_ = true;
+		if (pending_)
+			Write();
+		Read();
+	}
+
+	void GameSocket::Read()
+	{
+		buffer_.clear();
+		ws_.async_read(buffer_, beast::bind_front_handler(&GameSocket::OnRead, shared_from_this()));
+	}
+
+	void GameSocket::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read)
+	{
+		if (ec)
+		{
+			closed_ = true;
+			pending_.reset();
+			if (ec == websocket::error::closed)
+				return;
+			return event_logger::LogServerError(ec, event_logger::Where::READ);
+		}
+
+		on_message_(beast::buffers_to_string(buffer_.data()));
+		Read();
+	}
+
+	void GameSocket::Write()
+	{
+		writing_ = std::move(pending_);
+		pending_.reset();
+		ws_.async_write(net::buffer(*writing_), beast::bind_front_handler(&GameSocket::OnWrite, shared_from_this()));
+	}
+
+	void GameSocket::OnWrite(beast::error_code ec, [[maybe_unused]] std::size_t bytes_written)
+	{
+		writing_.reset();
+		if (ec)
+		{
+			closed_ = true;
+			pending_.reset();
+			return event_logger::LogServerError(ec, event_logger::Where::WRITE);
+		}
+
+		if (pending_)
+			Write();
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "http_server.h"
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace http_handler
+{
+    namespace net = boost::asio;
+    namespace beast = boost::beast;
+    namespace http = beast::http;
+    namespace websocket = beast::websocket;
+
+    // Соединение WebSocket игрока. Сервер отправляет в него состояние сессии после
+    // каждого тика, клиент присылает действия. Все операции с потоком выполняются
+    // в strand соединения, Send можно вызывать из любого потока.
+    // Кадр - готовое тело ответа о состоянии, общее для всех подписчиков сессии
+    class GameSocket : public std::enable_shared_from_this<GameSocket>
+    {
+    public:
+        using Frame = std::shared_ptr<const std::string>;
+        using MessageHandler = std::function<void(std::string message)>;
+
+        GameSocket(beast::tcp_stream &&stream, MessageHandler on_message);
+
+        GameSocket(const GameSocket &) = delete;
+        GameSocket &operator=(const GameSocket &) = delete;
+
+        // Завершает переход к WebSocket и начинает чтение сообщений клиента
+        void Run(http::request<http::string_body> &&upgrade_request);
+        // Кадр с полным состоянием заменяет ещё не отправленный, поэтому медленный
+        // клиент получает только последнее состояние, а очередь не растёт
+        void Send(Frame frame);
+
+    private:
+        void OnAccept(beast::error_code ec);
+        void Read();
+        void OnRead(beast::error_code ec, std::size_t bytes_read);
+        void Write();
+        void OnWrite(beast::error_code ec, std::size_t bytes_written);
+
+        websocket::stream<beast::tcp_stream> ws_;
+        beast::flat_buffer buffer_;
+        MessageHandler on_message_;
+        // Используются только в strand соединения
+        Frame writing_;
+        Frame pending_;
+        bool accepted_{false};
+        bool closed_{false};
+    };
+}
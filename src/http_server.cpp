@@ -1,40 +1,271 @@
 #include "http_server.h"
 
 #include <boost/asio/dispatch.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
 using namespace std::literals;
 
 namespace http_server
 {
+    namespace
+    {
+        // Больше за один вызов sendfile не передаёт
+        constexpr std::uint64_t maxSendfileChunk = 0x7ffff000;
+        constexpr auto sendfileTimeout = 30s;
+    }
+
+    struct SessionBase::FileWrite
+    {
+        FileWrite(http::response<SendfileBody> &&response, const beast::tcp_stream::executor_type &executor)
+            : response(std::move(response)), serializer(this->response), timer(executor)
+        {
+        }
+
+        http::response<SendfileBody> response;
+        http::response_serializer<SendfileBody> serializer;
+        // Закрывает отправку, если клиент не принимает данные дольше sendfileTimeout
+        net::steady_timer timer;
+        // Отправляемый кусок тела и сколько его байт уже отправлено
+        size_t piece{0};
+        std::uint64_t position{0};
+    };
 
     void SessionBase::Read()
     {
+        reading_ = true;
         // Очищаем запрос от прежнего значения (метод Read может быть вызван несколько раз)
         request_ = {};
-        stream_.expires_after(30s);
-        // Считываем request_ из stream_, используя buffer_ для хранения считанных данных
+        // Время ожидания запроса ограничивает idle_timer_, а не таймер tcp_stream: чтение, начатое
+        // при готовящихся ответах, не должно оборвать их отправку
+        stream_.expires_never();
+        // Считываем request_ из stream_, используя buffer_ для хранения считанных данных.
+        // Если клиент прислал несколько запросов подряд, следующий уже лежит в buffer_
         http::async_read(stream_, buffer_, request_,
                          // По окончании операции будет вызван метод OnRead
                          beast::bind_front_handler(&SessionBase::OnRead, GetSharedThis()));
+        UpdateIdleTimer();
     }
 
     void SessionBase::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read)
     {
-        if (ec == http::error::end_of_stream)
+        reading_ = false;
+        UpdateIdleTimer();
+        if (finished_)
+            return;
+        if (idle_timed_out_ && ec == net::error::operation_aborted)
+            ec = beast::error::timeout;
+        if (ec)
         {
-            // Нормальная ситуация - клиент закрыл соединение
-            return Close();
+            read_closed_ = true;
+            // end_of_stream - нормальная ситуация: клиент закрыл соединение.
+            // Ответы на уже прочитанные запросы отправим, затем закроем соединение
+            if (ec != http::error::end_of_stream)
+                event_logger::LogServerError(ec, event_logger::Where::READ);
+            if (responses_.empty() && !writing_)
+                Close();
+            return;
         }
-        if (ec)
+
+        if (!CanDispatch(request_))
         {
-            return event_logger::LogServerError(ec, event_logger::Where::READ);
+            held_request_.emplace(std::move(request_));
+            return;
         }
-        HandleRequest(std::move(request_));
+        Dispatch(std::move(request_));
+        Resume();
+    }
+
+    bool SessionBase::CanDispatch(const HttpRequest &request) const
+    {
+        if (beast::websocket::is_upgrade(request))
+            return responses_.empty() && !writing_;
+        if (unanswered_ == 0)
+            return true;
+
+        const auto method = request.method();
+        const bool safe = method == http::verb::get || method == http::verb::head || method == http::verb::options;
+        return safe && unsafe_unanswered_ == 0;
+    }
+
+    void SessionBase::Dispatch(HttpRequest &&request)
+    {
+        // Запрос без keep-alive - последний в соединении
+        if (!request.keep_alive())
+            read_closed_ = true;
+
+        if (beast::websocket::is_upgrade(request))
+        {
+            read_closed_ = true;
+            finished_ = true;
+            return HandleRequest(std::move(request), first_slot_);
+        }
+
+        const auto method = request.method();
+        const bool safe = method == http::verb::get || method == http::verb::head || method == http::verb::options;
+        const std::uint64_t slot = first_slot_ + responses_.size();
+        responses_.push_back(Slot{nullptr, safe});
+        ++unanswered_;
+        if (!safe)
+            ++unsafe_unanswered_;
+        // Обработчик может ответить сразу, ещё до возврата из HandleRequest
+        HandleRequest(std::move(request), slot);
+    }
+
+    void SessionBase::OnResponseReady(std::uint64_t slot, std::unique_ptr<QueuedResponse> response)
+    {
+        if (finished_ || slot < first_slot_)
+            return;
+
+        auto &entry = responses_[slot - first_slot_];
+        entry.response = std::move(response);
+        --unanswered_;
+        if (!entry.safe)
+            --unsafe_unanswered_;
+
+        WriteNext();
+        Resume();
+    }
+
+    void SessionBase::WriteNext()
+    {
+        if (writing_ || finished_ || responses_.empty() || !responses_.front().response)
+            return;
+
+        auto response = std::move(responses_.front().response);
+        responses_.pop_front();
+        ++first_slot_;
+        writing_ = true;
+        // Write переносит ответ в кучу на время записи, поэтому обёртку можно удалить сразу
+        response->Write(*this);
+    }
+
+    void SessionBase::UpdateIdleTimer()
+    {
+        const bool idle = reading_ && !finished_ && responses_.empty() && !writing_;
+        if (idle == idle_timer_armed_)
+            return;
+        idle_timer_armed_ = idle;
+        if (!idle)
+        {
+            idle_timer_.cancel();
+            return;
+        }
+
+        idle_timer_.expires_after(timeout_);
+        idle_timer_.async_wait([self = GetSharedThis()](beast::error_code ec)
+                               {
+                                   // Таймер могли остановить и запустить заново, пока срабатывание ждало очереди
+                                   if (ec || !self->idle_timer_armed_ || self->idle_timer_.expiry() > std::chrono::steady_clock::now())
+                                       return;
+                                   // Клиент не прислал запрос вовремя: прерываем чтение, OnRead закроет соединение
+                                   self->idle_timed_out_ = true;
+                                   beast::error_code ignored;
+                                   self->stream_.socket().close(ignored);
+                               });
+    }
+
+    void SessionBase::Resume()
+    {
+        if (finished_)
+            return;
+        if (held_request_ && CanDispatch(*held_request_))
+        {
+            auto request = std::move(*held_request_);
+            held_request_.reset();
+            Dispatch(std::move(request));
+        }
+        if (!reading_ && !held_request_ && !read_closed_ && responses_.size() < maxPipelinedRequests)
+            Read();
+    }
+
+    void SessionBase::Write(http::response<SendfileBody> &&response)
+    {
+        stream_.expires_after(timeout_);
+        auto write = std::make_shared<FileWrite>(std::move(response), stream_.get_executor());
+        http::async_write_header(stream_, write->serializer,
+                                 [write, self = GetSharedThis()](beast::error_code ec, [[maybe_unused]] std::size_t bytes_written)
+                                 {
+                                     if (ec)
+                                         return self->OnWrite(true, ec, bytes_written);
+                                     self->SendFile(write);
+                                 });
+    }
+
+    void SessionBase::SendFile(std::shared_ptr<FileWrite> write)
+    {
+        auto &socket = stream_.socket();
+        beast::error_code ec;
+        if (!socket.native_non_blocking())
+            socket.native_non_blocking(true, ec);
+
+        const auto &body = write->response.body();
+        const size_t count = SendfileBody::PieceCount(body);
+        while (write->piece < count)
+        {
+            const auto piece = SendfileBody::GetPiece(body, write->piece);
+            const std::uint64_t size = piece.text.empty() ? piece.range.size : piece.text.size();
+            if (write->position == size)
+            {
+                ++write->piece;
+                write->position = 0;
+                continue;
+            }
+
+            ssize_t sent;
+            if (!piece.text.empty())
+            {
+                // Заголовок части придержим в буфере сокета до данных диапазона
+                sent = ::send(socket.native_handle(), piece.text.data() + write->position, size - write->position, MSG_NOSIGNAL | MSG_MORE);
+            }
+            else
+            {
+                off_t offset = static_cast<off_t>(piece.range.offset + write->position);
+                sent = ::sendfile(socket.native_handle(), body.file->fd, &offset, std::min(size - write->position, maxSendfileChunk));
+            }
+            if (sent > 0)
+            {
+                write->position += static_cast<std::uint64_t>(sent);
+                continue;
+            }
+            if (sent < 0 && errno == EINTR)
+                continue;
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                // Буфер сокета заполнен: продолжим, когда клиент примет часть данных
+                write->timer.expires_after(sendfileTimeout);
+                write->timer.async_wait([self = GetSharedThis()](beast::error_code ec)
+                                        {
+                                            if (ec)
+                                                return;
+                                            beast::error_code ignored;
+                                            self->stream_.socket().cancel(ignored);
+                                        });
+                socket.async_wait(tcp::socket::wait_write, [self = GetSharedThis(), write](beast::error_code ec)
+                                  {
+                                      write->timer.cancel();
+                                      if (ec)
+                                          return self->OnWrite(true, ec, 0);
+                                      self->SendFile(write);
+                                  });
+                return;
+            }
+
+            // Файл стал короче заявленного Content-Length: ответ не дописать, соединение закрываем
+            ec = sent < 0 ? beast::error_code(errno, sys::system_category()) : beast::error_code(sys::errc::io_error, sys::generic_category());
+            return OnWrite(true, ec, 0);
+        }
+
+        OnWrite(write->response.need_eof(), {}, SendfileBody::size(body));
     }
 
     void SessionBase::OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std::size_t bytes_written)
     {
+        writing_ = false;
         if (ec)
         {
+            finished_ = true;
+            UpdateIdleTimer();
             return event_logger::LogServerError(ec, event_logger::Where::WRITE);
         }
 
@@ -44,12 +275,21 @@ namespace http_server
             return Close();
         }
 
-        // Считываем следующий запрос
-        Read();
+        WriteNext();
+        if (!writing_)
+        {
+            if (read_closed_ && responses_.empty() && !held_request_)
+                return Close();
+            // Придержанный запрос на WebSocket ждал отправки всех ответов
+            Resume();
+        }
+        UpdateIdleTimer();
     }
 
     void SessionBase::Close()
     {
+        finished_ = true;
+        UpdateIdleTimer();
         beast::error_code ec;
         stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
     }
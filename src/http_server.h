@@ -2,11 +2,19 @@
 #include "sdk.h"
 #define BOOST_BEAST_USE_STD_STRING_VIEW
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
+#include <boost/beast/websocket.hpp>
+#include <chrono>
+#include <deque>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include "event_logger.h"
+#include "sendfile_body.h"
 
 namespace http_server
 {
@@ -16,6 +24,14 @@ namespace http_server
     namespace beast = boost::beast;
     namespace http = beast::http;
 
+    // Сессия поддерживает конвейер HTTP/1.1: следующие запросы читаются, пока ответы на предыдущие
+    // ещё готовятся, а ответы отправляются строго в порядке запросов через очередь responses_.
+    // Безопасные запросы (GET, HEAD, OPTIONS) обрабатываются параллельно, если среди ещё не отвеченных
+    // нет небезопасных. Небезопасный запрос ждёт ответов на все предыдущие, а запросы после него -
+    // ответа на него: так POST действия игрока виден следующему за ним GET состояния.
+    // Запрос на WebSocket ждёт, пока будут отправлены все предыдущие ответы.
+    // Таймаут чтения отсчитывается, только пока соединение простаивает: очередь ответов пуста
+    // и ничего не пишется. Опережающее чтение не ограничивает ни подготовку, ни отправку ответов
     class SessionBase
     {
         // Напишите недостающий код, используя информацию из урока
@@ -27,17 +43,34 @@ namespace http_server
         void Run();
 
     protected:
-        explicit SessionBase(tcp::socket &&socket)
-            : stream_(std::move(socket))
+        // Больше запросов одного соединения одновременно не обрабатываем: чтение приостанавливается
+        static constexpr size_t maxPipelinedRequests = 16;
+        static constexpr std::chrono::milliseconds defaultTimeout{30000};
+
+        // timeout - сколько соединение может простаивать без нового запроса и сколько может длиться запись ответа
+        explicit SessionBase(tcp::socket &&socket, std::chrono::milliseconds timeout = defaultTimeout)
+            : stream_(std::move(socket)), timeout_{timeout}, idle_timer_{stream_.get_executor()}
         {
         }
 
+        // Ставит ответ на запрос с номером slot в очередь. Можно вызывать из любого потока:
+        // очередь меняется только в executor соединения
+        template <typename Body, typename Fields>
+        void Respond(std::uint64_t slot, http::response<Body, Fields> &&response)
+        {
+            std::unique_ptr<QueuedResponse> queued = std::make_unique<TypedResponse<Body, Fields>>(std::move(response));
+            net::dispatch(stream_.get_executor(), [self = GetSharedThis(), slot, queued = std::move(queued)]() mutable
+                          { self->OnResponseReady(slot, std::move(queued)); });
+        }
+
         template <typename Body, typename Fields>
         void Write(http::response<Body, Fields> &&response)
         {
             // Запись выполняется асинхронно, поэтому response перемещаем в область кучи
             auto safe_response = std::make_shared<http::response<Body, Fields>>(std::move(response));
 
+            // Ожидающее чтение таймаут записи не затрагивает
+            stream_.expires_after(timeout_);
             auto self = GetSharedThis();
             http::async_write(stream_, *safe_response,
                               [safe_response, self](beast::error_code ec, std::size_t bytes_written)
@@ -46,21 +79,91 @@ namespace http_server
                               });
         }
 
+        // Файл отправляется через sendfile(2) после того, как записан заголовок ответа
+        void Write(http::response<SendfileBody> &&response);
+
         using HttpRequest = http::request<http::string_body>;
 
+        // Отдаёт соединение обработчику запроса на переход к WebSocket; после этого
+        // сессия больше не читает из него HTTP-запросы
+        beast::tcp_stream ReleaseStream()
+        {
+            return std::move(stream_);
+        }
+
     private:
+        struct FileWrite;
+
+        // Ответ любого типа в очереди соединения
+        struct QueuedResponse
+        {
+            virtual ~QueuedResponse() = default;
+            virtual void Write(SessionBase &session) = 0;
+        };
+
+        template <typename Body, typename Fields>
+        struct TypedResponse : QueuedResponse
+        {
+            explicit TypedResponse(http::response<Body, Fields> &&response) : response{std::move(response)} {}
+
+            void Write(SessionBase &session) override
+            {
+                session.Write(std::move(response));
+            }
+
+            http::response<Body, Fields> response;
+        };
+
+        // Место ответа в очереди. response пуст, пока обработчик не ответил
+        struct Slot
+        {
+            std::unique_ptr<QueuedResponse> response;
+            bool safe{true};
+        };
+
         void Read();
         void OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read);
+        // Передаёт запрос обработчику, если порядок обработки это позволяет, иначе придерживает его
+        bool CanDispatch(const HttpRequest &request) const;
+        void Dispatch(HttpRequest &&request);
+        void OnResponseReady(std::uint64_t slot, std::unique_ptr<QueuedResponse> response);
+        // Отправляет ответ из головы очереди, если он готов и другой ответ сейчас не пишется
+        void WriteNext();
+        // Обрабатывает придержанный запрос и возобновляет чтение, когда это стало возможно
+        void Resume();
+        // Запускает таймер простоя, если соединение начало простаивать, и останавливает, если перестало
+        void UpdateIdleTimer();
+        void SendFile(std::shared_ptr<FileWrite> write);
         void OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std::size_t bytes_written);
         void Close();
-        // Обработку запроса делегируем подклассу
-        virtual void HandleRequest(HttpRequest &&request) = 0;
+        // Обработку запроса делегируем подклассу. Ответ передаётся в Respond с тем же slot
+        virtual void HandleRequest(HttpRequest &&request, std::uint64_t slot) = 0;
 
         virtual std::shared_ptr<SessionBase> GetSharedThis() = 0;
         // tcp_stream содержит внутри себя сокет и добавляет поддержку таймаутов
         beast::tcp_stream stream_;
+        std::chrono::milliseconds timeout_;
+        net::steady_timer idle_timer_;
+        bool idle_timer_armed_{false};
+        // Чтение прервано таймером простоя
+        bool idle_timed_out_{false};
         beast::flat_buffer buffer_;
         HttpRequest request_;
+
+        // Ответы в порядке запросов; front() - ответ на запрос с номером first_slot_
+        std::deque<Slot> responses_;
+        std::uint64_t first_slot_{0};
+        // Запросы, обработчики которых ещё не ответили, и небезопасные среди них
+        size_t unanswered_{0};
+        size_t unsafe_unanswered_{0};
+        // Прочитанный запрос, который ждёт ответов на предыдущие
+        std::optional<HttpRequest> held_request_;
+        bool reading_{false};
+        bool writing_{false};
+        // Новых запросов не будет: клиент закрыл соединение, запрос требовал закрыть его или чтение не удалось
+        bool read_closed_{false};
+        // Соединение закрыто или передано WebSocket: в него больше ничего не пишем
+        bool finished_{false};
     };
 
     template <typename RequestHandler>
@@ -68,19 +171,26 @@ namespace http_server
     {
     public:
         template <typename Handler>
-        Session(tcp::socket &&socket, Handler &&request_handler)
-            : SessionBase(std::move(socket)), request_handler_(std::forward<Handler>(request_handler))
+        Session(tcp::socket &&socket, Handler &&request_handler, std::chrono::milliseconds timeout = defaultTimeout)
+            : SessionBase(std::move(socket), timeout), request_handler_(std::forward<Handler>(request_handler))
         {
         }
 
     private:
-        void HandleRequest(HttpRequest &&request) override
+        void HandleRequest(HttpRequest &&request, std::uint64_t slot) override
         {
+            if (beast::websocket::is_upgrade(request))
+            {
+                // Запрос на переход к WebSocket получает само соединение вместо функции отправки ответа
+                request_handler_(std::move(request), ReleaseStream());
+                return;
+            }
+
             // Захватываем умный указатель на текущий объект Session в лямбде,
             // чтобы продлить время жизни сессии до вызова лямбды.
             // Используется generic-лямбда функция, способная принять response произвольного типа
-            request_handler_(std::move(request), [self = this->shared_from_this()](auto &&response)
-                             { self->Write(std::move(response)); });
+            request_handler_(std::move(request), [self = this->shared_from_this(), slot](auto &&response)
+                             { self->Respond(slot, std::move(response)); });
         }
 
         std::shared_ptr<SessionBase> GetSharedThis() override
@@ -96,7 +206,7 @@ namespace http_server
     {
     public:
         template <typename Handler>
-        Listener(net::io_context &ioc, const tcp::endpoint &endpoint, Handler &&request_handler)
+        Listener(net::io_context &ioc, const tcp::endpoint &endpoint, Handler &&request_handler, bool reuse_port = false)
             : ioc_(ioc)
               // Обработчики асинхронных операций acceptor_ будут вызываться в своём strand
               ,
@@ -110,6 +220,10 @@ namespace http_server
             // Однако это может помешать повторно открыть сокет в полузакрытом состоянии.
             // Флаг reuse_address разрешает открыть сокет, когда он "наполовину закрыт"
             acceptor_.set_option(net::socket_base::reuse_address(true));
+            // С SO_REUSEPORT на одном адресе слушают несколько acceptor, а входящие соединения
+            // между ними распределяет ядро
+            if (reuse_port)
+                acceptor_.set_option(ReusePort(true));
             // Привязываем acceptor к адресу и порту endpoint
             acceptor_.bind(endpoint);
             // Переводим acceptor в состояние, в котором он способен принимать новые соединения
@@ -123,6 +237,8 @@ namespace http_server
         }
 
     private:
+        using ReusePort = net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+
         void DoAccept()
         {
             acceptor_.async_accept(
@@ -167,14 +283,16 @@ namespace http_server
         RequestHandler request_handler_;
     };
 
+    // reuse_port позволяет вызвать ServeHttp для одного endpoint в нескольких io_context:
+    // у каждого будет свой acceptor, и соединения не проходят через общий для потоков reactor
     template <typename RequestHandler>
-    void ServeHttp(net::io_context &ioc, const tcp::endpoint &endpoint, RequestHandler &&handler)
+    void ServeHttp(net::io_context &ioc, const tcp::endpoint &endpoint, RequestHandler &&handler, bool reuse_port = false)
     {
         // При помощи decay_t исключим ссылки из типа RequestHandler,
         // чтобы Listener хранил RequestHandler по значению
         using MyListener = Listener<std::decay_t<RequestHandler>>;
 
-        std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler))->Run();
+        std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler), reuse_port)->Run();
     }
 
 } // namespace http_server
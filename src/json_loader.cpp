@@ -2,6 +2,7 @@
 #include <fstream>
 #include <boost/json.hpp>
 #include "server_exceptions.h"
+#include "json_serializer.h"
 #include <iostream>
 namespace json = boost::json;
 namespace json_loader
@@ -40,6 +41,7 @@ namespace json_loader
     std::string lootGeneratorConfig = "lootGeneratorConfig";
     std::string probability = "probability";
     std::string bagCapacityDefault = "defaultBagCapacity";
+    std::string interestRadius = "interestRadius";
     std::string maps = "maps";
     std::string move_key = "move";
     std::string period = "period";
@@ -133,6 +135,7 @@ namespace json_loader
         {
             map.AddRoad(road);
         }
+        map.BuildRoadGraph();
 
         auto buildings = ParseObjects<model::Building>(map_object, buildings_key, ParseBuilding);
         for (const auto &building : buildings)
@@ -145,6 +148,7 @@ namespace json_loader
         {
             map.AddOffice(office);
         }
+        map.BuildOfficeLayer();
 
         auto loots = ParseObjects<model::Loot>(map_object, lootTypes, ParseLoot);
         for (const auto &loot : loots)
@@ -191,6 +195,9 @@ namespace json_loader
 
         game.SetDefaultBagCapacity(defaultBagCapacity);
 
+        if (object_to_read.contains(interestRadius))
+            game.SetInterestRadius(object_to_read.at(interestRadius).to_number<double>());
+
         auto arr = value.at(maps).as_array();
 
         for (auto index = 0; index < arr.size(); ++index)
@@ -210,6 +217,8 @@ namespace json_loader
         {
             ParseMaps(json_path, game);
             game.AddBasePath(base_path);
+            // Карты больше не меняются: ответы со списком карт и их описаниями собираются сразу
+            json_serializer::PrecomputeMapResponses(game);
         }
         catch (const std::exception &ex)
         {
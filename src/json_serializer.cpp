@@ -1,7 +1,10 @@
 #include "json_serializer.h"
+#include <algorithm>
 #include <utility>
 #include <boost/json.hpp>
 #include "game_session.h"
+#include "json_writer.h"
+#include "compression.h"
 
 namespace json = boost::json;
 using namespace std::literals;
@@ -50,195 +53,258 @@ namespace json_serializer
 
 	std::string GetPlayerInfoResponce(const std::vector<std::shared_ptr<model::Player>> &players_info)
 	{
-		json::object resp_object;
+		std::string out;
+		out.reserve(players_info.size() * 32 + 2);
+		JsonWriter writer(out);
 
+		writer.BeginObject();
 		for (auto &player : players_info)
 		{
-			json::object name_object;
-			name_object["name"] = player->GetName();
-
-			resp_object[std::to_string(player->GetId())] = name_object;
+			writer.Key(player->GetId()).BeginObject();
+			writer.Key("name").String(player->GetName());
+			writer.EndObject();
 		}
+		writer.EndObject();
 
-		return json::serialize(resp_object);
+		return out;
 	}
 
-	json::array SerializeDogBag(const std::vector<model::LootInfo> &loots)
+	// Оценка размера ответа о состоянии, чтобы буфер не перевыделялся по ходу записи
+	size_t EstimateStateSize(size_t num_players, size_t num_loots)
 	{
-		json::array bag_ar;
+		return 64 + num_players * 128 + num_loots * 64;
+	}
 
+	void WriteDogBag(JsonWriter &writer, const std::vector<model::LootInfo> &loots)
+	{
+		writer.BeginArray();
 		for (const auto &cur_loot : loots)
 		{
-			json::object loot_object;
-
-			loot_object["id"] = cur_loot.id;
-			loot_object["type"] = cur_loot.type;
-
-			bag_ar.emplace_back(loot_object);
+			writer.BeginObject();
+			writer.Key("id").Uint(cur_loot.id);
+			writer.Key("type").Uint(cur_loot.type);
+			writer.EndObject();
 		}
-
-		return bag_ar;
+		writer.EndArray();
 	}
 
-	json::object SerializePlayers(const std::vector<std::shared_ptr<model::Player>> &players)
+	void WritePlayers(JsonWriter &writer, const std::vector<std::shared_ptr<model::Player>> &players)
 	{
-		json::object players_object;
-
+		writer.BeginObject();
 		for (auto &player : players)
 		{
 			auto dog = player->GetDog();
 
-			json::object dog_object;
-			json::array pos_ar, speed_ar;
+			writer.Key(player->GetId()).BeginObject();
 
 			auto pos = dog->GetPosition();
-			pos_ar.emplace_back(pos.x);
-			pos_ar.emplace_back(pos.y);
-
-			dog_object["pos"] = pos_ar;
+			writer.Key("pos").BeginArray().Double(pos.x).Double(pos.y).EndArray();
 
 			auto speed = dog->GetSpeed();
-			speed_ar.emplace_back(speed.vx);
-			speed_ar.emplace_back(speed.vy);
-
-			dog_object["speed"] = speed_ar;
+			writer.Key("speed").BeginArray().Double(speed.vx).Double(speed.vy).EndArray();
 
 			DogDirection dir = dog->GetDirection();
-			dog_object["dir"] = model::ConvertDogDirectionToString(dir);
+			writer.Key("dir").String(model::ConvertDogDirectionToString(dir));
 
-			dog_object["bag"] = SerializeDogBag(dog->GetGatheredLoot());
-			dog_object["score"] = dog->GetScore();
-			players_object[std::to_string(player->GetId())] = dog_object;
+			writer.Key("bag");
+			WriteDogBag(writer, dog->GetGatheredLoot());
+			writer.Key("score").Int(dog->GetScore());
+			writer.EndObject();
 		}
-
-		return players_object;
+		writer.EndObject();
 	}
 
-	json::object SerializeLoots(const std::vector<model::LootInfo> &loots)
+	void WriteLoot(JsonWriter &writer, const model::LootInfo &loot)
 	{
-		json::object loots_object;
+		writer.BeginObject();
+		writer.Key("pos").BeginArray().Double(loot.x).Double(loot.y).EndArray();
+		writer.Key("type").Uint(loot.type);
+		writer.EndObject();
+	}
 
+	void WriteLoots(JsonWriter &writer, const std::vector<model::LootInfo> &loots)
+	{
+		writer.BeginObject();
 		for (size_t i = 0; i < loots.size(); ++i)
 		{
-			json::object loot_object;
-			json::array pos_ar;
+			writer.Key(i);
+			WriteLoot(writer, loots[i]);
+		}
+		writer.EndObject();
+	}
 
-			pos_ar.emplace_back(loots[i].x);
-			pos_ar.emplace_back(loots[i].y);
+	std::string GetPlayersDogInfoResponce(const std::vector<std::shared_ptr<model::Player>> &players, const std::vector<model::LootInfo> &loots)
+	{
+		std::string out;
+		out.reserve(EstimateStateSize(players.size(), loots.size()));
+		JsonWriter writer(out);
+
+		writer.BeginObject();
+		writer.Key("players");
+		WritePlayers(writer, players);
+		writer.Key("lostObjects");
+		WriteLoots(writer, loots);
+		writer.EndObject();
+		return out;
+	}
+	// В потоке версий трофеи адресуются постоянными идентификаторами, а не номером в списке
+	void WriteLootsById(JsonWriter &writer, const std::vector<model::LootInfo> &loots, const std::vector<unsigned> *ids)
+	{
+		writer.BeginObject();
+		for (const auto &loot : loots)
+		{
+			if (ids && !std::binary_search(ids->begin(), ids->end(), loot.id))
+				continue;
 
-			loot_object["pos"] = pos_ar;
-			loot_object["type"] = loots[i].type;
-			loots_object[std::to_string(i)] = loot_object;
+			writer.Key(loot.id);
+			WriteLoot(writer, loot);
 		}
+		writer.EndObject();
+	}
 
-		return loots_object;
+	void WriteIds(JsonWriter &writer, const std::vector<unsigned> &ids)
+	{
+		writer.BeginArray();
+		for (auto id : ids)
+			writer.Uint(id);
+		writer.EndArray();
 	}
 
-	std::string GetPlayersDogInfoResponce(const std::vector<std::shared_ptr<model::Player>> &players, const std::vector<model::LootInfo> &loots)
+	std::string GetPlayersDogDeltaResponce(std::uint64_t version, const std::vector<std::shared_ptr<model::Player>> &players,
+										   const std::vector<model::LootInfo> &loots, const model::StateDelta *delta)
 	{
-		json::object resp_object;
+		std::string out;
+		JsonWriter writer(out);
+		writer.BeginObject();
+		writer.Key("tick").Uint(version);
+		writer.Key("full").Bool(delta == nullptr);
 
-		resp_object["players"] = SerializePlayers(players);
-		resp_object["lostObjects"] = SerializeLoots(loots);
-		return json::serialize(resp_object);
+		if (!delta)
+		{
+			out.reserve(EstimateStateSize(players.size(), loots.size()));
+			writer.Key("players");
+			WritePlayers(writer, players);
+			writer.Key("lostObjects");
+			WriteLootsById(writer, loots, nullptr);
+			writer.EndObject();
+			return out;
+		}
+
+		std::vector<std::shared_ptr<model::Player>> changed_players;
+		for (const auto &player : players)
+		{
+			if (std::binary_search(delta->changed_players.begin(), delta->changed_players.end(), player->GetId()))
+				changed_players.push_back(player);
+		}
+
+		out.reserve(EstimateStateSize(changed_players.size(), delta->added_loots.size()) +
+					(delta->removed_players.size() + delta->removed_loots.size()) * 12);
+		writer.Key("players");
+		WritePlayers(writer, changed_players);
+		writer.Key("removedPlayers");
+		WriteIds(writer, delta->removed_players);
+		writer.Key("lostObjects");
+		WriteLootsById(writer, loots, &delta->added_loots);
+		writer.Key("removedObjects");
+		WriteIds(writer, delta->removed_loots);
+		writer.EndObject();
+		return out;
 	}
-	void SerializeOffices(const model::Map &map, json::object &root)
+
+	void WriteOffices(JsonWriter &writer, const model::Map &map)
 	{
-		json::array offices_ar;
+		writer.Key("offices").BeginArray();
 		for (const auto &office : map.GetOffices())
 		{
-			json::object office_obj;
-
-			office_obj["id"] = *office.GetId();
-			office_obj["x"] = office.GetPosition().x;
-			office_obj["y"] = office.GetPosition().y;
-			office_obj["offsetX"] = office.GetOffset().dx;
-			office_obj["offsetY"] = office.GetOffset().dy;
-
-			offices_ar.emplace_back(office_obj);
+			writer.BeginObject();
+			writer.Key("id").String(*office.GetId());
+			writer.Key("x").Int(office.GetPosition().x);
+			writer.Key("y").Int(office.GetPosition().y);
+			writer.Key("offsetX").Int(office.GetOffset().dx);
+			writer.Key("offsetY").Int(office.GetOffset().dy);
+			writer.EndObject();
 		}
-		root["offices"] = offices_ar;
+		writer.EndArray();
 	}
 
-	void SerializeBuildings(const model::Map &map, json::object &root)
+	void WriteBuildings(JsonWriter &writer, const model::Map &map)
 	{
-		json::array buildings_ar;
+		writer.Key("buildings").BeginArray();
 		for (const auto &building : map.GetBuildings())
 		{
-			json::object building_obj;
-
 			const auto &bounds = building.GetBounds();
 
-			building_obj["x"] = bounds.position.x;
-			building_obj["y"] = bounds.position.y;
-			building_obj["w"] = bounds.size.width;
-			building_obj["h"] = bounds.size.height;
-
-			buildings_ar.emplace_back(building_obj);
+			writer.BeginObject();
+			writer.Key("x").Int(bounds.position.x);
+			writer.Key("y").Int(bounds.position.y);
+			writer.Key("w").Int(bounds.size.width);
+			writer.Key("h").Int(bounds.size.height);
+			writer.EndObject();
 		}
-		root["buildings"] = buildings_ar;
+		writer.EndArray();
 	}
 
-	void SerializeRoads(const model::Map &map, json::object &root)
+	void WriteRoads(JsonWriter &writer, const model::Map &map)
 	{
-		json::array roads_ar;
+		writer.Key("roads").BeginArray();
 		for (const auto &road : map.GetRoads())
 		{
-			json::object road_obj;
-
 			model::Point start = road.GetStart();
 			model::Point end = road.GetEnd();
 
-			road_obj["x0"] = start.x;
-			road_obj["y0"] = start.y;
+			writer.BeginObject();
+			writer.Key("x0").Int(start.x);
+			writer.Key("y0").Int(start.y);
 
 			if (road.IsHorizontal())
-				road_obj["x1"] = end.x;
+				writer.Key("x1").Int(end.x);
 			else
-				road_obj["y1"] = end.y;
-
-			roads_ar.emplace_back(road_obj);
+				writer.Key("y1").Int(end.y);
+			writer.EndObject();
 		}
-		root["roads"] = roads_ar;
+		writer.EndArray();
 	}
 
-	void SerializeLoots(const model::Map &map, json::object &root)
+	void WriteLootTypes(JsonWriter &writer, const model::Map &map)
 	{
-		json::array loots_ar;
+		writer.Key("lootTypes").BeginArray();
 		for (const auto &loot : map.GetLoots())
 		{
-			json::object loot_obj;
-
-			loot_obj["name"] = loot.GetName();
-			loot_obj["file"] = loot.GetFile();
-			loot_obj["type"] = loot.GetType();
+			writer.BeginObject();
+			writer.Key("name").String(loot.GetName());
+			writer.Key("file").String(loot.GetFile());
+			writer.Key("type").String(loot.GetType());
 
 			if (loot.GetRotation() >= 0)
-				loot_obj["rotation"] = loot.GetRotation();
+				writer.Key("rotation").Int(loot.GetRotation());
 
 			if (!loot.GetColor().empty())
-				loot_obj["color"] = loot.GetColor();
+				writer.Key("color").String(loot.GetColor());
 
-			loot_obj["scale"] = loot.GetScale();
-			loot_obj["value"] = loot.GetScore();
-			loots_ar.emplace_back(loot_obj);
+			writer.Key("scale").Double(loot.GetScale());
+			writer.Key("value").Int(loot.GetScore());
+			writer.EndObject();
 		}
-		root["lootTypes"] = loots_ar;
+		writer.EndArray();
 	}
 
 	std::string GetMapListResponce(const model::Game &game)
 	{
-		json::array map_ar;
+		std::string out;
+		out.reserve(game.GetMaps().size() * 48 + 2);
+		JsonWriter writer(out);
+
+		writer.BeginArray();
 		for (const auto &map : game.GetMaps())
 		{
-			json::object map_obj;
-
-			map_obj["id"] = *map.GetId();
-			map_obj["name"] = map.GetName();
-			map_ar.emplace_back(map_obj);
+			writer.BeginObject();
+			writer.Key("id").String(*map.GetId());
+			writer.Key("name").String(map.GetName());
+			writer.EndObject();
 		}
+		writer.EndArray();
 
-		return json::serialize(map_ar);
+		return out;
 	}
 
 	std::string GetMapContentResponce(const model::Game &game, const std::string &map_id)
@@ -248,31 +314,52 @@ namespace json_serializer
 		if (!mapFound)
 			return ("");
 
-		json::object root;
-
-		root["id"] = *mapFound->GetId();
-		root["name"] = mapFound->GetName();
+		std::string out;
+		out.reserve(128 + mapFound->GetRoads().size() * 40 + mapFound->GetBuildings().size() * 40 +
+					mapFound->GetOffices().size() * 64 + mapFound->GetLoots().size() * 128);
+		JsonWriter writer(out);
+
+		writer.BeginObject();
+		writer.Key("id").String(*mapFound->GetId());
+		writer.Key("name").String(mapFound->GetName());
+
+		WriteRoads(writer, *mapFound);
+		WriteBuildings(writer, *mapFound);
+		WriteOffices(writer, *mapFound);
+		WriteLootTypes(writer, *mapFound);
+		writer.EndObject();
+		return out;
+	}
 
-		SerializeRoads(*mapFound, root);
-		SerializeBuildings(*mapFound, root);
-		SerializeOffices(*mapFound, root);
-		SerializeLoots(*mapFound, root);
-		return json::serialize(root);
+	void PrecomputeMapResponses(model::Game &game)
+	{
+		game.SetMapListResponse(compression::MakePrecomputedResponse(GetMapListResponce(game)));
+		for (const auto &map : game.GetMaps())
+			game.SetMapContentResponse(map.GetId(), compression::MakePrecomputedResponse(GetMapContentResponce(game, *map.GetId())));
 	}
 
 	std::string MakeRecordsResponce(const model::Game &game, int start, int max_items)
 	{
-		json::array map_ar;
-		for (const auto &record : game.GetRecords(start, max_items))
-		{
-			json::object map_obj;
+		return MakeRecordsResponce(game.GetRecords(start, max_items));
+	}
 
-			map_obj["name"] = record.name;
-			map_obj["score"] = record.score;
-			map_obj["playTime"] = (double)record.playTime / MILLISECONDS_IN_SECOND;
-			map_ar.emplace_back(map_obj);
+	std::string MakeRecordsResponce(const std::vector<model::PlayerRecordItem> &records)
+	{
+		std::string out;
+		out.reserve(records.size() * 64 + 2);
+		JsonWriter writer(out);
+
+		writer.BeginArray();
+		for (const auto &record : records)
+		{
+			writer.BeginObject();
+			writer.Key("name").String(record.name);
+			writer.Key("score").Int(record.score);
+			writer.Key("playTime").Double((double)record.playTime / MILLISECONDS_IN_SECOND);
+			writer.EndObject();
 		}
+		writer.EndArray();
 
-		return json::serialize(map_ar);
+		return out;
 	}
 } // namespace json_serializer
\ No newline at end of file
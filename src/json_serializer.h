@@ -1,6 +1,7 @@
 #pragma once
 #include <map>
 #include "model.h"
+#include "state_history.h"
 
 namespace model
 {
@@ -15,7 +16,14 @@ namespace json_serializer
 	std::string MakeMappedResponce(const std::map<std::string, std::string> &key_values);
 	std::string GetMapListResponce(const model::Game &game);
 	std::string GetMapContentResponce(const model::Game &game, const std::string &map_id);
+	// Собирает ответы со списком карт и описанием каждой карты вместе с их gzip-вариантами
+	// и сохраняет их в game. Вызывается после загрузки всех карт
+	void PrecomputeMapResponses(model::Game &game);
 	std::string GetPlayerInfoResponce(const std::vector<std::shared_ptr<model::Player>> &players_info);
 	std::string GetPlayersDogInfoResponce(const std::vector<std::shared_ptr<model::Player>> &players, const std::vector<model::LootInfo> &loots);
+	// Состояние версии version: полное при delta == nullptr, иначе только изменения из delta
+	std::string GetPlayersDogDeltaResponce(std::uint64_t version, const std::vector<std::shared_ptr<model::Player>> &players,
+										   const std::vector<model::LootInfo> &loots, const model::StateDelta *delta);
 	std::string MakeRecordsResponce(const model::Game &game, int start, int max_items);
+	std::string MakeRecordsResponce(const std::vector<model::PlayerRecordItem> &records);
 } // namespace json_serializer
\ No newline at end of file
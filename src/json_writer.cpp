@@ -0,0 +1,221 @@
+#include "json_writer.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+
+namespace json_serializer
+{
+	void JsonWriter::Separate()
+	{
+		if (need_comma_)
+			out_.push_back(',');
+	}
+
+	char *JsonWriter::WriteSeparator(char *buffer) const
+	{
+		if (need_comma_)
+			*buffer++ = ',';
+		return buffer;
+	}
+
+	bool JsonWriter::NeedsEscaping(std::string_view value)
+	{
+		return std::any_of(value.begin(), value.end(), [](char c)
+						   { return static_cast<unsigned char>(c) < 0x20 || c == '"' || c == '\\'; });
+	}
+
+	JsonWriter &JsonWriter::BeginObject()
+	{
+		Separate();
+		out_.push_back('{');
+		need_comma_ = false;
+		return *this;
+	}
+
+	JsonWriter &JsonWriter::EndObject()
+	{
+		out_.push_back('}');
+		need_comma_ = true;
+		return *this;
+	}
+
+	JsonWriter &JsonWriter::BeginArray()
+	{
+		Separate();
+		out_.push_back('[');
+		need_comma_ = false;
+		return *this;
+	}
+
+	JsonWriter &JsonWriter::EndArray()
+	{
+		out_.push_back(']');
+		need_comma_ = true;
+		return *this;
+	}
+
+	JsonWriter &JsonWriter::Key(std::string_view key)
+	{
+		// Ключи ответов - короткие литералы без спецсимволов: запятую, кавычки
+		// и двоеточие вместе с ключом дописываем одним вызовом
+		char buffer[smallBufferSize];
+		if (key.size() + 4 <= sizeof(buffer) && !NeedsEscaping(key))
+		{
+			char *end = WriteSeparator(buffer);
+			*end++ = '"';
+			end = std::copy(key.begin(), key.end(), end);
+			*end++ = '"';
+			*end++ = ':';
+			out_.append(buffer, end);
+		}
+		else
+		{
+			Separate();
+			WriteEscaped(key);
+			out_.push_back(':');
+		}
+		need_comma_ = false;
+		return *this;
+	}
+
+	JsonWriter &JsonWriter::Key(std::uint64_t key)
+	{
+		char buffer[smallBufferSize];
+		char *end = WriteSeparator(buffer);
+		*end++ = '"';
+		end = std::to_chars(end, buffer + sizeof(buffer), key).ptr;
+		*end++ = '"';
+		*end++ = ':';
+		out_.append(buffer, end);
+		need_comma_ = false;
+		return *this;
+	}
+
+	JsonWriter &JsonWriter::String(std::string_view value)
+	{
+		Separate();
+		WriteEscaped(value);
+		need_comma_ = true;
+		return *this;
+	}
+
+	JsonWriter &JsonWriter::Int(std::int64_t value)
+	{
+		char buffer[smallBufferSize];
+		char *end = WriteSeparator(buffer);
+		end = std::to_chars(end, buffer + sizeof(buffer), value).ptr;
+		out_.append(buffer, end);
+		need_comma_ = true;
+		return *this;
+	}
+
+	JsonWriter &JsonWriter::Uint(std::uint64_t value)
+	{
+		char buffer[smallBufferSize];
+		char *end = WriteSeparator(buffer);
+		end = std::to_chars(end, buffer + sizeof(buffer), value).ptr;
+		out_.append(buffer, end);
+		need_comma_ = true;
+		return *this;
+	}
+
+	JsonWriter &JsonWriter::Double(double value)
+	{
+		// Как и Boost.JSON, бесконечность записываем заведомо переполняющим числом, а NaN - как null
+		if (std::isnan(value))
+			return Null();
+		if (std::isinf(value))
+		{
+			Separate();
+			out_.append(value < 0 ? "-1e99999" : "1e99999");
+			need_comma_ = true;
+			return *this;
+		}
+
+		// to_chars без точности даёт те же кратчайшие цифры, что и Ryu, но пишет
+		// показатель как "e+01": приводим его к виду Ryu "E1" прямо в буфере
+		char buffer[smallBufferSize];
+		char *begin = WriteSeparator(buffer);
+		char *end = std::to_chars(begin, buffer + sizeof(buffer), value, std::chars_format::scientific).ptr;
+		char *exponent = std::find(begin, end, 'e');
+		char *out = exponent;
+		*out++ = 'E';
+
+		const char *digits = exponent + 1;
+		if (*digits == '-')
+			*out++ = '-';
+		++digits;
+		while (digits + 1 < end && *digits == '0')
+			++digits;
+		out = std::copy(digits, static_cast<const char *>(end), out);
+		out_.append(buffer, out);
+		need_comma_ = true;
+		return *this;
+	}
+
+	JsonWriter &JsonWriter::Bool(bool value)
+	{
+		Separate();
+		out_.append(value ? "true" : "false");
+		need_comma_ = true;
+		return *this;
+	}
+
+	JsonWriter &JsonWriter::Null()
+	{
+		Separate();
+		out_.append("null");
+		need_comma_ = true;
+		return *this;
+	}
+
+	void JsonWriter::WriteEscaped(std::string_view value)
+	{
+		static constexpr char hex[] = "0123456789abcdef";
+
+		out_.push_back('"');
+		// Символы, не требующие экранирования, копируются целыми участками
+		size_t run_start = 0;
+		for (size_t i = 0; i < value.size(); ++i)
+		{
+			const auto c = static_cast<unsigned char>(value[i]);
+			if (c >= 0x20 && c != '"' && c != '\\')
+				continue;
+
+			out_.append(value.data() + run_start, i - run_start);
+			run_start = i + 1;
+
+			switch (c)
+			{
+			case '"':
+				out_.append("\\\"");
+				break;
+			case '\\':
+				out_.append("\\\\");
+				break;
+			case '\b':
+				out_.append("\\b");
+				break;
+			case '\f':
+				out_.append("\\f");
+				break;
+			case '\n':
+				out_.append("\\n");
+				break;
+			case '\r':
+				out_.append("\\r");
+				break;
+			case '\t':
+				out_.append("\\t");
+				break;
+			default:
+			{
+				const char escaped[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+				out_.append(escaped, sizeof(escaped));
+			}
+			}
+		}
+		out_.append(value.data() + run_start, value.size() - run_start);
+		out_.push_back('"');
+	}
+} // namespace json_serializer
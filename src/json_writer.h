@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace json_serializer
+{
+	// Потоковая запись JSON: значения дописываются в строку по мере обхода модели,
+	// без построения дерева json::value и промежуточных строк для ключей и чисел.
+	// Строкой может быть переиспользуемый буфер или тело ответа Beast.
+	// Вывод совпадает с json::serialize байт в байт: те же правила экранирования строк,
+	// а числа с плавающей точкой записываются кратчайшим точным представлением в
+	// формате Ryu ("4E1", "1.5E0", "-2.5E-1"), как это делает Boost.JSON.
+	// Запятые между элементами расставляет сам писатель, поэтому вызовы
+	// должны образовывать корректный документ: Key перед каждым значением объекта
+	class JsonWriter
+	{
+	public:
+		explicit JsonWriter(std::string &out) noexcept : out_{out} {}
+
+		JsonWriter(const JsonWriter &) = delete;
+		JsonWriter &operator=(const JsonWriter &) = delete;
+
+		JsonWriter &BeginObject();
+		JsonWriter &EndObject();
+		JsonWriter &BeginArray();
+		JsonWriter &EndArray();
+
+		JsonWriter &Key(std::string_view key);
+		// Числовой ключ, например идентификатор игрока, без промежуточной std::to_string
+		JsonWriter &Key(std::uint64_t key);
+
+		JsonWriter &String(std::string_view value);
+		JsonWriter &Int(std::int64_t value);
+		JsonWriter &Uint(std::uint64_t value);
+		JsonWriter &Double(double value);
+		JsonWriter &Bool(bool value);
+		JsonWriter &Null();
+
+	private:
+		// Хватает на запятую и любое число или короткий ключ
+		static constexpr size_t smallBufferSize = 64;
+
+		void Separate();
+		// Пишет в buffer запятую, если она нужна, и возвращает конец записанного
+		char *WriteSeparator(char *buffer) const;
+		static bool NeedsEscaping(std::string_view value);
+		void WriteEscaped(std::string_view value);
+
+		std::string &out_;
+		// Перед следующим элементом нужна запятая
+		bool need_comma_{false};
+	};
+} // namespace json_serializer
@@ -0,0 +1,65 @@
+#include "loot_storage.h"
+#include <stdexcept>
+
+namespace model
+{
+	const LootInfo &LootStorage::Add(LootInfo loot)
+	{
+		std::uint32_t slot;
+		if (!free_slots_.empty())
+		{
+			slot = free_slots_.back();
+			free_slots_.pop_back();
+		}
+		else
+		{
+			if (slot_indices_.size() > slotMask)
+				throw std::length_error("Too many loots in a game session");
+
+			slot = static_cast<std::uint32_t>(slot_indices_.size());
+			slot_indices_.push_back(freeSlot);
+			slot_generations_.push_back(0);
+		}
+
+		slot_indices_[slot] = static_cast<std::uint32_t>(loots_.size());
+		loot.id = MakeId(slot, slot_generations_[slot]);
+		loot_slots_.push_back(slot);
+		return loots_.emplace_back(loot);
+	}
+
+	const LootInfo *LootStorage::Find(Id id) const noexcept
+	{
+		const Id slot = id & slotMask;
+		if (slot >= slot_indices_.size() || slot_indices_[slot] == freeSlot || slot_generations_[slot] != id >> slotBits)
+			return nullptr;
+
+		return &loots_[slot_indices_[slot]];
+	}
+
+	bool LootStorage::Remove(Id id) noexcept
+	{
+		if (!Find(id))
+			return false;
+
+		const Id slot = id & slotMask;
+		const std::uint32_t index = slot_indices_[slot];
+		const std::uint32_t last = static_cast<std::uint32_t>(loots_.size() - 1);
+		if (index != last)
+		{
+			// Переносим последний трофей на место удаляемого
+			loots_[index] = loots_[last];
+			loot_slots_[index] = loot_slots_[last];
+			slot_indices_[loot_slots_[index]] = index;
+		}
+		loots_.pop_back();
+		loot_slots_.pop_back();
+
+		slot_indices_[slot] = freeSlot;
+		if (slot_generations_[slot] == maxGeneration)
+			return true;
+
+		++slot_generations_[slot];
+		free_slots_.push_back(slot);
+		return true;
+	}
+}
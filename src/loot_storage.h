@@ -0,0 +1,65 @@
+#pragma once
+#include "model.h"
+#include <cstdint>
+#include <vector>
+#include <boost/serialization/access.hpp>
+#include <boost/serialization/vector.hpp>
+
+namespace model
+{
+    // Хранилище трофеев игровой сессии (slot map).
+    // Трофеи лежат подряд в одном массиве, поэтому их можно обходить при
+    // сериализации и поиске столкновений без пропусков. Удаление переносит
+    // последний трофей на место удалённого, а таблица слотов связывает
+    // идентификатор трофея с его текущим местом в массиве.
+    // Идентификатор состоит из номера слота (младшие slotBits бит) и поколения
+    // слота, которое увеличивается при каждом освобождении, так что
+    // идентификатор удалённого трофея не совпадёт с идентификатором нового.
+    // Слот, поколение которого дошло до максимума, больше не выдаётся:
+    // иначе поколение начиналось бы заново и идентификаторы повторялись.
+    class LootStorage
+    {
+    public:
+        using Id = unsigned;
+
+        // Добавляет трофей, назначая ему новый идентификатор
+        const LootInfo &Add(LootInfo loot);
+        const LootInfo *Find(Id id) const noexcept;
+        bool Remove(Id id) noexcept;
+
+        const std::vector<LootInfo> &GetLoots() const noexcept { return loots_; }
+        size_t Size() const noexcept { return loots_.size(); }
+        bool Empty() const noexcept { return loots_.empty(); }
+
+    private:
+        static constexpr unsigned slotBits = 20;
+        static constexpr Id slotMask = (Id{1} << slotBits) - 1;
+        static constexpr Id maxGeneration = ~Id{0} >> slotBits;
+        static constexpr std::uint32_t freeSlot = ~std::uint32_t{0};
+
+        static Id MakeId(std::uint32_t slot, std::uint32_t generation) noexcept
+        {
+            return (generation << slotBits) | slot;
+        }
+
+        friend class boost::serialization::access;
+
+        template <class Archive>
+        void serialize(Archive &ar, const unsigned int version)
+        {
+            ar &loots_;
+            ar &loot_slots_;
+            ar &slot_indices_;
+            ar &slot_generations_;
+            ar &free_slots_;
+        }
+
+        std::vector<LootInfo> loots_;
+        // Слот каждого трофея из loots_
+        std::vector<std::uint32_t> loot_slots_;
+        // Место трофея слота в loots_ или freeSlot для свободного слота
+        std::vector<std::uint32_t> slot_indices_;
+        std::vector<std::uint32_t> slot_generations_;
+        std::vector<std::uint32_t> free_slots_;
+    };
+}
@@ -6,10 +6,12 @@
 #include "request_handler.h"
 #include "event_logger.h"
 #include "model_serialization.h"
+#include <csignal>
 #include <cstdlib>
 #include "postgres.h"
 #include <memory>
 #include "utility_functions.h"
+#include "utils.h"
 using namespace std::literals;
 namespace net = boost::asio;
 namespace sys = boost::system;
@@ -41,6 +43,9 @@ int main(int argc, const char *argv[])
     if (!args)
         return EXIT_FAILURE;
 
+    if (args->random_seed)
+        utils::SetRandomSeed(*args->random_seed);
+
     try
     {
         postgres::Database db{pqxx::connection{GetConfigFromEnv().db_url}};
@@ -60,35 +65,74 @@ int main(int argc, const char *argv[])
         game.SetSpawnInRandomPoint(args->spawn_random_points);
 
         // 2. Инициализируем io_context
-        const unsigned num_threads = std::thread::hardware_concurrency();
+        const unsigned num_threads = args->threads > 0 ? args->threads : std::thread::hardware_concurrency();
         net::io_context ioc(num_threads);
+        // В режиме reuse-port у каждого рабочего потока свой io_context для HTTP-соединений,
+        // а общий ioc выполняет только игровые strand, таймеры и слежение за статикой
+        std::vector<std::unique_ptr<net::io_context>> http_contexts;
+        if (args->reuse_port)
+        {
+            for (unsigned i = 0; i < std::max(1u, num_threads); ++i)
+                http_contexts.push_back(std::make_unique<net::io_context>(1));
+        }
+        // В режиме core-sessions эти io_context - ядра: каждое владеет сессиями части карт,
+        // а запросы к чужим сессиям передаёт их ядрам через почтовые ящики
+        std::unique_ptr<core_runtime::CoreRuntime> runtime;
+        if (args->core_sessions)
+        {
+            std::vector<net::io_context *> contexts;
+            for (auto &context : http_contexts)
+                contexts.push_back(context.get());
+            runtime = std::make_unique<core_runtime::CoreRuntime>(std::move(contexts));
+            game.SetCoreCount(runtime->GetCoreCount());
+        }
 
         // 3. Добавляем асинхронный обработчик сигналов SIGINT и SIGTERM
         // Подписываемся на сигналы и при их получении завершаем работу сервера
         net::signal_set signals(ioc, SIGINT, SIGTERM);
-        signals.async_wait([&ioc, &game](const sys::error_code &ec, [[maybe_unused]] int signal_number)
+        signals.async_wait([&ioc, &http_contexts, &game](const sys::error_code &ec, [[maybe_unused]] int signal_number)
                            {
         		if (!ec) {
         			ioc.stop();
+        			for (auto &context : http_contexts)
+        				context->stop();
         			SerializeSessions(game);
         			event_logger::LogServerEnd("server exited", EXIT_SUCCESS);
         		} });
 
+        // sendfile, в отличие от send с MSG_NOSIGNAL, посылает SIGPIPE при записи в закрытое клиентом
+        // соединение. Ошибку записи сессия обработает сама, завершать сервер сигналом не нужно
+        std::signal(SIGPIPE, SIG_IGN);
+
         // 4. Создаём обработчик HTTP-запросов и связываем его с моделью игры
-        auto handler = std::make_shared<http_handler::RequestHandler>(game, ioc);
+        auto handler = std::make_shared<http_handler::RequestHandler>(game, ioc, runtime.get());
 
         // 5. Запустить обработчик HTTP-запросов, делегируя их обработчику запросов
         const auto address = net::ip::make_address("0.0.0.0");
         constexpr net::ip::port_type port = 8080;
 
-        http_server::ServeHttp(ioc, {address, port}, [&handler](auto &&req, auto &&send)
-                               { handler->operator()(std::forward<decltype(req)>(req), std::forward<decltype(send)>(send)); });
+        auto serve = [&handler](auto &&req, auto &&send)
+        { handler->operator()(std::forward<decltype(req)>(req), std::forward<decltype(send)>(send)); };
+        if (http_contexts.empty())
+            http_server::ServeHttp(ioc, {address, port}, serve);
+        for (auto &context : http_contexts)
+            http_server::ServeHttp(*context, {address, port}, serve, true);
 
         event_logger::InitLogger();
         // Эта надпись сообщает тестам о том, что сервер запущен и готов обрабатывать запросы
         event_logger::LogStartServer(address.to_string(), port, "server started");
 
         // 6. Запускаем обработку асинхронных операций
+        std::vector<std::jthread> http_workers;
+        http_workers.reserve(http_contexts.size());
+        for (size_t i = 0; i < http_contexts.size(); ++i)
+            http_workers.emplace_back([&http_contexts, &runtime, i]
+                                      {
+                                          if (runtime)
+                                              runtime->Run(i);
+                                          else
+                                              http_contexts[i]->run();
+                                      });
         RunWorkers(std::max(1u, num_threads), [&ioc]
                    { ioc.run(); });
     }
@@ -3,6 +3,9 @@
 #include "model_serialization.h"
 #include <algorithm>
 #include "utility_functions.h"
+#include "road_graph.h"
+#include "collision_detector.h"
+#include "player_tokens.h"
 #include <mutex>
 
 namespace model
@@ -11,6 +14,8 @@ namespace model
 
 	std::recursive_mutex db_update_mutex;
 
+	constexpr double officeWidth = 0.5;
+
 	void Map::AddOffice(const Office &office)
 	{
 		if (warehouse_id_to_index_.contains(office.GetId()))
@@ -30,6 +35,13 @@ namespace model
 			offices_.pop_back();
 			throw;
 		}
+		office_layer_.reset();
+	}
+
+	void Game::SetMapContentResponse(const Map::Id &id, PrecomputedResponse response)
+	{
+		if (auto it = map_id_to_index_.find(id); it != map_id_to_index_.end())
+			maps_[it->second].SetContentResponse(std::move(response));
 	}
 
 	void Game::AddMap(const Map &map)
@@ -53,6 +65,40 @@ namespace model
 		}
 	}
 
+	void Map::BuildRoadGraph()
+	{
+		road_graph_ = std::make_shared<RoadGraph>(roads_);
+	}
+
+	const RoadGraph &Map::GetRoadGraph() const
+	{
+		if (!road_graph_)
+			throw std::logic_error("Road graph has not been built for map "s + *id_);
+
+		return *road_graph_;
+	}
+
+	void Map::BuildOfficeLayer()
+	{
+		std::vector<collision_detector::Item> items;
+		items.reserve(offices_.size());
+		for (size_t i = 0; i < offices_.size(); ++i)
+		{
+			const auto position = offices_[i].GetPosition();
+			items.emplace_back(static_cast<unsigned>(i), geom::Point2D{(double)position.x, (double)position.y},
+							   officeWidth, collision_detector::ItemType::Office);
+		}
+		office_layer_ = std::make_shared<collision_detector::ItemIndex>(std::move(items));
+	}
+
+	const collision_detector::ItemIndex &Map::GetOfficeLayer() const
+	{
+		if (!office_layer_)
+			throw std::logic_error("Office layer has not been built for map "s + *id_);
+
+		return *office_layer_;
+	}
+
 	void Map::AddLoot(Loot loot)
 	{
 		loots_.emplace_back(std::move(loot));
@@ -60,6 +106,7 @@ namespace model
 
 	std::shared_ptr<GameSession> Game::FindSession(const std::string &map_name)
 	{
+		std::shared_lock lock(*sessions_mutex_);
 		auto itFind = std::find_if(sessions_.begin(), sessions_.end(), [&map_name](std::shared_ptr<GameSession> &session)
 								   { return session->GetMap() == map_name; });
 
@@ -73,8 +120,8 @@ namespace model
 	size_t Game::GetNumPlayersInAllSessions()
 	{
 		size_t players_coutner = 0;
-		std::for_each(sessions_.begin(), sessions_.end(), [&players_coutner](std::shared_ptr<GameSession> &session)
-					  { players_coutner += session->GetNumPlayers(); });
+		for (const auto &session : GetSessions())
+			players_coutner += session->GetNumPlayers();
 
 		return players_coutner;
 	}
@@ -93,21 +140,90 @@ namespace model
 		{
 			auto [loot_period, loot_probability] = GetLootParameters();
 			session = std::make_shared<GameSession>(map_id, loot_period, loot_probability);
+			std::lock_guard lock(*sessions_mutex_);
 			sessions_.push_back(session);
 		}
+		const size_t players_before = session->GetNumPlayers();
 		auto player = session->AddPlayer(player_name, const_cast<Map *>(mapToAdd), spawn_in_random_points_, default_bag_capacity_);
+		// Игрок с тем же именем уже в сессии и уже получил токен
+		if (session->GetNumPlayers() != players_before)
+			AssignCoreToken(*player, map_id);
+		IndexPlayerToken(session, player);
 		return {player->GetToken(), player->GetId()};
 	}
 
-	std::shared_ptr<GameSession> Game::GetSessionForToken(const std::string &auth_token)
+	void Game::IndexPlayerToken(const std::shared_ptr<GameSession> &session, const std::shared_ptr<Player> &player)
+	{
+		auto &shard = GetTokenShard(player->GetToken());
+		std::lock_guard lock(shard.mutex);
+		shard.players.insert_or_assign(player->GetToken(), PlayerSession{session, player});
+	}
+
+	void Game::AssignCoreToken(Player &player, const std::string &map_id) const
+	{
+		// Токен остаётся случайным: из равновероятных токенов берём первый, попавший в нужную долю.
+		// В среднем на это уходит столько попыток, сколько ядер
+		const size_t core = GetMapCore(map_id);
+		PlayerTokens tokens;
+		while (GetTokenCore(player.GetToken()) != core)
+			player.SetToken(tokens.GetToken());
+	}
+
+	std::optional<Game::PlayerSession> Game::FindPlayerSession(const std::string &auth_token) const
+	{
+		auto &shard = GetTokenShard(auth_token);
+		std::shared_lock lock(shard.mutex);
+		if (auto it = shard.players.find(auth_token); it != shard.players.end())
+			return it->second;
+
+		return std::nullopt;
+	}
+
+	std::vector<std::unique_ptr<Game::TokenShard>> Game::MakeTokenShards(size_t count)
+	{
+		std::vector<std::unique_ptr<TokenShard>> shards;
+		shards.reserve(count);
+		for (size_t i = 0; i < count; ++i)
+			shards.push_back(std::make_unique<TokenShard>());
+		return shards;
+	}
+
+	void Game::SetCoreCount(size_t count)
+	{
+		auto shards = MakeTokenShards(std::max<size_t>(count, 1));
+		for (auto &shard : token_shards_)
+		{
+			for (auto &[token, player_session] : shard->players)
+				shards[std::hash<std::string_view>{}(token) % shards.size()]->players.emplace(token, std::move(player_session));
+		}
+		token_shards_ = std::move(shards);
+	}
+
+	size_t Game::GetMapCore(const std::string &map_id) const
+	{
+		if (auto it = map_id_to_index_.find(Map::Id(map_id)); it != map_id_to_index_.end())
+			return it->second % token_shards_.size();
+		return 0;
+	}
+
+	size_t Game::GetTokenCore(std::string_view auth_token) const
+	{
+		return std::hash<std::string_view>{}(auth_token) % token_shards_.size();
+	}
+
+	std::vector<std::shared_ptr<GameSession>> Game::GetSessions() const
 	{
-		auto itFind = std::find_if(sessions_.begin(), sessions_.end(), [&auth_token](std::shared_ptr<GameSession> &session)
-								   { return session->HasPlayerWithAuthToken(auth_token) == true; });
+		std::shared_lock lock(*sessions_mutex_);
+		return sessions_;
+	}
 
-		if (itFind == sessions_.end())
+	std::shared_ptr<GameSession> Game::GetSessionForToken(const std::string &auth_token)
+	{
+		const auto player_session = FindPlayerSession(auth_token);
+		if (!player_session)
 			return std::shared_ptr<GameSession>();
 
-		return (*itFind);
+		return player_session->session;
 	}
 
 	const std::vector<std::shared_ptr<Player>> Game::FindAllPlayersForAuthInfo(const std::string &auth_token)
@@ -130,51 +246,32 @@ namespace model
 
 	std::shared_ptr<Player> Game::GetPlayerWithAuthToken(const std::string &auth_token)
 	{
-		auto itFind = std::find_if(sessions_.begin(), sessions_.end(), [&auth_token](std::shared_ptr<GameSession> &session)
-								   { return session->HasPlayerWithAuthToken(auth_token) == true; });
-
-		if (itFind == sessions_.end())
+		const auto player_session = FindPlayerSession(auth_token);
+		if (!player_session)
 			throw PlayerAbsentException();
 
-		return (*itFind)->GetPlayerWithAuthToken(auth_token);
+		return player_session->player;
 	}
 
 	bool Game::HasSessionWithAuthInfo(const std::string &auth_token)
 	{
-		auto itFind = std::find_if(sessions_.begin(), sessions_.end(), [&auth_token](std::shared_ptr<GameSession> &session)
-								   { return session->HasPlayerWithAuthToken(auth_token) == true; });
-
-		if (itFind == sessions_.end())
-			return false;
-
-		return true;
+		return FindPlayerSession(auth_token).has_value();
 	}
 
 	std::shared_ptr<GameSession> Game::GetSessionWithAuthInfo(const std::string &auth_token)
 	{
-		auto itFind = std::find_if(sessions_.begin(), sessions_.end(), [&auth_token](std::shared_ptr<GameSession> &session)
-								   { return session->HasPlayerWithAuthToken(auth_token) == true; });
-
-		if (itFind == sessions_.end())
+		const auto player_session = FindPlayerSession(auth_token);
+		if (!player_session)
 			throw InvalidSessionException();
 
-		return *itFind;
+		return player_session->session;
 	}
 
-	void Game::MoveDogs(int deltaTime)
+	void Game::GenerateLoot(const std::shared_ptr<GameSession> &session, int deltaTime)
 	{
-		std::for_each(sessions_.begin(), sessions_.end(), [deltaTime](std::shared_ptr<GameSession> &session)
-					  { session->MoveDogs(deltaTime); });
-	}
-
-	void Game::GenerateLoot(int deltaTime)
-	{
-		std::for_each(sessions_.begin(), sessions_.end(), [this, deltaTime](std::shared_ptr<GameSession> &session)
-					  {
-		const auto& mapName =  session->GetMap();
-		const Map* pMap = this->FindMap(model::Map::Id(mapName));
-		if(pMap)
-			session->GenerateLoot(deltaTime, pMap); });
+		const Map *pMap = FindMap(model::Map::Id(session->GetMap()));
+		if (pMap)
+			session->GenerateLoot(deltaTime, pMap);
 	}
 
 	void Game::SetLootParameters(double period, double probability)
@@ -186,17 +283,20 @@ namespace model
 	{
 		std::shared_ptr<GameSessionsStates> res = std::make_shared<GameSessionsStates>();
 
-		for (const auto &session : sessions_)
+		for (const auto &session : GetSessions())
 			res->states.push_back(session->GetState());
 
 		return res;
 	}
 
-	void Game::SaveSessions(int deltaTime)
+	bool Game::IsTimeToSave(int deltaTime)
 	{
-		if (!save_period_)
-			return;
-		SerializeSessions(*this, deltaTime, save_period_);
+		return save_period_ && CountTimeWithoutSaving(deltaTime, save_period_);
+	}
+
+	void Game::SaveSessionsStates(const GameSessionsStates &states) const
+	{
+		SerializeSessions(states, save_path_);
 	}
 
 	void Game::RestoreSessions(const model::GameSessionsStates &sessions)
@@ -206,7 +306,7 @@ namespace model
 		auto [loot_period, loot_probability] = GetLootParameters();
 		auto session = std::make_shared<GameSession>(state.map_id_, loot_period, loot_probability);
 		session->SetPlayerId(state.player_id_);
-		session->SetLootsInfo(state.loots_info_state);
+		session->SetLoots(state.loots_state_);
 		const Map* mapToAdd = FindMap(Map::Id(state.map_id_));
 
 		std::for_each(state.player_state_.begin(), state.player_state_.end(),
@@ -223,26 +323,37 @@ namespace model
 					   dog->SetBagCapacity(pl_state.bag_capacity_);
 					   dog->SetScore(pl_state.score_);
 					   dog->SetPlayTime(pl_state.play_time_);
+					   IndexPlayerToken(session, player);
 					 });
 
+		std::lock_guard lock(*sessions_mutex_);
 		sessions_.push_back(session); });
 	}
 
-	void Game::HandleRetiredPlayers()
+	RetiredSessionPlayers Game::RetireExpiredPlayers(const std::shared_ptr<GameSession> &session)
 	{
-		std::lock_guard lg(db_update_mutex);
-		auto expired_players = FindExpiredPlayers();
+		auto expired_players = FindExpiredPlayers({session});
 		if (expired_players.empty())
-			return;
-		SaveExpiredPlayers(expired_players);
+			return {};
+
 		DeleteExpiredPlayers(expired_players);
+		return expired_players.front();
 	}
 
-	std::vector<RetiredSessionPlayers> Game::FindExpiredPlayers()
+	void Game::SaveRetiredPlayers(const std::vector<RetiredSessionPlayers> &retired_players)
+	{
+		if (retired_players.empty())
+			return;
+
+		std::lock_guard lg(db_update_mutex);
+		SaveExpiredPlayers(retired_players);
+	}
+
+	std::vector<RetiredSessionPlayers> Game::FindExpiredPlayers(const std::vector<std::shared_ptr<GameSession>> &sessions)
 	{
 		std::vector<RetiredSessionPlayers> res;
 
-		for (auto itSession = sessions_.begin(); itSession != sessions_.end(); ++itSession)
+		for (auto itSession = sessions.begin(); itSession != sessions.end(); ++itSession)
 		{
 			RetiredSessionPlayers pairs;
 			const auto &players = (*itSession)->GetPlayers();
@@ -279,8 +390,20 @@ namespace model
 
 	void Game::DeleteExpiredPlayers(const std::vector<RetiredSessionPlayers> &expired_sessions_players)
 	{
+		for (const auto &session_players : expired_sessions_players)
+		{
+			for (const auto &player : session_players.second)
+			{
+				auto &shard = GetTokenShard(player->GetToken());
+				std::lock_guard lock(shard.mutex);
+				shard.players.erase(player->GetToken());
+			}
+		}
+
+		std::lock_guard lock(*sessions_mutex_);
 		for (auto itSesPlrs = expired_sessions_players.begin(); itSesPlrs != expired_sessions_players.end(); ++itSesPlrs)
 		{
+
 			auto itSes = std::find_if(sessions_.begin(), sessions_.end(), [itSesPlrs](auto &elem)
 									  { return elem == itSesPlrs->first; });
 
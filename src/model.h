@@ -4,13 +4,22 @@
 #include "tagged.h"
 #include <memory>
 #include <functional>
+#include <unordered_map>
+#include <optional>
+#include <shared_mutex>
+#include <string_view>
 
 namespace model
 {
     class Player;
     class GameSession;
+    class RoadGraph;
     struct GameSessionsStates;
 }
+namespace collision_detector
+{
+    class ItemIndex;
+}
 using RetiredSessionPlayers = std::pair<std::shared_ptr<model::GameSession>, std::vector<std::shared_ptr<model::Player>>>;
 namespace model
 {
@@ -197,6 +206,19 @@ namespace model
         int score_{};
     };
 
+    // Заранее собранный ответ, который не меняется за время работы сервера:
+    // тело, его сжатые gzip и brotli варианты и строгие ETag всех представлений.
+    // Вариант отсутствует, если сжатие не уменьшило размер
+    struct PrecomputedResponse
+    {
+        std::shared_ptr<const std::string> body;
+        std::string etag;
+        std::shared_ptr<const std::string> gzip_body;
+        std::string gzip_etag;
+        std::shared_ptr<const std::string> brotli_body;
+        std::string brotli_etag;
+    };
+
     class Map
     {
     public:
@@ -248,20 +270,32 @@ namespace model
         void AddRoad(const Road &road)
         {
             roads_.emplace_back(road);
+            road_graph_.reset();
         }
 
+        // Граф дорог строится один раз после добавления всех дорог карты
+        void BuildRoadGraph();
+        const RoadGraph &GetRoadGraph() const;
+
         void AddBuilding(const Building &building)
         {
             buildings_.emplace_back(building);
         }
 
         void AddOffice(const Office &office);
+        // Офисы неподвижны, поэтому их слой столкновений строится один раз
+        // после добавления всех офисов карты
+        void BuildOfficeLayer();
+        const collision_detector::ItemIndex &GetOfficeLayer() const;
         void AddLoot(Loot loot);
         size_t GetNumLoots() const noexcept { return loots_.size(); }
         void SetDogSpeed(double speed) { dog_speed_ = speed; }
         double GetDogSpeed() const { return dog_speed_; }
         void SetBagCapacity(unsigned capacity) { bag_capacity_ = capacity; }
         unsigned GetBagCapacity() const noexcept { return bag_capacity_; }
+        // Ответ с описанием карты собирается один раз после загрузки игры
+        void SetContentResponse(PrecomputedResponse response) { content_response_ = std::move(response); }
+        const PrecomputedResponse &GetContentResponse() const noexcept { return content_response_; }
 
     private:
         using OfficeIdToIndex = std::unordered_map<Office::Id, size_t, util::TaggedHasher<Office::Id>>;
@@ -269,13 +303,16 @@ namespace model
         Id id_;
         std::string name_;
         Roads roads_;
+        std::shared_ptr<const RoadGraph> road_graph_;
         Buildings buildings_;
 
         OfficeIdToIndex warehouse_id_to_index_;
         Offices offices_;
+        std::shared_ptr<const collision_detector::ItemIndex> office_layer_;
         Loots loots_;
         double dog_speed_{0.0};
         unsigned bag_capacity_{};
+        PrecomputedResponse content_response_;
     };
 
     struct DogPosition
@@ -320,6 +357,14 @@ namespace model
     public:
         using Maps = std::vector<Map>;
         using PlayerAuthInfo = std::pair<std::string, unsigned int>;
+
+        // Игрок вместе с сессией, в которой он играет. Хранится в индексе по токену
+        struct PlayerSession
+        {
+            std::shared_ptr<GameSession> session;
+            std::shared_ptr<Player> player;
+        };
+
         void AddMap(const Map &map);
 
         void AddBasePath(const std::filesystem::path &base_path)
@@ -347,6 +392,12 @@ namespace model
             return maps_;
         }
 
+        // Список карт и описания карт не меняются после загрузки, поэтому их ответы
+        // собираются один раз (см. json_serializer::PrecomputeMapResponses)
+        void SetMapListResponse(PrecomputedResponse response) { map_list_response_ = std::move(response); }
+        const PrecomputedResponse &GetMapListResponse() const noexcept { return map_list_response_; }
+        void SetMapContentResponse(const Map::Id &id, PrecomputedResponse response);
+
         const Map *FindMap(const Map::Id &id) const noexcept
         {
             if (auto it = map_id_to_index_.find(id); it != map_id_to_index_.end())
@@ -356,6 +407,19 @@ namespace model
             return nullptr;
         }
 
+        // Список сессий защищён мьютексом, так как сессии разных карт обслуживаются параллельно.
+        // Индекс токенов разделён на доли по ядрам (см. SetCoreCount), у каждой доли свой мьютекс.
+        // Игроков внутри сессии поиск не затрагивает
+        std::optional<PlayerSession> FindPlayerSession(const std::string &auth_token) const;
+        // Разделяет сессии и индекс токенов между count ядрами. Сессия карты принадлежит ядру
+        // GetMapCore, токен хранится в доле ядра GetTokenCore. Новые игроки получают токены,
+        // попадающие в долю ядра их карты, поэтому ядро находит своих игроков, не трогая чужих долей.
+        // Токены игроков, восстановленных из сохранения, раскладываются по долям заново
+        void SetCoreCount(size_t count);
+        size_t GetCoreCount() const noexcept { return token_shards_.size(); }
+        size_t GetMapCore(const std::string &map_id) const;
+        size_t GetTokenCore(std::string_view auth_token) const;
+        std::vector<std::shared_ptr<GameSession>> GetSessions() const;
         const std::vector<std::shared_ptr<Player>> FindAllPlayersForAuthInfo(const std::string &auth_token);
         const std::vector<LootInfo> GetLootsForAuthInfo(const std::string &auth_token);
         std::shared_ptr<Player> GetPlayerWithAuthToken(const std::string &auth_token);
@@ -365,8 +429,7 @@ namespace model
         void SetDefaultDogSpeed(double speed) { default_dog_speed_ = speed; }
         double GetDefaultDogSpeed() { return default_dog_speed_; }
         void SetDogRetirementTime(double ret_time) { dog_retierement_time_ = ret_time * 1000; }
-        void MoveDogs(int deltaTime);
-        void GenerateLoot(int deltaTime);
+        void GenerateLoot(const std::shared_ptr<GameSession> &session, int deltaTime);
         void SetTickPeriod(int period) { tick_period_ = period; }
         int GetTickPeriod() { return tick_period_; }
         void SetSpawnInRandomPoint(bool random_spawn) { spawn_in_random_points_ = random_spawn; }
@@ -377,28 +440,55 @@ namespace model
         void SetLootParameters(double period, double probability);
         std::pair<double, double> GetLootParameters() { return {loot_period_, loot_probability_}; }
         void SetDefaultBagCapacity(unsigned capacity) { default_bag_capacity_ = capacity; }
+        // Радиус видимости игрока; 0 - игрок видит всю карту
+        void SetInterestRadius(double radius) { interest_radius_ = radius; }
+        double GetInterestRadius() const { return interest_radius_; }
         std::shared_ptr<GameSessionsStates> GetGameSessionsStates() const;
-        void SaveSessions(int deltaTime);
+        // Отсчитывает время с последнего сохранения и сообщает, пора ли сохранить состояние
+        bool IsTimeToSave(int deltaTime);
+        void SaveSessionsStates(const GameSessionsStates &states) const;
         void RestoreSessions(const model::GameSessionsStates &sessions);
         std::vector<PlayerRecordItem> GetRecords(int start, int max_items) const;
-        void HandleRetiredPlayers();
+        // Удаляет из сессии и индекса токенов игроков, чьи собаки простаивали дольше
+        // допустимого, и возвращает их. Сохранение в базу выполняет SaveRetiredPlayers,
+        // чтобы при параллельном тике сессий записи в базу шли в одном порядке
+        RetiredSessionPlayers RetireExpiredPlayers(const std::shared_ptr<GameSession> &session);
+        void SaveRetiredPlayers(const std::vector<RetiredSessionPlayers> &retired_players);
 
     private:
         std::shared_ptr<GameSession> FindSession(const std::string &map_name);
         std::shared_ptr<GameSession> GetSessionForToken(const std::string &auth_token);
-        std::vector<RetiredSessionPlayers> FindExpiredPlayers();
+        void IndexPlayerToken(const std::shared_ptr<GameSession> &session, const std::shared_ptr<Player> &player);
+        // Выдаёт новому игроку токен из доли ядра, которому принадлежит сессия карты map_id
+        void AssignCoreToken(Player &player, const std::string &map_id) const;
+        std::vector<RetiredSessionPlayers> FindExpiredPlayers(const std::vector<std::shared_ptr<GameSession>> &sessions);
         void SaveExpiredPlayers(const std::vector<RetiredSessionPlayers> &expired_sessions_players);
         void DeleteExpiredPlayers(const std::vector<RetiredSessionPlayers> &expired_sessions_players);
 
     private:
         using MapIdHasher = util::TaggedHasher<Map::Id>;
         using MapIdToIndex = std::unordered_map<Map::Id, size_t, MapIdHasher>;
+        using TokenToPlayer = std::unordered_map<std::string, PlayerSession>;
+
+        // Доля индекса токенов. Выровнена по кэш-линии, чтобы мьютексы разных ядер не делили линию
+        struct alignas(64) TokenShard
+        {
+            std::shared_mutex mutex;
+            TokenToPlayer players;
+        };
+
+        static std::vector<std::unique_ptr<TokenShard>> MakeTokenShards(size_t count);
+        TokenShard &GetTokenShard(std::string_view auth_token) const { return *token_shards_[GetTokenCore(auth_token)]; }
 
         std::vector<Map> maps_;
         MapIdToIndex map_id_to_index_;
         std::filesystem::path base_path_;
         std::filesystem::path save_path_;
+        // Мьютекс хранится в куче, чтобы Game оставался перемещаемым
+        std::unique_ptr<std::shared_mutex> sessions_mutex_{std::make_unique<std::shared_mutex>()};
         std::vector<std::shared_ptr<GameSession>> sessions_;
+        // Доли хранятся в куче по той же причине
+        std::vector<std::unique_ptr<TokenShard>> token_shards_ = MakeTokenShards(1);
         double default_dog_speed_{0.0};
         double dog_retierement_time_{60.0 * 1000};
         int tick_period_{-1};
@@ -407,6 +497,8 @@ namespace model
         double loot_period_{};
         double loot_probability_{};
         unsigned default_bag_capacity_{};
+        double interest_radius_{0.0};
+        PrecomputedResponse map_list_response_;
     };
 }
 // namespace model
\ No newline at end of file
@@ -84,25 +84,29 @@ namespace /*serialization*/
 		game.RestoreSessions(states);
 	}
 
-	void SerializeSessions(const model::Game &game)
+	void SerializeSessions(const model::GameSessionsStates &states, const std::filesystem::path &save_path)
 	{
 		std::stringstream ss;
 		OutputArchive oa{ss};
-		oa << *game.GetGameSessionsStates();
+		oa << states;
 
-		std::ofstream ofs(game.GetSavePath());
+		std::ofstream ofs(save_path);
 		ofs << ss.str();
 	}
 
-	void SerializeSessions(const model::Game &game, int deltaTime, int savePeriod)
+	void SerializeSessions(const model::Game &game)
+	{
+		SerializeSessions(*game.GetGameSessionsStates(), game.GetSavePath());
+	}
+
+	bool CountTimeWithoutSaving(int deltaTime, int savePeriod)
 	{
 		time_without_saving_ += TimeInterval{deltaTime};
 		if (time_without_saving_ < TimeInterval{savePeriod})
-			return;
-
-		SerializeSessions(game);
+			return false;
 
 		time_without_saving_ = {};
+		return true;
 	}
 
 	void SerializeGameSession(const model::GameSession &session)
@@ -0,0 +1,110 @@
+#include "open_file_cache.h"
+#include "static_cache.h"
+#include <iterator>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace static_cache
+{
+	namespace
+	{
+		std::string ToHex(std::uint64_t value)
+		{
+			static constexpr char hex[] = "0123456789abcdef";
+			std::string result;
+			do
+			{
+				result.insert(result.begin(), hex[value & 0xf]);
+				value >>= 4;
+			} while (value != 0);
+			return result;
+		}
+	}
+
+	OpenFile::OpenFile(int fd, std::uint64_t size, std::time_t modified_time)
+		: fd{fd}, size{size}, modified_time{modified_time}, last_modified{FormatHttpDate(modified_time)},
+		  etag{'"' + ToHex(static_cast<std::uint64_t>(modified_time)) + '-' + ToHex(size) + '"'}
+	{
+	}
+
+	OpenFile::~OpenFile()
+	{
+		::close(fd);
+	}
+
+	OpenFileCache::OpenFileCache(std::filesystem::path root, size_t capacity)
+		: root_{std::move(root)}, capacity_{capacity}
+	{
+	}
+
+	std::shared_ptr<const OpenFile> OpenFileCache::Open(const std::string &key)
+	{
+		std::uint64_t generation;
+		{
+			std::lock_guard lock{mutex_};
+			if (auto it = files_.find(key); it != files_.end())
+			{
+				lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+				return it->second.file;
+			}
+			generation = generation_;
+		}
+
+		const auto path = root_ / key;
+		const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			return nullptr;
+		struct stat st{};
+		if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+		{
+			::close(fd);
+			return nullptr;
+		}
+		auto file = std::make_shared<const OpenFile>(fd, static_cast<std::uint64_t>(st.st_size), st.st_mtime);
+
+		std::lock_guard lock{mutex_};
+		if (generation != generation_)
+			return file;
+		if (auto it = files_.find(key); it != files_.end())
+			Erase(it);
+		lru_.push_front(key);
+		files_.emplace(key, Entry{file, lru_.begin()});
+		while (files_.size() > capacity_)
+			Erase(files_.find(lru_.back()));
+		return file;
+	}
+
+	void OpenFileCache::Erase(std::unordered_map<std::string, Entry>::iterator it)
+	{
+		lru_.erase(it->second.lru_position);
+		files_.erase(it);
+	}
+
+	void OpenFileCache::Invalidate(const std::string &key)
+	{
+		std::lock_guard lock{mutex_};
+		++generation_;
+		if (key.empty())
+		{
+			files_.clear();
+			lru_.clear();
+			return;
+		}
+
+		const auto prefix = key + '/';
+		for (auto it = files_.begin(); it != files_.end();)
+		{
+			auto next = std::next(it);
+			if (it->first == key || it->first.starts_with(prefix))
+				Erase(it);
+			it = next;
+		}
+	}
+
+	size_t OpenFileCache::GetSize() const
+	{
+		std::lock_guard lock{mutex_};
+		return files_.size();
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace static_cache
+{
+    // Открытый для чтения файл со сведениями о нём на момент открытия.
+    // Дескриптор закрывается, когда файл перестаёт использовать и кэш, и отправляемые ответы
+    struct OpenFile
+    {
+        OpenFile(int fd, std::uint64_t size, std::time_t modified_time);
+        ~OpenFile();
+
+        OpenFile(const OpenFile &) = delete;
+        OpenFile &operator=(const OpenFile &) = delete;
+
+        int fd;
+        std::uint64_t size;
+        std::time_t modified_time;
+        // Время изменения в формате HTTP-date для заголовка Last-Modified
+        std::string last_modified;
+        // Строгий ETag по времени изменения и размеру: хешировать содержимое больших файлов дорого
+        std::string etag;
+    };
+
+    // Кэш открытых дескрипторов файлов каталога статики. Избавляет от поиска файла по пути
+    // и вызовов open и stat на каждый запрос. Хранит не больше capacity файлов,
+    // давно не запрошенные закрываются. Методы можно вызывать из любого потока
+    class OpenFileCache
+    {
+    public:
+        static constexpr size_t defaultCapacity = 1024;
+
+        explicit OpenFileCache(std::filesystem::path root, size_t capacity = defaultCapacity);
+
+        OpenFileCache(const OpenFileCache &) = delete;
+        OpenFileCache &operator=(const OpenFileCache &) = delete;
+
+        // Файл по пути относительно корня, уже проверенному StaticCache. nullptr, если это не обычный файл
+        std::shared_ptr<const OpenFile> Open(const std::string &key);
+        // Закрывает файл key или, если key - каталог, все файлы внутри него. Пустой key закрывает все файлы
+        void Invalidate(const std::string &key);
+
+        size_t GetSize() const;
+
+    private:
+        struct Entry
+        {
+            std::shared_ptr<const OpenFile> file;
+            std::list<std::string>::iterator lru_position;
+        };
+
+        void Erase(std::unordered_map<std::string, Entry>::iterator it);
+
+        std::filesystem::path root_;
+        size_t capacity_;
+
+        mutable std::mutex mutex_;
+        std::unordered_map<std::string, Entry> files_;
+        // Ключи файлов от недавно запрошенных к давно не запрошенным
+        std::list<std::string> lru_;
+        // Растёт при каждой инвалидации: файл, открытый до неё, в кэш уже не кладём
+        std::uint64_t generation_{0};
+    };
+}
@@ -1,22 +1,20 @@
 #include "player_tokens.h"
-#include <sstream>
+#include <cstdint>
 
 constexpr size_t default_token_size_ = 32;
 
 std::string PlayerTokens::GetToken()
 {
-      auto hexConverter = [](const auto &value) -> std::string
-      {
-            std::stringstream sstream;
-            sstream << std::hex << value;
-            return sstream.str();
-      };
+      static constexpr char hex_digits[] = "0123456789abcdef";
+      thread_local std::random_device random_device;
 
-      std::string token;
-      do
+      std::string token(default_token_size_, '0');
+      for (size_t pos = 0; pos < default_token_size_; pos += 8)
       {
-            token = hexConverter(generator1_()) + hexConverter(generator2_());
-      } while (token.size() != default_token_size_);
+            std::uint32_t value = random_device();
+            for (size_t digit = 0; digit < 8; ++digit, value >>= 4)
+                  token[pos + digit] = hex_digits[value & 0xf];
+      }
 
       return token;
 }
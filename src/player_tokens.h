@@ -11,21 +11,10 @@ namespace detail
 
 using Token = util::Tagged<std::string, detail::TokenTag>;
 
+// Токены авторизации должны быть непредсказуемы, поэтому берутся напрямую из
+// криптостойкого источника std::random_device, а не из быстрого генератора utils
 class PlayerTokens
 {
 public:
     std::string GetToken();
-
-private:
-    std::random_device random_device_;
-    std::mt19937_64 generator1_{[this]
-                                {
-                                    std::uniform_int_distribution<std::mt19937_64::result_type> dist;
-                                    return dist(random_device_);
-                                }()};
-    std::mt19937_64 generator2_{[this]
-                                {
-                                    std::uniform_int_distribution<std::mt19937_64::result_type> dist;
-                                    return dist(random_device_);
-                                }()};
-};
+};
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include "request_handler.h"
+#include <algorithm>
+#include <cctype>
 
 namespace beast = boost::beast;
 namespace http = beast::http;
@@ -48,26 +50,68 @@ namespace http_handler
     return "";
   }
 
-  StaticFileResponce MakeFileResponce(const std::filesystem::path &json_path, const std::string &mime_type)
+  namespace
   {
-    http::response<http::file_body> res;
-    res.version(11); // HTTP/1.1
-    res.result(http::status::ok);
-
-    res.insert(http::field::content_type, mime_type);
+    std::string_view Trim(std::string_view value)
+    {
+      while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+        value.remove_prefix(1);
+      while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+        value.remove_suffix(1);
+      return value;
+    }
 
-    http::file_body::value_type file;
+    // Вызывает handler для каждого элемента списка заголовка, разделённого запятыми
+    template <typename Handler>
+    bool AnyListItem(std::string_view list, Handler &&handler)
+    {
+      while (!list.empty())
+      {
+        const auto comma = list.find(',');
+        if (handler(Trim(list.substr(0, comma))))
+          return true;
+        if (comma == std::string_view::npos)
+          break;
+        list.remove_prefix(comma + 1);
+      }
+      return false;
+    }
 
-    if (sys::error_code ec; file.open(json_path.c_str(), beast::file_mode::read, ec), ec)
+    bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs)
     {
-      std::string reason = "Failed to open file: " + std::string(json_path.c_str());
-      throw std::filesystem::filesystem_error(reason, ec);
+      return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](char a, char b)
+                        { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); });
     }
+  }
 
-    res.body() = std::move(file);
-    // Метод prepare_payload заполняет заголовки Content-Length и Transfer-Encoding
-    // в зависимости от свойств тела сообщения
-    res.prepare_payload();
-    return res;
+  bool AcceptsEncoding(std::string_view accept_encoding, std::string_view coding)
+  {
+    return AnyListItem(accept_encoding, [coding](std::string_view item)
+                       {
+      const auto params = item.find(';');
+      const auto name = Trim(item.substr(0, params));
+      const bool gzip_alias = EqualsIgnoreCase(coding, "gzip") && EqualsIgnoreCase(name, "x-gzip");
+      if (!EqualsIgnoreCase(name, coding) && !gzip_alias && name != "*")
+        return false;
+      if (params == std::string_view::npos)
+        return true;
+
+      // Кодирование с q=0 клиент явно отвергает
+      auto weight = Trim(item.substr(params + 1));
+      if (!weight.starts_with("q=") && !weight.starts_with("Q="))
+        return true;
+      weight.remove_prefix(2);
+      return weight.find_first_not_of("0.") != std::string_view::npos; });
+  }
+
+  bool MatchesETag(std::string_view if_none_match, std::string_view etag)
+  {
+    return AnyListItem(if_none_match, [etag](std::string_view item)
+                       {
+      if (item == "*")
+        return true;
+      if (item.starts_with("W/"))
+        item.remove_prefix(2);
+      return item == etag; });
   }
 } // namespace http_handler
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include "model.h"
 #include "event_logger.h"
 #include "api_handler.h"
+#include "shared_string_body.h"
+#include "static_cache.h"
+#include "byte_ranges.h"
 namespace net = boost::asio;
 
 const std::string_view apiPrefix = "/api/";
@@ -12,20 +15,26 @@ namespace http_handler
 {
 	namespace http = beast::http;
 
-	using StaticFileResponce = http::response<http::file_body>;
-
-	StaticFileResponce MakeFileResponce(const std::filesystem::path &json_path, const std::string &mime_type);
 	std::string_view GetFileExtension(std::string_view path);
 	std::string GetMimeType(std::string_view extension);
 	std::filesystem::path GetResourcePath(std::string_view target);
+	// Принимает ли клиент ответ в кодировании coding ("gzip", "br") по заголовку Accept-Encoding
+	bool AcceptsEncoding(std::string_view accept_encoding, std::string_view coding);
+	// Совпадает ли etag с одним из ETag заголовка If-None-Match (слабое сравнение, как требует RFC 9110)
+	bool MatchesETag(std::string_view if_none_match, std::string_view etag);
 
 	class RequestHandler : public std::enable_shared_from_this<RequestHandler>
 	{
 	public:
-		explicit RequestHandler(model::Game &game, net::io_context &ioc)
-			: game_{game}, strand_(net::make_strand(ioc))
+		// Сколько памяти занимает кэш статических файлов вместе со сжатыми вариантами
+		static constexpr size_t staticCacheCapacity = 64 * 1024 * 1024;
+
+		explicit RequestHandler(model::Game &game, net::io_context &ioc, core_runtime::CoreRuntime *runtime = nullptr)
+			: game_{game}
 		{
-			api_handler_ = std::make_shared<ApiHandler>(game, strand_);
+			api_handler_ = std::make_shared<ApiHandler>(game, ioc, runtime);
+			static_cache_ = std::make_shared<static_cache::StaticCache>(game.GetBasePath(), staticCacheCapacity);
+			static_cache_->Watch(ioc);
 		}
 
 		RequestHandler(const RequestHandler &) = delete;
@@ -38,12 +47,12 @@ namespace http_handler
 
 			if (api_handler_->IsApiRequest(request))
 			{
-				return net::dispatch(strand_, [self = shared_from_this(), request, send, req]
-									 {
-    			    	       // Этот assert не выстрелит, так как лямбда-функция будет выполняться внутри strand
-    			    		   assert(self->strand_.running_in_this_thread());
-    			    	       auto resp = self->api_handler_->HandleApiRequest(request, req.method(), req[http::field::authorization], req.body(), req.version(),req.keep_alive());
-    			    	       send(std::move(resp)); });
+				// Обработчик API сам выбирает strand, в котором будет обработан запрос
+				return api_handler_->HandleApiRequest(request, req.method(), req[http::field::authorization], req[http::field::accept], std::move(req.body()), req.version(), req.keep_alive(),
+													  [send](ApiResponse &&resp)
+													  { std::visit([&send](auto &&response)
+																   { send(std::move(response)); },
+																   std::move(resp)); });
 			}
 
 			if ((req.method() != http::verb::get) && (req.method() != http::verb::head))
@@ -73,63 +82,269 @@ namespace http_handler
 			{
 				target.remove_prefix(mapPrefix.size());
 				if (target.empty())
+					return SendPrecomputedResponse(req, game_.GetMapListResponse(), ContentType::APPLICATION_JSON, std::forward<Send>(send));
+
+				target.remove_prefix(1);
+				if (const auto *map = game_.FindMap(model::Map::Id({target.begin(), target.end()})); map && map->GetContentResponse().body)
+					return SendPrecomputedResponse(req, map->GetContentResponse(), ContentType::APPLICATION_JSON, std::forward<Send>(send));
+
+				resp = MakeStringResponse(http::status::not_found, json_serializer::MakeMapNotFoundResponce(), req.version(), req.keep_alive(), ContentType::APPLICATION_JSON, {{http::field::cache_control, "no-cache"sv}});
+				send(std::move(resp));
+				return;
+			}
+
+			if (!target.starts_with(apiPrefix))
+			{
+				// Параметры запроса файла не выбирают
+				target = target.substr(0, target.find_first_of("?#"));
+				if ((target.size() == 1) && target.starts_with('/'))
+					target = "/index.html";
+
+				auto extension = GetFileExtension(target);
+				std::string mimeType = GetMimeType(extension);
+				if (auto file = static_cache_->Get(target))
+					return SendPrecomputedResponse(req, file->response, mimeType, std::forward<Send>(send), file.get());
+
+				// Файл слишком велик для кэша в памяти: отправляем его с диска
+				if (auto file = static_cache_->Open(target))
+					return SendOpenFile(req, std::move(file), mimeType, std::forward<Send>(send));
+
+				auto notFoundResp = MakeStringResponse(http::status::not_found, json_serializer::MakeMapNotFoundResponce(),
+													   req.version(), req.keep_alive(), ContentType::TEXT_PLAIN);
+				send(std::move(notFoundResp));
+			}
+		}
+
+		// Запрос на переход к WebSocket получает соединение целиком
+		void operator()(http::request<http::string_body> &&req, beast::tcp_stream &&stream)
+		{
+			std::string request = {req.target().begin(), req.target().end()};
+			if (api_handler_->IsWebSocketRequest(request))
+				return api_handler_->HandleWebSocket(std::move(req), std::move(stream));
+
+			// WebSocket доступен только для состояния игры, прочие соединения закрываем
+			beast::error_code ec;
+			stream.socket().shutdown(net::ip::tcp::socket::shutdown_both, ec);
+		}
+
+	private:
+		// Не изменилось ли представление с версии клиента: по If-None-Match, а без него -
+		// по If-Modified-Since, если известно время изменения
+		template <typename Body, typename Allocator>
+		static bool IsNotModified(const http::request<Body, http::basic_fields<Allocator>> &req,
+								  std::string_view etag, std::optional<std::time_t> modified_time)
+		{
+			if (const auto if_none_match = req[http::field::if_none_match]; !if_none_match.empty())
+				return MatchesETag(if_none_match, etag);
+			if (!modified_time)
+				return false;
+			const auto since = static_cache::ParseHttpDate(req[http::field::if_modified_since]);
+			return since && (*modified_time <= *since);
+		}
+
+		// Диапазоны заголовка Range, если их нужно применить к представлению размером size:
+		// только для GET и только если представление не изменилось с указанного в If-Range
+		template <typename Body, typename Allocator>
+		static std::optional<std::vector<byte_ranges::ByteRange>> GetRequestedRanges(const http::request<Body, http::basic_fields<Allocator>> &req,
+																					 std::string_view etag, std::time_t modified_time, std::uint64_t size)
+		{
+			const auto range = req[http::field::range];
+			if ((req.method() != http::verb::get) || range.empty() ||
+				!byte_ranges::IfRangeMatches(req[http::field::if_range], etag, modified_time))
+				return std::nullopt;
+			return byte_ranges::ParseRange(range, size);
+		}
+
+		template <typename Body, typename Allocator, typename SetHeaders, typename Send>
+		static void SendRangeNotSatisfiable(const http::request<Body, http::basic_fields<Allocator>> &req,
+											std::uint64_t size, SetHeaders &&set_headers, Send &&send)
+		{
+			http::response<http::empty_body> resp(http::status::range_not_satisfiable, req.version());
+			set_headers(resp);
+			resp.set(http::field::content_range, byte_ranges::MakeUnsatisfiedContentRange(size));
+			resp.content_length(0);
+			send(std::move(resp));
+		}
+
+		// Отдаёт заранее собранный ответ без копирования тела: сжатый, если клиент принимает brotli или gzip,
+		// 304 без тела, если ETag совпал с If-None-Match, и только заголовки на HEAD.
+		// Статический файл (file) отдаётся и по частям, по заголовку Range; у него есть время изменения,
+		// поэтому без If-None-Match проверяется If-Modified-Since
+		template <typename Body, typename Allocator, typename Send>
+		void SendPrecomputedResponse(const http::request<Body, http::basic_fields<Allocator>> &req,
+									 const model::PrecomputedResponse &precomputed, std::string_view content_type,
+									 Send &&send, const static_cache::CachedFile *file = nullptr)
+		{
+			const auto first_tick = std::chrono::steady_clock::now();
+			// Ответы со статическими файлами попадают в журнал так же, как в SendOpenFile
+			auto send_response = [&](auto &&resp)
+			{
+				const auto status = resp.result();
+				send(std::move(resp));
+				if (file)
+					LogResponseSend(first_tick, status, content_type);
+			};
+
+			const auto accept_encoding = req[http::field::accept_encoding];
+			std::string_view coding;
+			if (precomputed.brotli_body && AcceptsEncoding(accept_encoding, "br"))
+				coding = "br"sv;
+			else if (precomputed.gzip_body && AcceptsEncoding(accept_encoding, "gzip"))
+				coding = "gzip"sv;
+			const auto &body = coding == "br"sv ? precomputed.brotli_body : (coding == "gzip"sv ? precomputed.gzip_body : precomputed.body);
+			const auto &etag = coding == "br"sv ? precomputed.brotli_etag : (coding == "gzip"sv ? precomputed.gzip_etag : precomputed.etag);
+
+			auto set_headers = [&](auto &resp)
+			{
+				resp.set(http::field::cache_control, "no-cache"sv);
+				resp.set(http::field::etag, etag);
+				if (file)
 				{
-					resp = MakeStringResponse(http::status::ok, json_serializer::GetMapListResponce(game_), req.version(), req.keep_alive(), ContentType::APPLICATION_JSON, {{http::field::cache_control, "no-cache"sv}});
+					resp.set(http::field::last_modified, file->last_modified);
+					resp.set(http::field::accept_ranges, "bytes"sv);
+				}
+				if (precomputed.gzip_body || precomputed.brotli_body)
+					resp.set(http::field::vary, "Accept-Encoding"sv);
+				resp.keep_alive(req.keep_alive());
+			};
+
+			const auto modified_time = file ? std::optional<std::time_t>{file->modified_time} : std::nullopt;
+			if (IsNotModified(req, etag, modified_time))
+			{
+				http::response<http::empty_body> resp(http::status::not_modified, req.version());
+				set_headers(resp);
+				return send_response(std::move(resp));
+			}
+
+			auto set_representation = [&](auto &resp)
+			{
+				set_headers(resp);
+				resp.set(http::field::content_type, content_type);
+				if (!coding.empty())
+					resp.set(http::field::content_encoding, coding);
+			};
+
+			if (req.method() == http::verb::head)
+			{
+				http::response<http::empty_body> resp(http::status::ok, req.version());
+				set_representation(resp);
+				resp.content_length(body->size());
+				return send_response(std::move(resp));
+			}
+
+			if (auto ranges = file ? GetRequestedRanges(req, etag, file->modified_time, body->size()) : std::nullopt)
+			{
+				if (ranges->empty())
+					return SendRangeNotSatisfiable(req, body->size(), set_headers, send_response);
+
+				// Диапазоны невелики по сравнению с файлом, поэтому их проще скопировать
+				http::response<http::string_body> resp(http::status::partial_content, req.version());
+				set_representation(resp);
+				const std::string_view data = *body;
+				if (ranges->size() == 1)
+				{
+					const auto &range = ranges->front();
+					resp.set(http::field::content_range, byte_ranges::MakeContentRange(range, data.size()));
+					resp.body() = data.substr(range.offset, range.size);
 				}
 				else
 				{
-					target.remove_prefix(1);
-					const auto &responce = json_serializer::GetMapContentResponce(game_, {target.begin(), target.end()});
-					if (!responce.empty())
+					const auto multipart = byte_ranges::MakeMultipart(*ranges, data.size(), content_type);
+					resp.set(http::field::content_type, multipart.content_type);
+					resp.body().reserve(multipart.size);
+					for (const auto &part : multipart.parts)
 					{
-						if (req.method() == http::verb::get)
-							resp = MakeStringResponse(http::status::ok, responce, req.version(), req.keep_alive(), ContentType::APPLICATION_JSON, {{http::field::cache_control, "no-cache"sv}});
-						else
-							resp = MakeStringResponse(http::status::ok, "", req.version(), req.keep_alive(), ContentType::APPLICATION_JSON, {{http::field::cache_control, "no-cache"sv}});
-					}
-					else
-					{
-						resp = MakeStringResponse(http::status::not_found, json_serializer::MakeMapNotFoundResponce(), req.version(), req.keep_alive(), ContentType::APPLICATION_JSON, {{http::field::cache_control, "no-cache"sv}});
+						resp.body() += part.header;
+						resp.body() += data.substr(part.range.offset, part.range.size);
 					}
+					resp.body() += multipart.closing;
 				}
-				send(std::move(resp));
-				return;
+				resp.prepare_payload();
+				return send_response(std::move(resp));
 			}
 
-			if (!target.starts_with(apiPrefix))
+			http::response<SharedStringBody> resp(http::status::ok, req.version());
+			set_representation(resp);
+			resp.body() = body;
+			resp.prepare_payload();
+			send_response(std::move(resp));
+		}
+
+		// Отдаёт файл с диска: тело отправит сессия через sendfile, на HEAD - только заголовки.
+		// Поддерживает условные запросы и Range, включая несколько диапазонов в multipart/byteranges
+		template <typename Body, typename Allocator, typename Send>
+		void SendOpenFile(const http::request<Body, http::basic_fields<Allocator>> &req,
+						  std::shared_ptr<const static_cache::OpenFile> file, std::string_view content_type, Send &&send)
+		{
+			auto first_tick = std::chrono::steady_clock::now();
+
+			auto set_headers = [&](auto &resp)
 			{
-				try
-				{
-					if ((target.size() == 1) && target.starts_with('/'))
-						target = "/index.html";
+				resp.set(http::field::etag, file->etag);
+				resp.set(http::field::last_modified, file->last_modified);
+				resp.set(http::field::accept_ranges, "bytes"sv);
+				resp.keep_alive(req.keep_alive());
+			};
 
-					auto extension = GetFileExtension(target);
-					std::string mimeType = GetMimeType(extension);
-					std::filesystem::path basePath = game_.GetBasePath();
-					basePath += target;
+			if (IsNotModified(req, file->etag, file->modified_time))
+			{
+				http::response<http::empty_body> resp(http::status::not_modified, req.version());
+				set_headers(resp);
+				return send(std::move(resp));
+			}
 
-					auto first_tick = std::chrono::steady_clock::now();
+			if (req.method() == http::verb::head)
+			{
+				http::response<http::empty_body> resp(http::status::ok, req.version());
+				set_headers(resp);
+				resp.set(http::field::content_type, content_type);
+				resp.content_length(file->size);
+				return send(std::move(resp));
+			}
 
-					auto fileResp = MakeFileResponce(basePath, mimeType);
-					send(std::move(fileResp));
+			http::response<http_server::SendfileBody> resp(http::status::ok, req.version());
+			set_headers(resp);
+			resp.set(http::field::content_type, content_type);
+			if (auto ranges = GetRequestedRanges(req, file->etag, file->modified_time, file->size))
+			{
+				if (ranges->empty())
+					return SendRangeNotSatisfiable(req, file->size, set_headers, std::forward<Send>(send));
 
-					auto last_tick = std::chrono::steady_clock::now();
-					auto time_delta = std::chrono::duration_cast<std::chrono::microseconds>(last_tick - first_tick);
-					event_logger::LogServerResponseSend(time_delta.count(), static_cast<unsigned>(http::status::ok), mimeType);
+				resp.result(http::status::partial_content);
+				if (ranges->size() == 1)
+				{
+					resp.set(http::field::content_range, byte_ranges::MakeContentRange(ranges->front(), file->size));
+					resp.body().parts.push_back({{}, ranges->front()});
 				}
-				catch (const std::filesystem::filesystem_error &ex)
+				else
 				{
-					auto notFoundResp = MakeStringResponse(http::status::not_found, json_serializer::MakeMapNotFoundResponce(),
-														   req.version(), req.keep_alive(), ContentType::TEXT_PLAIN);
-					send(std::move(notFoundResp));
+					auto multipart = byte_ranges::MakeMultipart(*ranges, file->size, content_type);
+					resp.set(http::field::content_type, multipart.content_type);
+					resp.body().parts = std::move(multipart.parts);
+					resp.body().closing = std::move(multipart.closing);
 				}
 			}
+			else
+				resp.body().parts.push_back({{}, {0, file->size}});
+
+			const auto status = resp.result();
+			resp.body().file = std::move(file);
+			resp.prepare_payload();
+			send(std::move(resp));
+			LogResponseSend(first_tick, status, content_type);
+		}
+
+		static void LogResponseSend(std::chrono::steady_clock::time_point first_tick, http::status status,
+									std::string_view content_type)
+		{
+			auto last_tick = std::chrono::steady_clock::now();
+			auto time_delta = std::chrono::duration_cast<std::chrono::microseconds>(last_tick - first_tick);
+			event_logger::LogServerResponseSend(time_delta.count(), static_cast<unsigned>(status), std::string(content_type));
 		}
 
-	private:
-		Strand strand_;
 		model::Game &game_;
 		std::shared_ptr<ApiHandler> api_handler_;
+		std::shared_ptr<static_cache::StaticCache> static_cache_;
 	};
 
 	class SyncWriteOStreamAdapter
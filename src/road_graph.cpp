@@ -0,0 +1,217 @@
+#include "road_graph.h"
+#include <algorithm>
+#include <cmath>
+
+namespace model
+{
+	namespace
+	{
+		constexpr size_t cellsPerRoad = 4;
+
+		bool RoadsCrossed(const model::Road &road1, const model::Road &road2)
+		{
+			if (road1.IsHorizontal() == road2.IsHorizontal())
+				return false;
+
+			const model::Road &horizontal = road1.IsHorizontal() ? road1 : road2;
+			const model::Road &vertical = road1.IsHorizontal() ? road2 : road1;
+
+			auto [x_min, x_max] = std::minmax({horizontal.GetStart().x, horizontal.GetEnd().x});
+			auto [y_min, y_max] = std::minmax({vertical.GetStart().y, vertical.GetEnd().y});
+			const Coord x = vertical.GetStart().x;
+			const Coord y = horizontal.GetStart().y;
+
+			return (x_min <= x) && (x <= x_max) && (y_min <= y) && (y <= y_max);
+		}
+
+		bool RoadsAdjacent(const model::Road &road1, const model::Road &road2)
+		{
+			if ((road1.IsHorizontal() && road2.IsHorizontal()) || (road1.IsVertical() && road2.IsVertical()))
+			{
+				auto first_start = road1.GetStart();
+				auto first_end = road1.GetEnd();
+
+				auto second_start = road2.GetStart();
+				auto second_end = road2.GetEnd();
+
+				if ((first_start == second_start) || (first_start == second_end) ||
+					(first_end == second_start) || (first_end == second_end))
+					return true;
+			}
+			return false;
+		}
+
+		// Координата, по которой перпендикулярная дорога пересекает дорогу
+		Coord GetCrossCoord(const model::Road &cross_road)
+		{
+			return cross_road.IsVertical() ? cross_road.GetStart().x : cross_road.GetStart().y;
+		}
+
+		// Равномерная сетка над дорогами карты. Каждая дорога регистрируется во всех
+		// ячейках, через которые проходит, поэтому пересекающиеся или касающиеся
+		// дороги обязательно окажутся хотя бы в одной общей ячейке.
+		class RoadGrid
+		{
+		public:
+			explicit RoadGrid(const Map::Roads &roads)
+			{
+				if (roads.empty())
+					return;
+
+				Coord x_max = roads.front().GetStart().x;
+				Coord y_max = roads.front().GetStart().y;
+				x_min_ = x_max;
+				y_min_ = y_max;
+				double total_length = 0.0;
+				for (const auto &road : roads)
+				{
+					for (const auto &point : {road.GetStart(), road.GetEnd()})
+					{
+						x_min_ = std::min(x_min_, point.x);
+						y_min_ = std::min(y_min_, point.y);
+						x_max = std::max(x_max, point.x);
+						y_max = std::max(y_max, point.y);
+					}
+					total_length += std::abs(road.GetEnd().x - road.GetStart().x) + std::abs(road.GetEnd().y - road.GetStart().y);
+				}
+
+				// Ячейка не короче средней дороги, а ячеек не больше, чем cellsPerRoad на дорогу
+				const double width = static_cast<double>(x_max - x_min_) + 1.0;
+				const double height = static_cast<double>(y_max - y_min_) + 1.0;
+				double cell_size = std::max(1.0, total_length / roads.size());
+				cell_size = std::max(cell_size, std::sqrt(width * height / (cellsPerRoad * roads.size())));
+				cell_size_ = static_cast<Coord>(std::ceil(cell_size));
+				columns_ = static_cast<size_t>((x_max - x_min_) / cell_size_) + 1;
+				rows_ = static_cast<size_t>((y_max - y_min_) / cell_size_) + 1;
+
+				cell_offsets_.assign(columns_ * rows_ + 1, 0);
+				for (const auto &road : roads)
+					ForEachCell(road, [this](size_t cell)
+								{ ++cell_offsets_[cell + 1]; });
+
+				for (size_t i = 1; i < cell_offsets_.size(); ++i)
+					cell_offsets_[i] += cell_offsets_[i - 1];
+
+				cell_roads_.resize(cell_offsets_.back());
+				std::vector<std::uint32_t> cursor(cell_offsets_.begin(), cell_offsets_.end() - 1);
+				for (size_t i = 0; i < roads.size(); ++i)
+					ForEachCell(roads[i], [this, &cursor, i](size_t cell)
+								{ cell_roads_[cursor[cell]++] = static_cast<std::uint32_t>(i); });
+			}
+
+			// Вызывает fn для индекса каждой дороги, делящей ячейку с дорогой road
+			// (дорога может быть передана несколько раз)
+			template <typename Fn>
+			void ForEachNearbyRoad(const model::Road &road, Fn &&fn) const
+			{
+				ForEachCell(road, [this, &fn](size_t cell)
+							{
+					for (size_t i = cell_offsets_[cell]; i < cell_offsets_[cell + 1]; ++i)
+						fn(cell_roads_[i]); });
+			}
+
+		private:
+			template <typename Fn>
+			void ForEachCell(const model::Road &road, Fn &&fn) const
+			{
+				auto [x0, x1] = std::minmax({road.GetStart().x, road.GetEnd().x});
+				auto [y0, y1] = std::minmax({road.GetStart().y, road.GetEnd().y});
+
+				for (size_t row = GetCell(y0, y_min_); row <= GetCell(y1, y_min_); ++row)
+					for (size_t column = GetCell(x0, x_min_); column <= GetCell(x1, x_min_); ++column)
+						fn(row * columns_ + column);
+			}
+
+			size_t GetCell(Coord coord, Coord origin) const
+			{
+				return static_cast<size_t>((coord - origin) / cell_size_);
+			}
+
+			Coord x_min_{};
+			Coord y_min_{};
+			Coord cell_size_{1};
+			size_t columns_{0};
+			size_t rows_{0};
+			std::vector<std::uint32_t> cell_offsets_;
+			std::vector<std::uint32_t> cell_roads_;
+		};
+
+		// Раскладывает рёбра по дорогам в формат CSR
+		struct Edge
+		{
+			std::uint32_t from;
+			std::uint32_t to;
+		};
+
+		void FillCsr(const std::vector<Edge> &edges, size_t num_roads, RoadType road_type,
+					 std::vector<std::uint32_t> &offsets, std::vector<RoadInfo> &neighbours)
+		{
+			offsets.assign(num_roads + 1, 0);
+			for (const auto &edge : edges)
+				++offsets[edge.from + 1];
+
+			for (size_t i = 1; i < offsets.size(); ++i)
+				offsets[i] += offsets[i - 1];
+
+			neighbours.assign(edges.size(), RoadInfo(0, road_type));
+			std::vector<std::uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+			for (const auto &edge : edges)
+				neighbours[cursor[edge.from]++] = RoadInfo(edge.to, road_type);
+		}
+	}
+
+	RoadGraph::RoadGraph(const Map::Roads &roads)
+	{
+		RoadGrid grid(roads);
+		std::vector<Edge> cross_edges;
+		std::vector<Edge> adjacent_edges;
+
+		// last_seen[j] == i + 1, если пара (i, j) уже проверена
+		std::vector<std::uint32_t> last_seen(roads.size(), 0);
+		for (std::uint32_t i = 0; i < roads.size(); ++i)
+		{
+			grid.ForEachNearbyRoad(roads[i], [&](std::uint32_t j)
+								   {
+				if ((j <= i) || (last_seen[j] == i + 1))
+					return;
+				last_seen[j] = i + 1;
+
+				if (RoadsAdjacent(roads[i], roads[j]))
+				{
+					adjacent_edges.push_back({i, j});
+					adjacent_edges.push_back({j, i});
+				}
+				else if (RoadsCrossed(roads[i], roads[j]))
+				{
+					cross_edges.push_back({i, j});
+					cross_edges.push_back({j, i});
+				} });
+		}
+
+		std::sort(adjacent_edges.begin(), adjacent_edges.end(), [](const Edge &lhs, const Edge &rhs)
+				  { return std::tie(lhs.from, lhs.to) < std::tie(rhs.from, rhs.to); });
+		std::sort(cross_edges.begin(), cross_edges.end(), [&roads](const Edge &lhs, const Edge &rhs)
+				  { return std::make_tuple(lhs.from, GetCrossCoord(roads[lhs.to]), lhs.to) <
+						   std::make_tuple(rhs.from, GetCrossCoord(roads[rhs.to]), rhs.to); });
+
+		FillCsr(adjacent_edges, roads.size(), RoadType::Adjacent, adjacent_offsets_, adjacent_);
+		FillCsr(cross_edges, roads.size(), RoadType::Crossed, cross_offsets_, cross_);
+
+		cross_coords_.reserve(cross_.size());
+		for (const auto &road_info : cross_)
+			cross_coords_.push_back(GetCrossCoord(roads[road_info.road_index]));
+	}
+
+	std::span<const RoadInfo> RoadGraph::GetCrossRoads(size_t road_index, double min_coord, double max_coord) const noexcept
+	{
+		const auto coords_begin = cross_coords_.begin() + cross_offsets_[road_index];
+		const auto coords_end = cross_coords_.begin() + cross_offsets_[road_index + 1];
+
+		const auto first = std::lower_bound(coords_begin, coords_end, min_coord, [](Coord coord, double value)
+											{ return static_cast<double>(coord) < value; });
+		const auto last = std::upper_bound(first, coords_end, max_coord, [](double value, Coord coord)
+										   { return value < static_cast<double>(coord); });
+
+		return {cross_.data() + (first - cross_coords_.begin()), cross_.data() + (last - cross_coords_.begin())};
+	}
+}
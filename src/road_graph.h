@@ -0,0 +1,62 @@
+#pragma once
+#include "model.h"
+#include <cstdint>
+#include <span>
+
+namespace model
+{
+    enum class RoadType : std::uint8_t
+    {
+        Parallel,
+        Adjacent,
+        Crossed
+    };
+
+    struct RoadInfo
+    {
+        std::uint32_t road_index{};
+        RoadType road_type{RoadType::Parallel};
+        RoadInfo(size_t index, RoadType rdType) : road_index(static_cast<std::uint32_t>(index)), road_type(rdType) {}
+    };
+
+    // Граф смежности дорог карты. Строится один раз при загрузке карты и
+    // используется всеми собаками на ней только для чтения.
+    // Списки соседей хранятся подряд в одном массиве (формат CSR):
+    // соседи дороги i лежат в массиве начиная с offsets[i] и до offsets[i + 1].
+    // Пересекающие дорогу перпендикулярные дороги упорядочены по координате
+    // пересечения, поэтому поиск перекрёстка рядом с собакой - двоичный поиск.
+    class RoadGraph
+    {
+    public:
+        explicit RoadGraph(const Map::Roads &roads);
+
+        // Перпендикулярные дороги, пересекающие или касающиеся дороги road_index
+        std::span<const RoadInfo> GetCrossRoads(size_t road_index) const noexcept
+        {
+            return {cross_.data() + cross_offsets_[road_index], cross_.data() + cross_offsets_[road_index + 1]};
+        }
+
+        // Пересекающие дороги, у которых координата пересечения (x для вертикальных,
+        // y для горизонтальных дорог) лежит в отрезке [min_coord, max_coord]
+        std::span<const RoadInfo> GetCrossRoads(size_t road_index, double min_coord, double max_coord) const noexcept;
+
+        // Дороги того же направления, имеющие с дорогой road_index общий конец
+        std::span<const RoadInfo> GetAdjacentRoads(size_t road_index) const noexcept
+        {
+            return {adjacent_.data() + adjacent_offsets_[road_index], adjacent_.data() + adjacent_offsets_[road_index + 1]};
+        }
+
+        size_t GetNumRoads() const noexcept
+        {
+            return cross_offsets_.size() - 1;
+        }
+
+    private:
+        std::vector<std::uint32_t> cross_offsets_;
+        std::vector<RoadInfo> cross_;
+        std::vector<Coord> cross_coords_;
+
+        std::vector<std::uint32_t> adjacent_offsets_;
+        std::vector<RoadInfo> adjacent_;
+    };
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <boost/asio/buffer.hpp>
+#include <boost/beast/http/message.hpp>
+#include <boost/optional.hpp>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+#include "byte_ranges.h"
+#include "open_file_cache.h"
+
+namespace http_server
+{
+    namespace beast = boost::beast;
+    namespace http = beast::http;
+
+    // Тело ответа - диапазоны открытого файла. Перед каждым диапазоном может идти заголовок части
+    // multipart/byteranges, после последнего - завершающий разделитель. SessionBase отправляет
+    // диапазоны через sendfile(2) прямо из страничного кэша в сокет, минуя буферы процесса.
+    // writer читает файл через pread и нужен, только если ответ сериализуют обычным путём
+    struct SendfileBody
+    {
+        struct value_type
+        {
+            std::shared_ptr<const static_cache::OpenFile> file;
+            std::vector<byte_ranges::Part> parts;
+            std::string closing;
+        };
+
+        // Кусок тела: текст или диапазон файла
+        struct Piece
+        {
+            std::string_view text;
+            byte_ranges::ByteRange range;
+        };
+
+        // Тело - последовательность кусков: заголовок части, её диапазон, ..., завершающий разделитель
+        static size_t PieceCount(const value_type &body)
+        {
+            return body.parts.size() * 2 + 1;
+        }
+
+        static Piece GetPiece(const value_type &body, size_t index)
+        {
+            if (index == body.parts.size() * 2)
+                return {body.closing, {}};
+            const auto &part = body.parts[index / 2];
+            if (index % 2 == 0)
+                return {part.header, {}};
+            return {{}, part.range};
+        }
+
+        static std::uint64_t size(const value_type &body)
+        {
+            std::uint64_t result = body.closing.size();
+            for (const auto &part : body.parts)
+                result += part.header.size() + part.range.size;
+            return result;
+        }
+
+        class writer
+        {
+        public:
+            using const_buffers_type = boost::asio::const_buffer;
+
+            template <bool isRequest, class Fields>
+            writer(const http::header<isRequest, Fields> &, const value_type &body)
+                : body_{body}
+            {
+            }
+
+            void init(beast::error_code &ec)
+            {
+                ec = {};
+            }
+
+            boost::optional<std::pair<const_buffers_type, bool>> get(beast::error_code &ec)
+            {
+                ec = {};
+                const size_t count = PieceCount(body_);
+                while (piece_ < count)
+                {
+                    const auto piece = GetPiece(body_, piece_);
+                    const bool more = piece_ + 1 < count;
+                    if (!piece.text.empty())
+                    {
+                        ++piece_;
+                        return {{const_buffers_type{piece.text.data(), piece.text.size()}, more}};
+                    }
+
+                    const auto remaining = piece.range.size - position_;
+                    if (remaining == 0)
+                    {
+                        ++piece_;
+                        position_ = 0;
+                        continue;
+                    }
+
+                    const auto amount = static_cast<size_t>(std::min<std::uint64_t>(remaining, buffer_.size()));
+                    const auto read = ::pread(body_.file->fd, buffer_.data(), amount, static_cast<off_t>(piece.range.offset + position_));
+                    if (read <= 0)
+                    {
+                        // Файл стал короче заголовка Content-Length: дописать ответ уже нельзя
+                        ec = read < 0 ? beast::error_code(errno, boost::system::system_category())
+                                      : beast::error_code(boost::system::errc::io_error, boost::system::generic_category());
+                        return boost::none;
+                    }
+                    position_ += static_cast<std::uint64_t>(read);
+                    return {{const_buffers_type{buffer_.data(), static_cast<size_t>(read)}, true}};
+                }
+                return boost::none;
+            }
+
+        private:
+            const value_type &body_;
+            size_t piece_{0};
+            std::uint64_t position_{0};
+            std::array<char, 64 * 1024> buffer_;
+        };
+    };
+}
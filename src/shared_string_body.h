@@ -0,0 +1,54 @@
+#pragma once
+#include <boost/asio/buffer.hpp>
+#include <boost/beast/http/message.hpp>
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace http_handler
+{
+    namespace beast = boost::beast;
+    namespace http = beast::http;
+
+    // Тело ответа Beast, которое ссылается на общую неизменяемую строку, а не владеет копией.
+    // Подходит для заранее собранных ответов: каждый запрос лишь увеличивает счётчик ссылок
+    struct SharedStringBody
+    {
+        using value_type = std::shared_ptr<const std::string>;
+
+        static std::uint64_t size(const value_type &body)
+        {
+            return body ? body->size() : 0;
+        }
+
+        class writer
+        {
+        public:
+            using const_buffers_type = boost::asio::const_buffer;
+
+            template <bool isRequest, class Fields>
+            writer(const http::header<isRequest, Fields> &, const value_type &body)
+                : body_{body}
+            {
+            }
+
+            void init(beast::error_code &ec)
+            {
+                ec = {};
+            }
+
+            boost::optional<std::pair<const_buffers_type, bool>> get(beast::error_code &ec)
+            {
+                ec = {};
+                if (!body_ || body_->empty())
+                    return boost::none;
+                return {{const_buffers_type{body_->data(), body_->size()}, false}};
+            }
+
+        private:
+            const value_type &body_;
+        };
+    };
+}
@@ -0,0 +1,61 @@
+#include "spatial_grid.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace model
+{
+	SpatialGrid::SpatialGrid(double cell_size, std::vector<geom::Point2D> points)
+		: cell_size_(cell_size), points_(std::move(points))
+	{
+		if (!(cell_size_ > 0.0))
+			throw std::invalid_argument("Cell size must be positive");
+
+		entries_.reserve(points_.size());
+		for (size_t i = 0; i < points_.size(); ++i)
+		{
+			entries_.push_back(Entry{MakeCellKey(GetCellCoord(points_[i].x), GetCellCoord(points_[i].y)),
+									 static_cast<std::uint32_t>(i)});
+		}
+		std::sort(entries_.begin(), entries_.end(), [](const Entry &lhs, const Entry &rhs)
+				  { return lhs.cell < rhs.cell || (lhs.cell == rhs.cell && lhs.index < rhs.index); });
+	}
+
+	std::int32_t SpatialGrid::GetCellCoord(double coord) const
+	{
+		return static_cast<std::int32_t>(std::floor(coord / cell_size_));
+	}
+
+	std::uint64_t SpatialGrid::MakeCellKey(std::int32_t cx, std::int32_t cy)
+	{
+		return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(cx)) << 32) | static_cast<std::uint32_t>(cy);
+	}
+
+	std::vector<size_t> SpatialGrid::Query(geom::Point2D center, double radius) const
+	{
+		std::vector<size_t> res;
+		const double radius2 = radius * radius;
+		const auto min_x = GetCellCoord(center.x - radius), max_x = GetCellCoord(center.x + radius);
+		const auto min_y = GetCellCoord(center.y - radius), max_y = GetCellCoord(center.y + radius);
+
+		for (auto cx = min_x; cx <= max_x; ++cx)
+		{
+			for (auto cy = min_y; cy <= max_y; ++cy)
+			{
+				const auto cell = MakeCellKey(cx, cy);
+				auto it = std::lower_bound(entries_.begin(), entries_.end(), cell, [](const Entry &entry, std::uint64_t key)
+										   { return entry.cell < key; });
+				for (; it != entries_.end() && it->cell == cell; ++it)
+				{
+					const auto &point = points_[it->index];
+					const double dx = point.x - center.x, dy = point.y - center.y;
+					if (dx * dx + dy * dy <= radius2)
+						res.push_back(it->index);
+				}
+			}
+		}
+
+		std::sort(res.begin(), res.end());
+		return res;
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "geom.h"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace model
+{
+    // Равномерная сетка для поиска точек в окрестности. Хранит только занятые клетки:
+    // записи отсортированы по номеру клетки, поэтому память пропорциональна числу
+    // точек, а не площади карты. Запрос просматривает клетки, покрывающие круг
+    class SpatialGrid
+    {
+    public:
+        SpatialGrid(double cell_size, std::vector<geom::Point2D> points);
+
+        // Номера точек, лежащих не дальше radius от center, по возрастанию
+        std::vector<size_t> Query(geom::Point2D center, double radius) const;
+        size_t Size() const noexcept { return points_.size(); }
+
+    private:
+        struct Entry
+        {
+            std::uint64_t cell;
+            std::uint32_t index;
+        };
+
+        std::int32_t GetCellCoord(double coord) const;
+        static std::uint64_t MakeCellKey(std::int32_t cx, std::int32_t cy);
+
+        double cell_size_;
+        std::vector<geom::Point2D> points_;
+        std::vector<Entry> entries_;
+    };
+}
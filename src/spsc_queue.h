@@ -0,0 +1,75 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace core_runtime
+{
+    // Ограниченная очередь без блокировок для одного писателя и одного читателя.
+    // TryPush вызывает только поток-писатель, TryPop - только поток-читатель.
+    // Индексы писателя и читателя лежат в разных кэш-линиях, а каждая сторона
+    // помнит последний увиденный индекс другой и перечитывает его, только когда
+    // очередь по её сведениям пуста или заполнена
+    template <typename T>
+    class SpscQueue
+    {
+    public:
+        // Ёмкость округляется вверх до степени двойки
+        explicit SpscQueue(size_t capacity)
+            : slots_(std::bit_ceil(std::max<size_t>(capacity, 1))), mask_{slots_.size() - 1}
+        {
+        }
+
+        SpscQueue(const SpscQueue &) = delete;
+        SpscQueue &operator=(const SpscQueue &) = delete;
+
+        // false, если очередь заполнена; value в этом случае не изменяется
+        bool TryPush(T &&value)
+        {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - producer_head_ == slots_.size())
+            {
+                producer_head_ = head_.load(std::memory_order_acquire);
+                if (tail - producer_head_ == slots_.size())
+                    return false;
+            }
+            slots_[tail & mask_] = std::move(value);
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // false, если очередь пуста
+        bool TryPop(T &value)
+        {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            if (head == consumer_tail_)
+            {
+                consumer_tail_ = tail_.load(std::memory_order_acquire);
+                if (head == consumer_tail_)
+                    return false;
+            }
+            value = std::move(slots_[head & mask_]);
+            // Ячейка не должна удерживать ресурсы прочитанного значения до следующего круга
+            slots_[head & mask_] = T{};
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        size_t GetCapacity() const noexcept { return slots_.size(); }
+
+    private:
+        static constexpr size_t cacheLineSize = 64;
+
+        std::vector<T> slots_;
+        const size_t mask_;
+        // Изменяется читателем
+        alignas(cacheLineSize) std::atomic<size_t> head_{0};
+        size_t consumer_tail_{0};
+        // Изменяется писателем
+        alignas(cacheLineSize) std::atomic<size_t> tail_{0};
+        size_t producer_head_{0};
+    };
+}
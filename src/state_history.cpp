@@ -0,0 +1,127 @@
+#include "state_history.h"
+#include "game_session.h"
+#include <algorithm>
+#include <iterator>
+#include <unordered_set>
+
+namespace model
+{
+	namespace
+	{
+		std::vector<unsigned> GetBagIds(const Dog &dog)
+		{
+			std::vector<unsigned> ids;
+			ids.reserve(dog.GetGatheredLoot().size());
+			for (const auto &loot : dog.GetGatheredLoot())
+				ids.push_back(loot.id);
+			return ids;
+		}
+
+		bool IsSamePosition(const DogPos &lhs, const DogPos &rhs)
+		{
+			return lhs.curr_position.x == rhs.curr_position.x && lhs.curr_position.y == rhs.curr_position.y &&
+				   lhs.curr_speed.vx == rhs.curr_speed.vx && lhs.curr_speed.vy == rhs.curr_speed.vy;
+		}
+	}
+
+	bool StateHistory::IsSameDog(const DogRecord &record, const Dog &dog)
+	{
+		if (!IsSamePosition(record.position, dog.GetPositionOnMap()) || record.direction != dog.GetDirection() ||
+			record.score != dog.GetScore())
+			return false;
+
+		const auto &bag = dog.GetGatheredLoot();
+		return std::equal(record.bag.begin(), record.bag.end(), bag.begin(), bag.end(),
+						  [](unsigned id, const LootInfo &loot)
+						  { return id == loot.id; });
+	}
+
+	std::uint64_t StateHistory::Commit(const std::vector<std::shared_ptr<Player>> &players, const LootStorage &loots)
+	{
+		StateDelta delta;
+		const std::uint64_t version = version_ + 1;
+
+		for (const auto &player : players)
+		{
+			const auto dog = player->GetDog();
+			auto [it, inserted] = dogs_.try_emplace(player->GetId());
+			DogRecord &record = it->second;
+			if (inserted || !IsSameDog(record, *dog))
+			{
+				record.position = dog->GetPositionOnMap();
+				record.direction = dog->GetDirection();
+				record.score = dog->GetScore();
+				record.bag = GetBagIds(*dog);
+				delta.changed_players.push_back(player->GetId());
+			}
+			record.seen = version;
+		}
+
+		for (auto it = dogs_.begin(); it != dogs_.end();)
+		{
+			if (it->second.seen == version)
+			{
+				++it;
+				continue;
+			}
+			delta.removed_players.push_back(it->first);
+			it = dogs_.erase(it);
+		}
+
+		std::vector<LootStorage::Id> loot_ids;
+		loot_ids.reserve(loots.Size());
+		for (const auto &loot : loots.GetLoots())
+			loot_ids.push_back(loot.id);
+		std::sort(loot_ids.begin(), loot_ids.end());
+
+		std::set_difference(loot_ids.begin(), loot_ids.end(), loot_ids_.begin(), loot_ids_.end(),
+							std::back_inserter(delta.added_loots));
+		std::set_difference(loot_ids_.begin(), loot_ids_.end(), loot_ids.begin(), loot_ids.end(),
+							std::back_inserter(delta.removed_loots));
+		loot_ids_ = std::move(loot_ids);
+
+		diffs_.push_back(std::move(delta));
+		if (diffs_.size() > depth_)
+			diffs_.pop_front();
+
+		version_ = version;
+		return version_;
+	}
+
+	std::optional<StateDelta> StateHistory::GetDelta(std::uint64_t since) const
+	{
+		if (since > version_ || version_ - since > diffs_.size())
+			return std::nullopt;
+
+		std::unordered_set<unsigned> changed, removed;
+		std::unordered_set<LootStorage::Id> added_loots, removed_loots;
+		for (auto it = diffs_.end() - static_cast<std::ptrdiff_t>(version_ - since); it != diffs_.end(); ++it)
+		{
+			changed.insert(it->changed_players.begin(), it->changed_players.end());
+			removed.insert(it->removed_players.begin(), it->removed_players.end());
+			added_loots.insert(it->added_loots.begin(), it->added_loots.end());
+			for (auto id : it->removed_loots)
+			{
+				// Трофей, появившийся и исчезнувший внутри окна, клиент не видел
+				if (added_loots.erase(id) == 0)
+					removed_loots.insert(id);
+			}
+		}
+
+		StateDelta res;
+		for (auto id : changed)
+		{
+			if (!removed.count(id))
+				res.changed_players.push_back(id);
+		}
+		res.removed_players.assign(removed.begin(), removed.end());
+		res.added_loots.assign(added_loots.begin(), added_loots.end());
+		res.removed_loots.assign(removed_loots.begin(), removed_loots.end());
+
+		std::sort(res.changed_players.begin(), res.changed_players.end());
+		std::sort(res.removed_players.begin(), res.removed_players.end());
+		std::sort(res.added_loots.begin(), res.added_loots.end());
+		std::sort(res.removed_loots.begin(), res.removed_loots.end());
+		return res;
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "model.h"
+#include "loot_storage.h"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace model
+{
+    class Player;
+    class Dog;
+
+    // Изменения состояния сессии между двумя версиями
+    struct StateDelta
+    {
+        // Игроки, у которых изменились положение, скорость, направление, рюкзак или очки
+        std::vector<unsigned> changed_players;
+        std::vector<unsigned> removed_players;
+        std::vector<LootStorage::Id> added_loots;
+        std::vector<LootStorage::Id> removed_loots;
+    };
+
+    // История версий состояния сессии. Каждая зафиксированная версия хранит
+    // только отличия от предыдущей, а кольцо последних depth отличий позволяет
+    // выдать клиенту изменения с известной ему версии без полного состояния.
+    // Сессия фиксирует версию раз в конце каждого тика, поэтому версия - это номер тика
+    class StateHistory
+    {
+    public:
+        static constexpr size_t defaultDepth = 64;
+
+        explicit StateHistory(size_t depth = defaultDepth) : depth_{depth} {}
+
+        // Сравнивает текущее состояние с предыдущей версией и фиксирует новую версию
+        std::uint64_t Commit(const std::vector<std::shared_ptr<Player>> &players, const LootStorage &loots);
+        std::uint64_t GetVersion() const noexcept { return version_; }
+        // Изменения от версии since до текущей. Пусто, если since уже выпала из кольца
+        // или ещё не наступила: тогда клиенту нужно полное состояние
+        std::optional<StateDelta> GetDelta(std::uint64_t since) const;
+
+    private:
+        struct DogRecord
+        {
+            DogPos position;
+            DogDirection direction{DogDirection::NORTH};
+            int score{0};
+            std::vector<unsigned> bag;
+            std::uint64_t seen{0};
+        };
+
+        static bool IsSameDog(const DogRecord &record, const Dog &dog);
+
+        size_t depth_;
+        std::uint64_t version_{0};
+        std::unordered_map<unsigned, DogRecord> dogs_;
+        // Идентификаторы трофеев последней версии, по возрастанию
+        std::vector<LootStorage::Id> loot_ids_;
+        // diffs_.back() переводит версию version_ - 1 в version_
+        std::deque<StateDelta> diffs_;
+    };
+}
@@ -0,0 +1,413 @@
+#include "static_cache.h"
+#include "compression.h"
+#include "event_logger.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <locale>
+#include <sstream>
+#include <unordered_set>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+namespace static_cache
+{
+	namespace fs = std::filesystem;
+
+	namespace
+	{
+		// Форматы, которые уже сжаты: gzip и brotli их почти не уменьшают
+		const std::unordered_set<std::string_view> compressedExtensions{
+			".png", ".jpg", ".jpe", ".jpeg", ".gif", ".ico", ".mp3", ".svgz"};
+
+		constexpr std::uint32_t watchMask = IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE |
+											IN_MOVED_FROM | IN_MOVED_TO | IN_MOVE_SELF;
+
+		constexpr std::string_view inotifyWhere = "inotify";
+
+		bool IsCompressible(const fs::path &path)
+		{
+			auto extension = path.extension().string();
+			std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c)
+						   { return static_cast<char>(std::tolower(c)); });
+			return !compressedExtensions.contains(extension);
+		}
+
+		size_t GetResponseSize(const model::PrecomputedResponse &response)
+		{
+			size_t size = response.body->size();
+			if (response.gzip_body)
+				size += response.gzip_body->size();
+			if (response.brotli_body)
+				size += response.brotli_body->size();
+			return size;
+		}
+
+		int HexValue(char c)
+		{
+			if (c >= '0' && c <= '9')
+				return c - '0';
+			if (c >= 'a' && c <= 'f')
+				return c - 'a' + 10;
+			if (c >= 'A' && c <= 'F')
+				return c - 'A' + 10;
+			return -1;
+		}
+
+		std::optional<std::string> DecodePercent(std::string_view value)
+		{
+			std::string result;
+			result.reserve(value.size());
+			for (size_t i = 0; i < value.size(); ++i)
+			{
+				if (value[i] != '%')
+				{
+					result.push_back(value[i]);
+					continue;
+				}
+				if (i + 2 >= value.size())
+					return std::nullopt;
+				const int high = HexValue(value[i + 1]);
+				const int low = HexValue(value[i + 2]);
+				if (high < 0 || low < 0)
+					return std::nullopt;
+				result.push_back(static_cast<char>(high * 16 + low));
+				i += 2;
+			}
+			return result;
+		}
+	}
+
+	std::string FormatHttpDate(std::time_t time)
+	{
+		std::tm tm{};
+		gmtime_r(&time, &tm);
+		char buffer[32];
+		const auto size = std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+		return {buffer, size};
+	}
+
+	std::optional<std::time_t> ParseHttpDate(std::string_view date)
+	{
+		std::tm tm{};
+		std::istringstream input{std::string(date)};
+		input.imbue(std::locale::classic());
+		input >> std::get_time(&tm, "%a, %d %b %Y %H:%M:%S GMT");
+		if (input.fail())
+			return std::nullopt;
+		return timegm(&tm);
+	}
+
+	StaticCache::StaticCache(fs::path root, size_t capacity)
+		: root_{std::move(root)}, capacity_{capacity}, open_files_{root_}
+	{
+		std::error_code ec;
+		for (fs::recursive_directory_iterator it(root_, fs::directory_options::skip_permission_denied, ec), end;
+			 !ec && it != end; it.increment(ec))
+		{
+			std::error_code file_ec;
+			if (!it->is_regular_file(file_ec))
+				continue;
+			const auto file_size = it->file_size(file_ec);
+			if (file_ec || size_ + file_size > capacity_)
+				continue;
+
+			const auto key = it->path().lexically_relative(root_).generic_string();
+			if (auto file = Load(key, true); file && (size_ + file->size <= capacity_))
+			{
+				std::lock_guard lock{mutex_};
+				Insert(key, std::move(file));
+			}
+		}
+
+		compressor_ = std::jthread([this](std::stop_token stop)
+								   { CompressFiles(stop); });
+	}
+
+	std::optional<std::string> StaticCache::MakeKey(std::string_view target) const
+	{
+		target = target.substr(0, target.find_first_of("?#"));
+		const auto decoded = DecodePercent(target);
+		if (!decoded)
+			return std::nullopt;
+
+		// Собираем путь из сегментов, не выпуская его за пределы каталога статики
+		std::string key;
+		std::string_view rest = *decoded;
+		while (!rest.empty())
+		{
+			const auto slash = rest.find('/');
+			const auto segment = rest.substr(0, slash);
+			rest = (slash == std::string_view::npos) ? std::string_view{} : rest.substr(slash + 1);
+
+			if (segment.empty() || segment == ".")
+				continue;
+			if (segment == ".." || segment.find('\0') != std::string_view::npos)
+				return std::nullopt;
+			if (!key.empty())
+				key.push_back('/');
+			key.append(segment);
+		}
+		return key;
+	}
+
+	std::optional<fs::path> StaticCache::ResolvePath(std::string_view target) const
+	{
+		auto key = MakeKey(target);
+		if (!key)
+			return std::nullopt;
+		return root_ / *key;
+	}
+
+	std::shared_ptr<const CachedFile> StaticCache::Load(const std::string &key, bool compress) const
+	{
+		const auto path = root_ / key;
+		struct stat st{};
+		if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+			return nullptr;
+		if (static_cast<size_t>(st.st_size) > capacity_ / maxFileShare)
+			return nullptr;
+
+		std::ifstream input(path, std::ios::binary);
+		if (!input)
+			return nullptr;
+		std::string content{std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+
+		auto file = std::make_shared<CachedFile>();
+		file->response = compression::MakePrecomputedResponse(std::move(content), compress && IsCompressible(path));
+		file->modified_time = st.st_mtime;
+		file->last_modified = FormatHttpDate(st.st_mtime);
+		file->size = GetResponseSize(file->response);
+		return file;
+	}
+
+	std::shared_ptr<const CachedFile> StaticCache::Get(std::string_view target)
+	{
+		const auto key = MakeKey(target);
+		if (!key)
+			return nullptr;
+
+		std::uint64_t generation;
+		{
+			std::lock_guard lock{mutex_};
+			if (auto it = files_.find(*key); it != files_.end())
+			{
+				lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+				return it->second.file;
+			}
+			generation = generation_;
+		}
+
+		// Чтение файла идёт без блокировки, чтобы не задерживать запросы к другим файлам.
+		// Сжатие отложено в фоновый поток: ответ сразу отдаётся без сжатия
+		auto file = Load(*key, false);
+		if (!file)
+			return nullptr;
+
+		{
+			std::lock_guard lock{mutex_};
+			if (generation != generation_)
+				return file;
+			// Файл успел загрузить одновременный запрос: его запись уже ждёт сжатия
+			if (auto it = files_.find(*key); it != files_.end())
+				return it->second.file;
+
+			Insert(*key, file);
+			if (!IsCompressible(*key))
+				return file;
+			compress_tasks_.push_back(CompressTask{*key, file, generation});
+		}
+		compress_ready_.notify_one();
+		return file;
+	}
+
+	void StaticCache::CompressFiles(std::stop_token stop)
+	{
+		std::unique_lock lock{mutex_};
+		while (compress_ready_.wait(lock, stop, [this]
+									{ return !compress_tasks_.empty(); }))
+		{
+			auto task = std::move(compress_tasks_.front());
+			compress_tasks_.pop_front();
+
+			// Файл, изменившийся в ожидании сжатия, заново загрузит следующий запрос
+			if (task.generation == generation_)
+			{
+				compressing_ = true;
+				lock.unlock();
+				auto file = std::make_shared<CachedFile>(*task.file);
+				file->response = compression::MakePrecomputedResponse(*task.file->response.body);
+				// Тело то же: запросы, уже получившие запись без сжатия, и новые ссылаются на одну строку
+				file->response.body = task.file->response.body;
+				file->size = GetResponseSize(file->response);
+				lock.lock();
+				compressing_ = false;
+
+				// Запись заменяется, только если её не вытеснили и не инвалидировали за время сжатия
+				auto it = files_.find(task.key);
+				if (task.generation == generation_ && it != files_.end() && it->second.file == task.file)
+				{
+					size_ -= it->second.file->size;
+					size_ += file->size;
+					it->second.file = std::move(file);
+					Shrink();
+				}
+			}
+
+			if (compress_tasks_.empty())
+				compress_done_.notify_all();
+		}
+	}
+
+	void StaticCache::WaitCompressed()
+	{
+		std::unique_lock lock{mutex_};
+		compress_done_.wait(lock, [this]
+							{ return compress_tasks_.empty() && !compressing_; });
+	}
+
+	std::shared_ptr<const OpenFile> StaticCache::Open(std::string_view target)
+	{
+		const auto key = MakeKey(target);
+		if (!key)
+			return nullptr;
+		return open_files_.Open(*key);
+	}
+
+	void StaticCache::Insert(const std::string &key, std::shared_ptr<const CachedFile> file)
+	{
+		if (auto it = files_.find(key); it != files_.end())
+			Erase(it);
+
+		size_ += file->size;
+		lru_.push_front(key);
+		files_.emplace(key, Entry{std::move(file), lru_.begin()});
+		Shrink();
+	}
+
+	void StaticCache::Shrink()
+	{
+		while (size_ > capacity_ && lru_.size() > 1)
+			Erase(files_.find(lru_.back()));
+	}
+
+	void StaticCache::Erase(std::unordered_map<std::string, Entry>::iterator it)
+	{
+		size_ -= it->second.file->size;
+		lru_.erase(it->second.lru_position);
+		files_.erase(it);
+	}
+
+	void StaticCache::Invalidate(const fs::path &path)
+	{
+		const auto relative = path.lexically_normal().lexically_relative(root_.lexically_normal()).generic_string();
+		if (relative.empty() || relative.starts_with(".."))
+			return;
+		open_files_.Invalidate(relative == "." ? std::string{} : relative);
+
+		std::lock_guard lock{mutex_};
+		++generation_;
+		if (relative == ".")
+		{
+			files_.clear();
+			lru_.clear();
+			size_ = 0;
+			return;
+		}
+
+		const auto prefix = relative + '/';
+		for (auto it = files_.begin(); it != files_.end();)
+		{
+			auto next = std::next(it);
+			if (it->first == relative || it->first.starts_with(prefix))
+				Erase(it);
+			it = next;
+		}
+	}
+
+	size_t StaticCache::GetSize() const
+	{
+		std::lock_guard lock{mutex_};
+		return size_;
+	}
+
+	void StaticCache::Watch(net::io_context &ioc)
+	{
+		const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (fd < 0)
+			return event_logger::LogServerError(sys::error_code(errno, sys::system_category()), inotifyWhere);
+
+		inotify_.emplace(ioc, fd);
+		AddWatches(root_);
+		ReadEvents();
+	}
+
+	void StaticCache::AddWatches(const fs::path &directory)
+	{
+		const int wd = inotify_add_watch(inotify_->native_handle(), directory.c_str(), watchMask);
+		if (wd < 0)
+			return event_logger::LogServerError(sys::error_code(errno, sys::system_category()), inotifyWhere);
+		watches_[wd] = directory;
+
+		std::error_code ec;
+		for (fs::directory_iterator it(directory, fs::directory_options::skip_permission_denied, ec), end;
+			 !ec && it != end; it.increment(ec))
+		{
+			std::error_code entry_ec;
+			if (it->is_directory(entry_ec) && !it->is_symlink(entry_ec))
+				AddWatches(it->path());
+		}
+	}
+
+	void StaticCache::ReadEvents()
+	{
+		inotify_->async_read_some(net::buffer(events_buffer_), [self = shared_from_this()](const sys::error_code &ec, size_t bytes)
+								  {
+			if (ec)
+			{
+				if (ec != net::error::operation_aborted)
+					event_logger::LogServerError(ec, inotifyWhere);
+				return;
+			}
+			self->HandleEvents(bytes);
+			self->ReadEvents(); });
+	}
+
+	void StaticCache::HandleEvents(size_t bytes)
+	{
+		for (size_t offset = 0; offset + sizeof(inotify_event) <= bytes;)
+		{
+			const auto *event = reinterpret_cast<const inotify_event *>(events_buffer_.data() + offset);
+			offset += sizeof(inotify_event) + event->len;
+
+			// Очередь событий переполнилась: неизвестно, что изменилось, поэтому сбрасываем всё
+			if (event->mask & IN_Q_OVERFLOW)
+			{
+				Invalidate(root_);
+				continue;
+			}
+
+			auto it = watches_.find(event->wd);
+			if (it == watches_.end())
+				continue;
+			if (event->mask & IN_IGNORED)
+			{
+				watches_.erase(it);
+				continue;
+			}
+
+			auto path = it->second;
+			if (event->len > 0)
+				path /= event->name;
+			Invalidate(path);
+
+			// Перемещённый каталог следим заново по новому пути, если он остался внутри корня
+			if (event->mask & IN_MOVE_SELF)
+				inotify_rm_watch(inotify_->native_handle(), event->wd);
+			else if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO)))
+				AddWatches(path);
+		}
+	}
+}
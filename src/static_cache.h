@@ -0,0 +1,130 @@
+#pragma once
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include "model.h"
+#include "open_file_cache.h"
+
+namespace static_cache
+{
+    namespace net = boost::asio;
+
+    // Статический файл вместе со сжатыми вариантами
+    struct CachedFile
+    {
+        model::PrecomputedResponse response;
+        std::time_t modified_time{};
+        // Время изменения в формате HTTP-date для заголовка Last-Modified
+        std::string last_modified;
+        // Сколько памяти файл занимает в кэше: тело вместе со сжатыми вариантами
+        size_t size{0};
+    };
+
+    // Время в формате HTTP-date (RFC 9110): "Sun, 06 Nov 1994 08:49:37 GMT"
+    std::string FormatHttpDate(std::time_t time);
+    std::optional<std::time_t> ParseHttpDate(std::string_view date);
+
+    // Кэш каталога статики в памяти. При создании загружает файлы каталога, пока они помещаются
+    // в capacity байт, остальные загружаются при первом запросе и вытесняют давно не запрошенные.
+    // Файл, загруженный по запросу, сразу кладётся в кэш и отдаётся без сжатия, а его сжатые
+    // варианты собирает фоновый поток кэша и заменяет ими запись. Так запрос не ждёт сжатия,
+    // а одновременные запросы одного файла сжимают его один раз.
+    // Файлы крупнее capacity / maxFileShare не кэшируются в памяти, их отдают с диска через Open.
+    // Watch следит за каталогом через inotify: изменённый файл удаляется из кэша
+    // и загружается заново при следующем запросе. Методы можно вызывать из любого потока
+    class StaticCache : public std::enable_shared_from_this<StaticCache>
+    {
+    public:
+        static constexpr size_t maxFileShare = 8;
+
+        StaticCache(std::filesystem::path root, size_t capacity);
+
+        StaticCache(const StaticCache &) = delete;
+        StaticCache &operator=(const StaticCache &) = delete;
+
+        // Путь к файлу по цели запроса: без параметров запроса, с раскодированными %XX.
+        // Пусто, если путь выходит за пределы каталога
+        std::optional<std::filesystem::path> ResolvePath(std::string_view target) const;
+        // Файл по цели запроса. nullptr, если файла нет или он слишком велик для кэша
+        std::shared_ptr<const CachedFile> Get(std::string_view target);
+        // Открытый файл для отправки с диска. nullptr, если файла нет или путь выходит за пределы каталога
+        std::shared_ptr<const OpenFile> Open(std::string_view target);
+        // Удаляет из кэша файл или все файлы каталога
+        void Invalidate(const std::filesystem::path &path);
+        // Начинает следить за изменениями файлов, события обрабатываются в ioc
+        void Watch(net::io_context &ioc);
+        // Дожидается, пока фоновый поток сожмёт все загруженные к этому моменту файлы
+        void WaitCompressed();
+
+        size_t GetSize() const;
+        size_t GetCapacity() const noexcept { return capacity_; }
+
+    private:
+        struct Entry
+        {
+            std::shared_ptr<const CachedFile> file;
+            std::list<std::string>::iterator lru_position;
+        };
+
+        // Файл, ожидающий сжатия в фоновом потоке
+        struct CompressTask
+        {
+            std::string key;
+            std::shared_ptr<const CachedFile> file;
+            std::uint64_t generation{0};
+        };
+
+        std::optional<std::string> MakeKey(std::string_view target) const;
+        // Читает файл; сжатые варианты собирает, только если compress
+        std::shared_ptr<const CachedFile> Load(const std::string &key, bool compress) const;
+        // Вызываются под mutex_
+        void Insert(const std::string &key, std::shared_ptr<const CachedFile> file);
+        void Erase(std::unordered_map<std::string, Entry>::iterator it);
+        void Shrink();
+
+        // Цикл фонового потока: сжимает файлы из compress_tasks_ и заменяет ими записи кэша
+        void CompressFiles(std::stop_token stop);
+
+        void AddWatches(const std::filesystem::path &directory);
+        void ReadEvents();
+        void HandleEvents(size_t bytes);
+
+        std::filesystem::path root_;
+        size_t capacity_;
+
+        mutable std::mutex mutex_;
+        std::unordered_map<std::string, Entry> files_;
+        // Ключи файлов от недавно запрошенных к давно не запрошенным
+        std::list<std::string> lru_;
+        size_t size_{0};
+        // Растёт при каждой инвалидации: файл, прочитанный до неё, в кэш уже не кладём
+        std::uint64_t generation_{0};
+        // Очередь фонового сжатия, защищена mutex_
+        std::deque<CompressTask> compress_tasks_;
+        bool compressing_{false};
+        std::condition_variable_any compress_ready_;
+        std::condition_variable compress_done_;
+        OpenFileCache open_files_;
+
+        // Используются только обработчиками событий inotify, которые выполняются по очереди
+        std::optional<net::posix::stream_descriptor> inotify_;
+        std::unordered_map<int, std::filesystem::path> watches_;
+        alignas(8) std::array<char, 4096> events_buffer_;
+
+        // Объявлен последним: останавливается и присоединяется до разрушения остальных полей
+        std::jthread compressor_;
+    };
+}
@@ -0,0 +1,54 @@
+#include "tick_timings.h"
+#include <algorithm>
+
+namespace http_handler
+{
+	std::string_view GetTickPhaseName(TickPhase phase)
+	{
+		switch (phase)
+		{
+		case TickPhase::LootGeneration:
+			return "loot_generation";
+		case TickPhase::Movement:
+			return "movement";
+		case TickPhase::Snapshot:
+			return "snapshot";
+		case TickPhase::Retirement:
+			return "retirement";
+		case TickPhase::StatePublish:
+			return "state_publish";
+		case TickPhase::Merge:
+			return "merge";
+		case TickPhase::Total:
+			return "total";
+		}
+		return "unknown";
+	}
+
+	std::optional<TickTimingsReport> TickTimingsCollector::Add(const TickTimings &timings)
+	{
+		++ticks_;
+		max_sessions_ = std::max(max_sessions_, timings.sessions);
+		for (size_t i = 0; i < tickPhasesCount; ++i)
+		{
+			sum_[i] += timings.phases[i];
+			max_[i] = std::max(max_[i], timings.phases[i]);
+		}
+
+		if (ticks_ < report_period_)
+			return std::nullopt;
+
+		using Milliseconds = std::chrono::duration<double, std::milli>;
+		TickTimingsReport report;
+		report.ticks = ticks_;
+		report.max_sessions = max_sessions_;
+		for (size_t i = 0; i < tickPhasesCount; ++i)
+		{
+			report.mean_ms[i] = Milliseconds(sum_[i]).count() / ticks_;
+			report.max_ms[i] = Milliseconds(max_[i]).count();
+		}
+
+		*this = TickTimingsCollector{report_period_};
+		return report;
+	}
+}
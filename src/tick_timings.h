@@ -0,0 +1,63 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <optional>
+#include <string_view>
+
+namespace http_handler
+{
+    // Фазы тика. Первые пять выполняются в каждой сессии параллельно,
+    // Merge - общий шаг после завершения всех сессий, Total - весь тик
+    enum class TickPhase
+    {
+        LootGeneration,
+        Movement,
+        Snapshot,
+        Retirement,
+        StatePublish,
+        Merge,
+        Total
+    };
+
+    constexpr size_t tickPhasesCount = static_cast<size_t>(TickPhase::Total) + 1;
+
+    std::string_view GetTickPhaseName(TickPhase phase);
+
+    // Замеры одного тика. Для фаз сессий хранится самая долгая из сессий,
+    // она и определяет задержку тика
+    struct TickTimings
+    {
+        using Duration = std::chrono::steady_clock::duration;
+
+        std::array<Duration, tickPhasesCount> phases{};
+        size_t sessions{0};
+
+        Duration &operator[](TickPhase phase) { return phases[static_cast<size_t>(phase)]; }
+        Duration operator[](TickPhase phase) const { return phases[static_cast<size_t>(phase)]; }
+    };
+
+    // Средние и максимальные времена фаз за несколько тиков
+    struct TickTimingsReport
+    {
+        size_t ticks{0};
+        size_t max_sessions{0};
+        std::array<double, tickPhasesCount> mean_ms{};
+        std::array<double, tickPhasesCount> max_ms{};
+    };
+
+    // Накапливает замеры тиков и раз в report_period тиков выдаёт сводку
+    class TickTimingsCollector
+    {
+    public:
+        explicit TickTimingsCollector(size_t report_period) : report_period_{report_period} {}
+
+        std::optional<TickTimingsReport> Add(const TickTimings &timings);
+
+    private:
+        size_t report_period_;
+        size_t ticks_{0};
+        size_t max_sessions_{0};
+        std::array<TickTimings::Duration, tickPhasesCount> sum_{};
+        std::array<TickTimings::Duration, tickPhasesCount> max_{};
+    };
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 namespace net = boost::asio;
 namespace sys = boost::system;
 
@@ -16,13 +17,16 @@ namespace http_handler
         {
         }
         bool HasStarted() { return has_started_; }
+        // Может вызываться из разных strand-ов: запускает тикер только первый вызов
         void Start()
         {
+            if (has_started_.exchange(true))
+                return;
+
             last_tick_ = std::chrono::steady_clock::now();
             /* Выполнить SchedulTick внутри strand_ */
             net::dispatch(strand_, [self = shared_from_this()]
                           { self->ScheduleTick(); });
-            has_started_ = true;
         }
 
     private:
@@ -48,6 +52,6 @@ namespace http_handler
         std::chrono::milliseconds period_;
         Handler handler_;
         std::chrono::time_point<std::chrono::steady_clock> last_tick_;
-        bool has_started_{false};
+        std::atomic<bool> has_started_{false};
     };
 }
\ No newline at end of file
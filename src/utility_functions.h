@@ -13,6 +13,10 @@ struct Args
     std::string www_root;
     std::string save_file;
     bool spawn_random_points{false};
+    std::optional<std::uint64_t> random_seed;
+    unsigned threads{0};
+    bool reuse_port{false};
+    bool core_sessions{false};
 };
 
 struct AppConfig
@@ -32,12 +36,17 @@ namespace
         Args args;
         std::string tick_period;
         std::string save_period;
+        std::uint64_t random_seed{};
         desc.add_options()                                                                                     //
             ("help,h", "produce help message")                                                                 //
             ("tick-period,t", po::value(&tick_period)->value_name("milliseconds"s), " set tick period")        //
             ("config-file,c", po::value(&args.config_file)->value_name("file"s), "set config file path")       //
             ("www-root,w", po::value(&args.www_root)->value_name("dir"s), "set static files root")             //
             ("randomize-spawn-points", "spawn dogs at random positions")                                       //
+            ("threads", po::value(&args.threads)->value_name("count"s), "set number of worker threads (default: number of cores)") //
+            ("reuse-port", "give every worker thread its own io_context and SO_REUSEPORT listener") //
+            ("core-sessions", "let every worker thread own the game sessions of its maps (implies --reuse-port)") //
+            ("random-seed", po::value(&random_seed)->value_name("seed"s), "use a fixed random seed for reproducible runs") //
             ("state-file,f", po::value(&args.save_file)->value_name("file"s), "set file to save server state") //
             ("save-state-period,p", po::value(&save_period)->value_name("milliseconds"s), "time period to save server state in milliseconds");
 
@@ -72,6 +81,13 @@ namespace
         }
 
         args.spawn_random_points = vm.contains("randomize-spawn-points"s) ? true : false;
+        args.core_sessions = vm.contains("core-sessions"s);
+        args.reuse_port = vm.contains("reuse-port"s) || args.core_sessions;
+
+        if (vm.contains("random-seed"s))
+        {
+            args.random_seed = random_seed;
+        }
 
         return args;
     }
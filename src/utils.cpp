@@ -0,0 +1,66 @@
+#include "utils.h"
+#include <atomic>
+
+namespace utils
+{
+	namespace
+	{
+		std::atomic<bool> fixed_seed_mode{false};
+		std::atomic<std::uint64_t> fixed_seed{0};
+
+		// splitmix64 - рекомендованный авторами xoshiro способ развернуть
+		// одно 64-битное зерно в состояние генератора
+		std::uint64_t SplitMix64(std::uint64_t &x) noexcept
+		{
+			std::uint64_t z = (x += 0x9e3779b97f4a7c15);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+			return z ^ (z >> 31);
+		}
+
+		// FNV-1a: в отличие от std::hash, одинаков во всех сборках и запусках
+		std::uint64_t HashName(std::string_view name) noexcept
+		{
+			std::uint64_t hash = 0xcbf29ce484222325;
+			for (const unsigned char c : name)
+			{
+				hash ^= c;
+				hash *= 0x100000001b3;
+			}
+			return hash;
+		}
+
+		std::uint64_t MakeDeviceSeed()
+		{
+			std::random_device device;
+			return (static_cast<std::uint64_t>(device()) << 32) | device();
+		}
+	}
+
+	FastRandom::FastRandom(std::uint64_t seed) noexcept
+	{
+		for (auto &word : state_)
+			word = SplitMix64(seed);
+	}
+
+	void SetRandomSeed(std::uint64_t seed)
+	{
+		fixed_seed.store(seed, std::memory_order_relaxed);
+		fixed_seed_mode.store(true, std::memory_order_release);
+	}
+
+	std::uint64_t MakeRandomSeed(std::string_view stream)
+	{
+		if (!fixed_seed_mode.load(std::memory_order_acquire))
+			return MakeDeviceSeed();
+
+		std::uint64_t seed = fixed_seed.load(std::memory_order_relaxed) ^ HashName(stream);
+		return SplitMix64(seed);
+	}
+
+	FastRandom &GetRandomEngine()
+	{
+		thread_local FastRandom engine{MakeDeviceSeed()};
+		return engine;
+	}
+}
@@ -1,15 +1,67 @@
 #pragma once
+#include <cstdint>
+#include <limits>
 #include <random>
+#include <string_view>
 
 namespace utils
 {
-	template <typename T>
-	T GetRandomNumber(T minValue, T maxValue)
+	// Быстрый генератор псевдослучайных чисел xoshiro256**.
+	// Не годится для криптографии: токены игроков генерируются отдельно (см. PlayerTokens)
+	class FastRandom
+	{
+	public:
+		using result_type = std::uint64_t;
+
+		explicit FastRandom(std::uint64_t seed) noexcept;
+
+		static constexpr result_type min() noexcept { return 0; }
+		static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+
+		result_type operator()() noexcept
+		{
+			const std::uint64_t result = RotateLeft(state_[1] * 5, 7) * 9;
+			const std::uint64_t t = state_[1] << 17;
+			state_[2] ^= state_[0];
+			state_[3] ^= state_[1];
+			state_[1] ^= state_[2];
+			state_[0] ^= state_[3];
+			state_[2] ^= t;
+			state_[3] = RotateLeft(state_[3], 45);
+			return result;
+		}
+
+	private:
+		static constexpr std::uint64_t RotateLeft(std::uint64_t x, int k) noexcept
+		{
+			return (x << k) | (x >> (64 - k));
+		}
+
+		std::uint64_t state_[4];
+	};
+
+	// Включает воспроизводимый режим: MakeRandomSeed начинает выводить зёрна из seed
+	// и имени потока чисел. Вызывается при старте до создания игровых сессий
+	void SetRandomSeed(std::uint64_t seed);
+
+	// Зерно для генератора потока чисел stream, например игровой сессии карты.
+	// В воспроизводимом режиме зависит только от seed и stream, иначе случайно
+	std::uint64_t MakeRandomSeed(std::string_view stream);
+
+	// Генератор текущего потока со случайным зерном. Игровые сессии используют
+	// свои генераторы, поэтому воспроизводимый режим на него не влияет
+	FastRandom &GetRandomEngine();
+
+	template <typename T, typename Engine>
+	T GetRandomNumber(Engine &engine, T minValue, T maxValue)
 	{
-		std::mt19937 engine;
-		std::random_device device;
-		engine.seed(device());
 		std::uniform_int_distribution<T> distribution(minValue, maxValue);
 		return distribution(engine);
 	}
+
+	template <typename T>
+	T GetRandomNumber(T minValue, T maxValue)
+	{
+		return GetRandomNumber<T>(GetRandomEngine(), minValue, maxValue);
+	}
 }
@@ -164,10 +164,12 @@ class GameState {
     this.lostObjects = {};
     this.disappearingLoot = {};
     this.player_elems = {};
+    this.socket = undefined;
 
     this._updateState(function() {
       self.stateLoaded = true;
       self._startGame();
+      self._openSocket();
     });
     this._syncPlayers(function() {
       self.playersLoaded = true;
@@ -183,7 +185,9 @@ class GameState {
     if (!this.started)
       return false;
 
-    if ((this.ticks % this.posUpdateInterval == 0 || this.requestInstantUpdate) && !this.updateInProgress) {
+    // While the WebSocket is open the server pushes the state after every tick
+    if (this.socket === undefined &&
+        (this.ticks % this.posUpdateInterval == 0 || this.requestInstantUpdate) && !this.updateInProgress) {
       this.requestInstantUpdate = false;
       this._updateState(function() {
         self._applyDesiredState();
@@ -212,6 +216,11 @@ class GameState {
 
   _pressKey(keys, then) {
     const self = this;
+    if (this.socket !== undefined) {
+      this.socket.send(JSON.stringify({move: keys}));
+      then();
+      return;
+    }
     $.post({
       url: '/api/v1/game/player/action',
       dataType: 'json',
@@ -409,6 +418,29 @@ class GameState {
     return abandonedLoot;
   }
 
+  _openSocket() {
+    if (typeof WebSocket === 'undefined')
+      return;
+
+    const self = this;
+    const protocol = location.protocol === 'https:' ? 'wss://' : 'ws://';
+    const socket = new WebSocket(protocol + location.host + '/api/v1/game/socket?token=' +
+                                 encodeURIComponent(Cookies.get('authToken')));
+    socket.onopen = function() {
+      self.socket = socket;
+    };
+    socket.onmessage = function(event) {
+      self.desiredState = JSON.parse(event.data);
+      self.stateTime = performance.now();
+      if (self.started)
+        self._applyDesiredState();
+    };
+    // Fall back to polling when the connection drops
+    socket.onclose = function() {
+      self.socket = undefined;
+    };
+  }
+
   _updateState(then) {
     let self = this;
     $.get({
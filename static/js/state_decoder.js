@@ -0,0 +1,120 @@
+// Reference decoder for the compact binary game state (Accept: application/x-dogstory-bin).
+// The layout is described in src/binary_serializer.h. Decoded messages have the same shape
+// as the JSON responses of /api/v1/game/state and /api/v1/game/players, plus the state tick.
+
+const dogStoryBinary = (function() {
+  const fixedPointScale = 1000;
+  const directions = ['U', 'D', 'L', 'R', ''];
+  const messageKind = { state: 1, players: 2 };
+
+  class Reader {
+    constructor(buffer) {
+      this.view = new DataView(buffer instanceof ArrayBuffer ? buffer : buffer.buffer,
+                               buffer.byteOffset || 0, buffer.byteLength);
+      this.offset = 0;
+    }
+
+    byte() {
+      return this.view.getUint8(this.offset++);
+    }
+
+    varint() {
+      // Multiplication instead of bit shifts keeps values above 2^31 exact
+      let result = 0;
+      let scale = 1;
+      for (;;) {
+        const b = this.byte();
+        result += (b & 0x7f) * scale;
+        if (b < 0x80) {
+          return result;
+        }
+        scale *= 128;
+      }
+    }
+
+    fixed() {
+      const value = this.view.getInt32(this.offset, true);
+      this.offset += 4;
+      return value / fixedPointScale;
+    }
+
+    string() {
+      const length = this.varint();
+      const bytes = new Uint8Array(this.view.buffer, this.view.byteOffset + this.offset, length);
+      this.offset += length;
+      return new TextDecoder().decode(bytes);
+    }
+  }
+
+  function readHeader(reader, kind) {
+    const magic = String.fromCharCode(reader.byte(), reader.byte(), reader.byte());
+    const version = reader.byte();
+    if (magic !== 'DSB' || version !== 1) {
+      throw new Error('Unsupported binary state format');
+    }
+    if (reader.byte() !== kind) {
+      throw new Error('Unexpected binary message kind');
+    }
+  }
+
+  // lootTypes is the map's lootTypes array; when given, every lost object and bag item
+  // also gets a lootType field with its description
+  function decodeState(buffer, lootTypes) {
+    const reader = new Reader(buffer);
+    readHeader(reader, messageKind.state);
+
+    const result = { tick: reader.varint(), players: {}, lostObjects: {} };
+    const describe = function(item) {
+      if (lootTypes) {
+        item.lootType = lootTypes[item.type];
+      }
+      return item;
+    };
+
+    const numPlayers = reader.varint();
+    for (let i = 0; i < numPlayers; ++i) {
+      const id = reader.varint();
+      const pos = [reader.fixed(), reader.fixed()];
+      const speed = [reader.fixed(), reader.fixed()];
+      const dir = directions[reader.byte()];
+      const score = reader.varint();
+      const bag = [];
+      const bagSize = reader.varint();
+      for (let j = 0; j < bagSize; ++j) {
+        bag.push(describe({ id: reader.varint(), type: reader.varint() }));
+      }
+      result.players[id] = { pos: pos, speed: speed, dir: dir, bag: bag, score: score };
+    }
+
+    const numLoots = reader.varint();
+    for (let i = 0; i < numLoots; ++i) {
+      const type = reader.varint();
+      result.lostObjects[i] = describe({ type: type, pos: [reader.fixed(), reader.fixed()] });
+    }
+
+    return result;
+  }
+
+  function decodePlayers(buffer) {
+    const reader = new Reader(buffer);
+    readHeader(reader, messageKind.players);
+
+    const result = {};
+    const numPlayers = reader.varint();
+    for (let i = 0; i < numPlayers; ++i) {
+      const id = reader.varint();
+      result[id] = { name: reader.string() };
+    }
+    return result;
+  }
+
+  return {
+    contentType: 'application/x-dogstory-bin',
+    decodeState: decodeState,
+    decodePlayers: decodePlayers
+  };
+})();
+
+if (typeof module !== 'undefined') {
+  module.exports = dogStoryBinary;
+}
@@ -0,0 +1,80 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "../src/binary_serializer.h"
+#include "../src/game_session.h"
+#include "test_utils.h"
+
+using namespace std::literals;
+
+namespace {
+
+// Эталонные сообщения лежат в tests/data в виде шестнадцатеричных байтов с комментариями
+// после '#'. Те же файлы разбирает справочный декодер в tests/state_decoder_test.js,
+// поэтому кодировщик и декодер не могут разойтись незаметно
+std::string ReadGolden(const std::string& name) {
+    std::ifstream file{std::filesystem::path{__FILE__}.parent_path() / "data" / name};
+    REQUIRE(file);
+
+    std::string bytes;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream words{line.substr(0, line.find('#'))};
+        std::string word;
+        while (words >> word)
+            bytes.push_back(static_cast<char>(std::stoul(word, nullptr, 16)));
+    }
+    return bytes;
+}
+
+std::string ToHex(const std::string& bytes) {
+    static constexpr char digits[] = "0123456789abcdef";
+    std::string result;
+    for (const unsigned char byte : bytes) {
+        result += digits[byte >> 4];
+        result += digits[byte & 0xf];
+        result += ' ';
+    }
+    return result;
+}
+
+}  // namespace
+
+SCENARIO("Binary serializer") {
+    model::Map map = MakeOneRoadMap();
+    model::GameSession session{"map"s, 5.0, 0.5};
+
+    const auto standing = session.AddPlayer("Шарик"s, &map, false, 3);
+    standing->SetId(200);
+    auto dog = standing->GetDog();
+    dog->SetPositionOnMap(model::DogPos{0, {-1.5, 2.25}, {0.0, 0.0}});
+    dog->SetDirection(model::DogDirection::STOP);
+    dog->SetScore(130);
+    dog->SetGatheredLoot({model::LootInfo{5, 1, 0.0, 0.0}, model::LootInfo{1048577, 2, 0.0, 0.0}});
+
+    const auto running = session.AddPlayer("Rex"s, &map, false, 3);
+    running->SetId(7);
+    dog = running->GetDog();
+    dog->SetPositionOnMap(model::DogPos{0, {10.0, 0.4}, {0.0, 0.0}});
+    dog->SetSpeed(model::DogDirection::WEST, 2.5);
+
+    const std::vector<model::LootInfo> loots{model::LootInfo{9, 3, -0.5, 10.0}};
+
+    WHEN("a game state is encoded") {
+        const auto bytes = binary_serializer::GetPlayersDogInfoBinary(300, session.GetPlayers(), loots);
+
+        THEN("it matches the golden message byte for byte") {
+            CHECK(ToHex(bytes) == ToHex(ReadGolden("binary_state.hex")));
+        }
+    }
+
+    WHEN("a player list is encoded") {
+        const auto bytes = binary_serializer::GetPlayerInfoBinary(session.GetPlayers());
+
+        THEN("it matches the golden message byte for byte") {
+            CHECK(ToHex(bytes) == ToHex(ReadGolden("binary_players.hex")));
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#include <catch2/catch_test_macros.hpp>
+#include "../src/byte_ranges.h"
+#include "../src/static_cache.h"
+
+using namespace std::literals;
+using byte_ranges::ByteRange;
+using byte_ranges::ParseRange;
+
+SCENARIO("Range header parsing") {
+    constexpr std::uint64_t size = 1000;
+
+    THEN("all three forms of a range are understood") {
+        CHECK(ParseRange("bytes=0-499", size) == std::vector<ByteRange>{{0, 500}});
+        CHECK(ParseRange("bytes=500-", size) == std::vector<ByteRange>{{500, 500}});
+        CHECK(ParseRange("bytes=-100", size) == std::vector<ByteRange>{{900, 100}});
+        CHECK(ParseRange("Bytes= 10-19 ", size) == std::vector<ByteRange>{{10, 10}});
+    }
+    THEN("ranges are clipped to the representation") {
+        CHECK(ParseRange("bytes=900-5000", size) == std::vector<ByteRange>{{900, 100}});
+        CHECK(ParseRange("bytes=-5000", size) == std::vector<ByteRange>{{0, 1000}});
+    }
+    THEN("several ranges are sorted, and overlapping or adjacent ones are merged") {
+        CHECK(ParseRange("bytes=500-599,0-99", size) == std::vector<ByteRange>{{0, 100}, {500, 100}});
+        CHECK(ParseRange("bytes=0-99,50-149,150-199", size) == std::vector<ByteRange>{{0, 200}});
+        CHECK(ParseRange("bytes=0-9,,20-29", size) == std::vector<ByteRange>{{0, 10}, {20, 10}});
+    }
+    THEN("ranges outside of the representation are not satisfiable") {
+        CHECK(ParseRange("bytes=1000-", size) == std::vector<ByteRange>{});
+        CHECK(ParseRange("bytes=-0", size) == std::vector<ByteRange>{});
+        CHECK(ParseRange("bytes=0-", 0) == std::vector<ByteRange>{});
+        CHECK(ParseRange("bytes=2000-2999,0-9", size) == std::vector<ByteRange>{{0, 10}});
+    }
+    THEN("malformed headers are ignored") {
+        CHECK_FALSE(ParseRange("", size));
+        CHECK_FALSE(ParseRange("items=0-9", size));
+        CHECK_FALSE(ParseRange("bytes=", size));
+        CHECK_FALSE(ParseRange("bytes=9-0", size));
+        CHECK_FALSE(ParseRange("bytes=a-b", size));
+        CHECK_FALSE(ParseRange("bytes=10", size));
+        CHECK_FALSE(ParseRange("bytes=0-9,x", size));
+        CHECK_FALSE(ParseRange("bytes=99999999999999999999-", size));
+    }
+    THEN("too many ranges are ignored") {
+        std::string range = "bytes=0-0";
+        for (size_t i = 1; i <= byte_ranges::maxRanges; ++i) {
+            range += ","s + std::to_string(i * 2) + "-"s + std::to_string(i * 2);
+        }
+        CHECK_FALSE(ParseRange(range, size));
+    }
+}
+
+SCENARIO("If-Range") {
+    const std::time_t modified = 784111777;
+    const auto etag = "\"abc\""s;
+
+    CHECK(byte_ranges::IfRangeMatches("", etag, modified));
+    CHECK(byte_ranges::IfRangeMatches("\"abc\"", etag, modified));
+    CHECK_FALSE(byte_ranges::IfRangeMatches("\"abd\"", etag, modified));
+    CHECK_FALSE(byte_ranges::IfRangeMatches("W/\"abc\"", etag, modified));
+    CHECK(byte_ranges::IfRangeMatches(static_cache::FormatHttpDate(modified), etag, modified));
+    CHECK_FALSE(byte_ranges::IfRangeMatches(static_cache::FormatHttpDate(modified - 1), etag, modified));
+    CHECK_FALSE(byte_ranges::IfRangeMatches("garbage", etag, modified));
+}
+
+SCENARIO("Multipart byte ranges") {
+    const std::string data = "0123456789abcdefghij";
+    const auto multipart = byte_ranges::MakeMultipart({{0, 3}, {10, 5}}, data.size(), "text/plain");
+
+    std::string body;
+    for (const auto& part : multipart.parts) {
+        body += part.header + data.substr(part.range.offset, part.range.size);
+    }
+    body += multipart.closing;
+
+    CHECK(multipart.size == body.size());
+    CHECK(multipart.content_type.starts_with("multipart/byteranges; boundary="s));
+    const auto boundary = multipart.content_type.substr(multipart.content_type.find('=') + 1);
+    CHECK(body == "\r\n--"s + boundary + "\r\nContent-Type: text/plain\r\nContent-Range: bytes 0-2/20\r\n\r\n012"s +
+                      "\r\n--"s + boundary + "\r\nContent-Type: text/plain\r\nContent-Range: bytes 10-14/20\r\n\r\nabcde"s +
+                      "\r\n--"s + boundary + "--\r\n"s);
+    CHECK(byte_ranges::MakeContentRange({10, 5}, 20) == "bytes 10-14/20"s);
+    CHECK(byte_ranges::MakeUnsatisfiedContentRange(20) == "bytes */20"s);
+}
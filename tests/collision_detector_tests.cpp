@@ -1,3 +1,5 @@
+#include <random>
+
 #include "test_utils.h"
 
 SCENARIO("No collision detected") {
@@ -63,3 +65,42 @@ SCENARIO("No collision detected") {
         }
     }
 }
+
+SCENARIO("Collect kernels give identical results") {
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> coord(-50., 50.);
+    std::uniform_real_distribution<double> width(0., 2.);
+
+    std::vector<collision_detector::Item> items;
+    for (unsigned i = 0; i < 1003; ++i) {
+        items.emplace_back(i, geom::Point2D{coord(generator), coord(generator)}, width(generator));
+    }
+    std::vector<collision_detector::Gatherer> gatherers;
+    for (int i = 0; i < 200; ++i) {
+        geom::Point2D start{coord(generator), coord(generator)};
+        geom::Point2D end = i % 2 == 0 ? geom::Point2D{coord(generator), start.y} : geom::Point2D{start.x, coord(generator)};
+        gatherers.push_back({start, end, width(generator)});
+    }
+    collision_detector::ItemGatherer provider{items, gatherers};
+    collision_detector::ItemIndex index(items, 4.0);
+
+    WHEN("events are found by every available kernel") {
+        auto expected = collision_detector::FindGatherEvents(index, gatherers, collision_detector::CollectKernel::Scalar);
+        THEN("they match the scalar kernel bit for bit") {
+            REQUIRE_FALSE(expected.empty());
+            for (auto kernel : collision_detector::GetAvailableCollectKernels()) {
+                auto events = collision_detector::FindGatherEvents(index, gatherers, kernel);
+                REQUIRE(events.size() == expected.size());
+                for (size_t i = 0; i < events.size(); ++i) {
+                    CHECK(events[i].item_id == expected[i].item_id);
+                    CHECK(events[i].gatherer_id == expected[i].gatherer_id);
+                    CHECK(events[i].sq_distance == expected[i].sq_distance);
+                    CHECK(events[i].time == expected[i].time);
+                }
+            }
+        }
+        THEN("the scalar kernel matches the provider interface") {
+            CHECK_THAT(collision_detector::FindGatherEvents(provider), EqualsRange(expected, EventsComparator()));
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include <zlib.h>
+#include <brotli/decode.h>
+#include <catch2/catch_test_macros.hpp>
+#include "../src/compression.h"
+
+using namespace std::literals;
+
+namespace {
+
+std::string Gunzip(const std::string& data) {
+    z_stream stream{};
+    REQUIRE(inflateInit2(&stream, 15 + 16) == Z_OK);
+    std::string result(1 << 20, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(result.data());
+    stream.avail_out = static_cast<uInt>(result.size());
+    const int status = inflate(&stream, Z_FINISH);
+    result.resize(stream.total_out);
+    inflateEnd(&stream);
+    REQUIRE(status == Z_STREAM_END);
+    return result;
+}
+
+std::string Unbrotli(const std::string& data) {
+    std::string result(1 << 20, '\0');
+    size_t size = result.size();
+    REQUIRE(BrotliDecoderDecompress(data.size(), reinterpret_cast<const uint8_t*>(data.data()), &size,
+                                    reinterpret_cast<uint8_t*>(result.data())) == BROTLI_DECODER_RESULT_SUCCESS);
+    result.resize(size);
+    return result;
+}
+
+std::string MakeMapLikeBody() {
+    std::string body = "[";
+    for (int i = 0; i < 500; ++i) {
+        body += "{\"x0\":"s + std::to_string(i) + ",\"y0\":0,\"x1\":40},"s;
+    }
+    body.back() = ']';
+    return body;
+}
+
+}  // namespace
+
+SCENARIO("Precomputed responses") {
+    GIVEN("a large repetitive body") {
+        const auto body = MakeMapLikeBody();
+        const auto response = compression::MakePrecomputedResponse(body);
+
+        THEN("it keeps the body and adds a smaller gzip variant that decompresses back") {
+            REQUIRE(response.body);
+            CHECK(*response.body == body);
+            REQUIRE(response.gzip_body);
+            CHECK(response.gzip_body->size() < body.size());
+            CHECK(Gunzip(*response.gzip_body) == body);
+        }
+        THEN("it adds a brotli variant, smaller than gzip, that decompresses back") {
+            REQUIRE(response.brotli_body);
+            CHECK(response.brotli_body->size() < response.gzip_body->size());
+            CHECK(Unbrotli(*response.brotli_body) == body);
+        }
+        THEN("both representations have distinct strong ETags that depend only on the content") {
+            CHECK(response.etag.front() == '"');
+            CHECK(response.etag.back() == '"');
+            CHECK(response.etag == compression::MakeStrongETag(body));
+            CHECK(response.etag == compression::MakePrecomputedResponse(body).etag);
+            CHECK(response.gzip_etag != response.etag);
+            CHECK(response.brotli_etag != response.etag);
+            CHECK(response.brotli_etag != response.gzip_etag);
+            CHECK(response.etag != compression::MakeStrongETag(body + " "s));
+        }
+    }
+    GIVEN("a tiny body") {
+        const auto response = compression::MakePrecomputedResponse("[]"s);
+
+        THEN("no compressed variants are kept, since they would be larger") {
+            CHECK(*response.body == "[]"s);
+            CHECK_FALSE(response.gzip_body);
+            CHECK(response.gzip_etag.empty());
+            CHECK_FALSE(response.brotli_body);
+        }
+    }
+}
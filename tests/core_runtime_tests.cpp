@@ -0,0 +1,165 @@
+#include <catch2/catch_test_macros.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/post.hpp>
+#include <atomic>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/core_runtime.h"
+#include "../src/spsc_queue.h"
+
+using namespace std::literals;
+using core_runtime::CoreRuntime;
+using core_runtime::SpscQueue;
+namespace net = boost::asio;
+
+SCENARIO("SPSC queue") {
+    GIVEN("a queue with a capacity that is not a power of two") {
+        SpscQueue<std::string> queue{3};
+        CHECK(queue.GetCapacity() == 4);
+
+        THEN("values come out in the order they were pushed") {
+            for (int i = 0; i < 4; ++i) {
+                auto value = std::to_string(i);
+                REQUIRE(queue.TryPush(std::move(value)));
+            }
+            std::string value;
+            for (int i = 0; i < 4; ++i) {
+                REQUIRE(queue.TryPop(value));
+                CHECK(value == std::to_string(i));
+            }
+            CHECK_FALSE(queue.TryPop(value));
+        }
+
+        THEN("a push into a full queue fails and keeps the value") {
+            for (int i = 0; i < 4; ++i) {
+                auto value = "x"s;
+                REQUIRE(queue.TryPush(std::move(value)));
+            }
+            auto rejected = "rejected"s;
+            CHECK_FALSE(queue.TryPush(std::move(rejected)));
+            CHECK(rejected == "rejected"s);
+
+            std::string value;
+            REQUIRE(queue.TryPop(value));
+            auto accepted = "accepted"s;
+            CHECK(queue.TryPush(std::move(accepted)));
+        }
+    }
+
+    GIVEN("a producer and a consumer thread") {
+        SpscQueue<int> queue{64};
+        constexpr int count = 100000;
+
+        std::jthread producer{[&queue] {
+            for (int i = 0; i < count;) {
+                int value = i;
+                if (queue.TryPush(std::move(value)))
+                    ++i;
+                else
+                    std::this_thread::yield();
+            }
+        }};
+
+        THEN("every value arrives once and in order") {
+            int expected = 0;
+            int out_of_order = 0;
+            while (expected < count) {
+                int value = -1;
+                if (!queue.TryPop(value)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                if (value != expected)
+                    ++out_of_order;
+                ++expected;
+            }
+            CHECK(out_of_order == 0);
+        }
+    }
+}
+
+SCENARIO("Core runtime") {
+    constexpr size_t cores = 3;
+    std::vector<std::unique_ptr<net::io_context>> contexts;
+    std::vector<net::io_context*> context_pointers;
+    for (size_t i = 0; i < cores; ++i) {
+        contexts.push_back(std::make_unique<net::io_context>(1));
+        context_pointers.push_back(contexts.back().get());
+    }
+    CoreRuntime runtime{context_pointers};
+    REQUIRE(runtime.GetCoreCount() == cores);
+    CHECK(runtime.FindCore(*contexts[1]) == 1);
+    net::io_context other;
+    CHECK_FALSE(runtime.FindCore(other));
+    CHECK_FALSE(runtime.CurrentCore());
+
+    WHEN("every core sends messages to every other core and they reply") {
+        // Больше ёмкости ящика, чтобы часть сообщений ушла через io_context
+        constexpr size_t messages = CoreRuntime::mailboxCapacity * 3;
+        std::atomic<size_t> replies{0};
+        std::atomic<size_t> wrong_core{0};
+        std::vector<std::vector<size_t>> received(cores, std::vector<size_t>(cores, 0));
+        std::vector<net::executor_work_guard<net::io_context::executor_type>> work;
+        for (auto& context : contexts)
+            work.push_back(net::make_work_guard(*context));
+
+        for (size_t from = 0; from < cores; ++from) {
+            net::post(*contexts[from], [&, from] {
+                for (size_t to = 0; to < cores; ++to) {
+                    for (size_t i = 0; i < messages; ++i) {
+                        runtime.Execute(to, [&, from, to] {
+                            if (runtime.CurrentCore() != to)
+                                ++wrong_core;
+                            ++received[to][from];
+                            runtime.Execute(from, [&, from] {
+                                if (runtime.CurrentCore() != from)
+                                    ++wrong_core;
+                                if (++replies == cores * cores * messages) {
+                                    for (auto& context : contexts)
+                                        context->stop();
+                                }
+                            });
+                        });
+                    }
+                }
+            });
+        }
+
+        std::vector<std::jthread> threads;
+        for (size_t core = 0; core < cores; ++core) {
+            threads.emplace_back([&runtime, core] {
+                runtime.Run(core);
+            });
+        }
+        threads.clear();
+
+        THEN("each message runs on its destination core and each reply on its sender") {
+            CHECK(replies == cores * cores * messages);
+            CHECK(wrong_core == 0);
+            for (size_t to = 0; to < cores; ++to) {
+                for (size_t from = 0; from < cores; ++from)
+                    CHECK(received[to][from] == messages);
+            }
+        }
+    }
+
+    WHEN("a task is executed from a thread outside the cores") {
+        auto work = net::make_work_guard(*contexts[2]);
+        std::atomic<bool> done{false};
+        std::optional<size_t> core;
+        runtime.Execute(2, [&] {
+            core = runtime.CurrentCore();
+            done = true;
+            contexts[2]->stop();
+        });
+        runtime.Run(2);
+
+        THEN("it runs on the destination core") {
+            CHECK(done);
+            CHECK(core == 2);
+            CHECK_FALSE(runtime.CurrentCore());
+        }
+    }
+}
@@ -0,0 +1,191 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <utility>
+#include "../src/collision_detector.h"
+#include "../src/dog.h"
+#include "../src/dog_kinematics.h"
+#include "../src/road_graph.h"
+
+using namespace std::literals;
+using model::Point;
+using model::Road;
+using model::RoadType;
+
+namespace {
+
+constexpr double roadHalfWidth = 0.4;
+
+// Прямоугольное кольцо 40x30 с перемычкой посередине, тупиком справа
+// и продолжающей тупик дорогой
+model::Map MakeMap() {
+    model::Map map{model::Map::Id{"map"s}, "Map"s};
+    map.AddRoad(Road{Road::HORIZONTAL, Point{0, 0}, 40});
+    map.AddRoad(Road{Road::VERTICAL, Point{40, 0}, 30});
+    map.AddRoad(Road{Road::HORIZONTAL, Point{40, 30}, 0});
+    map.AddRoad(Road{Road::VERTICAL, Point{0, 30}, 0});
+    map.AddRoad(Road{Road::VERTICAL, Point{20, 0}, 30});
+    map.AddRoad(Road{Road::HORIZONTAL, Point{40, 15}, 60});
+    map.AddRoad(Road{Road::HORIZONTAL, Point{80, 15}, 60});
+    map.BuildRoadGraph();
+    map.BuildOfficeLayer();
+    return map;
+}
+
+using Edges = std::set<std::pair<size_t, RoadType>>;
+
+// Списки соседей, которые каждая собака строила в DogNavigator::FindAdjacentRoads
+// до появления общего графа карты, вместе с прежними проверками дорог
+std::vector<Edges> FindAdjacentRoadsReference(const model::Map::Roads& roads) {
+    auto roads_crossed = [](const Road& road1, const Road& road2) {
+        if ((road1.IsHorizontal() && road2.IsVertical()) || (road1.IsVertical() && road2.IsHorizontal())) {
+            const auto first_start = road1.GetStart();
+            const auto second_start = road2.GetStart();
+            const auto second_end = road2.GetEnd();
+            if (road1.IsHorizontal()) {
+                if (((second_start.y < first_start.y) && (second_end.y < first_start.y)) ||
+                    ((second_start.y > first_start.y) && (second_end.y > first_start.y)))
+                    return false;
+            } else if (road1.IsVertical()) {
+                if (((second_start.x < first_start.x) && (second_end.x < first_start.x)) ||
+                    ((second_start.x > first_start.x) && (second_end.x > first_start.x)))
+                    return false;
+            }
+            return true;
+        }
+        return false;
+    };
+    auto roads_adjacent = [](const Road& road1, const Road& road2) {
+        if ((road1.IsHorizontal() && road2.IsHorizontal()) || (road1.IsVertical() && road2.IsVertical())) {
+            auto first_start = road1.GetStart();
+            auto first_end = road1.GetEnd();
+            auto second_start = road2.GetStart();
+            auto second_end = road2.GetEnd();
+            return (first_start == second_start) || (first_start == second_end) ||
+                   (first_end == second_start) || (first_end == second_end);
+        }
+        return false;
+    };
+
+    std::vector<Edges> adjacent_roads(roads.size());
+    for (size_t i = 0; i < roads.size(); ++i) {
+        for (size_t j = i + 1; j < roads.size(); ++j) {
+            RoadType road_type{RoadType::Parallel};
+            if (roads_adjacent(roads[i], roads[j]))
+                road_type = RoadType::Adjacent;
+            else if (roads_crossed(roads[i], roads[j]))
+                road_type = RoadType::Crossed;
+
+            if (road_type != RoadType::Parallel) {
+                adjacent_roads[i].emplace(j, road_type);
+                adjacent_roads[j].emplace(i, road_type);
+            }
+        }
+    }
+    return adjacent_roads;
+}
+
+bool IsOnRoad(const model::DogPosition& position, const model::Map::Roads& roads) {
+    return std::any_of(roads.begin(), roads.end(), [&position](const Road& road) {
+        const auto [x_min, x_max] = std::minmax({road.GetStart().x, road.GetEnd().x});
+        const auto [y_min, y_max] = std::minmax({road.GetStart().y, road.GetEnd().y});
+        constexpr double eps = 1e-9;
+        return position.x >= x_min - roadHalfWidth - eps && position.x <= x_max + roadHalfWidth + eps &&
+               position.y >= y_min - roadHalfWidth - eps && position.y <= y_max + roadHalfWidth + eps;
+    });
+}
+
+}  // namespace
+
+SCENARIO("Road graph of a map") {
+    const auto map = MakeMap();
+    const auto& roads = map.GetRoads();
+    const auto& graph = map.GetRoadGraph();
+
+    THEN("it has the neighbours every dog used to find for itself") {
+        const auto reference = FindAdjacentRoadsReference(roads);
+        REQUIRE(graph.GetNumRoads() == roads.size());
+        for (size_t i = 0; i < roads.size(); ++i) {
+            INFO("road " << i);
+            Edges edges;
+            for (const auto& road : graph.GetAdjacentRoads(i))
+                edges.emplace(road.road_index, road.road_type);
+            for (const auto& road : graph.GetCrossRoads(i))
+                edges.emplace(road.road_index, road.road_type);
+            CHECK(edges == reference[i]);
+        }
+    }
+}
+
+SCENARIO("Dog movement across turns") {
+    const auto map = MakeMap();
+    const auto& roads = map.GetRoads();
+    model::Dog dog{&map, false, 3};
+
+    // Двигает собаку шагами по 100 мс, пока она не остановится, проверяя, что она не сходит с дорог
+    auto run = [&dog, &roads](model::DogDirection direction) {
+        dog.SetSpeed(direction, 3.0);
+        for (int step = 0; step < 1000; ++step) {
+            dog.Move(100);
+            INFO("step " << step << ": " << dog.GetPosition().x << ", " << dog.GetPosition().y);
+            REQUIRE(IsOnRoad(dog.GetPosition(), roads));
+            if (dog.GetSpeed().vx == 0.0 && dog.GetSpeed().vy == 0.0)
+                return;
+        }
+        FAIL("the dog did not stop");
+    };
+
+    WHEN("the dog runs around the ring, turning at corners") {
+        CHECK(dog.GetPosition().x == 0.0);
+        CHECK(dog.GetPosition().y == 0.0);
+
+        run(model::DogDirection::EAST);
+        CHECK(std::abs(dog.GetPosition().x - 40.4) < 1e-9);
+        CHECK(std::abs(dog.GetPosition().y) < 1e-9);
+
+        run(model::DogDirection::SOUTH);
+        CHECK(std::abs(dog.GetPosition().x - 40.4) < 1e-9);
+        CHECK(std::abs(dog.GetPosition().y - 30.4) < 1e-9);
+
+        run(model::DogDirection::WEST);
+        CHECK(std::abs(dog.GetPosition().x + 0.4) < 1e-9);
+        CHECK(std::abs(dog.GetPosition().y - 30.4) < 1e-9);
+
+        run(model::DogDirection::NORTH);
+        THEN("it stays on the roads and stops at the far edge of each corner") {
+            CHECK(std::abs(dog.GetPosition().x + 0.4) < 1e-9);
+            CHECK(std::abs(dog.GetPosition().y + 0.4) < 1e-9);
+        }
+    }
+
+    WHEN("the dog turns from the middle of a road into a side road") {
+        run(model::DogDirection::EAST);
+        run(model::DogDirection::SOUTH);
+        dog.SetSpeed(model::DogDirection::WEST, 1.0);
+        // 20 секунд на скорости 1 приводят собаку к перекрёстку с перемычкой x = 20
+        for (int step = 0; step < 204; ++step)
+            dog.Move(100);
+        REQUIRE(std::abs(dog.GetPosition().x - 20.0) < 1e-6);
+
+        run(model::DogDirection::NORTH);
+        THEN("it leaves along the side road and stops at its far end") {
+            CHECK(std::abs(dog.GetPosition().x - 20.0) < 1e-6);
+            CHECK(std::abs(dog.GetPosition().y + 0.4) < 1e-9);
+        }
+    }
+
+    WHEN("the dog turns into a dead end") {
+        run(model::DogDirection::EAST);
+        dog.SetSpeed(model::DogDirection::SOUTH, 1.0);
+        for (int step = 0; step < 150; ++step)
+            dog.Move(100);
+        REQUIRE(std::abs(dog.GetPosition().y - 15.0) < 1e-6);
+
+        run(model::DogDirection::EAST);
+        THEN("it stops at its end") {
+            CHECK(std::abs(dog.GetPosition().x - 60.4) < 1e-9);
+            CHECK(std::abs(dog.GetPosition().y - 15.0) < 1e-6);
+        }
+    }
+}
@@ -0,0 +1,248 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <random>
+#include <string>
+#include <vector>
+#include "../src/model.h"
+#include "../src/game_session.h"
+#include "../src/road_graph.h"
+#include "../src/collision_detector.h"
+#include "../src/utils.h"
+#include "../src/json_serializer.h"
+#include "../src/binary_serializer.h"
+#include "json_dom_reference.h"
+
+using namespace std::literals;
+
+namespace {
+
+model::Game MakeBenchmarkGame() {
+    model::Map map{model::Map::Id{"bench"s}, "Benchmark map"s};
+    map.AddRoad(model::Road{model::Road::HORIZONTAL, model::Point{0, 0}, 100});
+    map.AddRoad(model::Road{model::Road::VERTICAL, model::Point{100, 0}, 100});
+    map.BuildRoadGraph();
+    map.BuildOfficeLayer();
+    map.AddLoot(model::Loot{"key"s, "assets/key.obj"s, "obj"s, 90, "#338844"s, 0.03, 10});
+    map.AddLoot(model::Loot{"wallet"s, "assets/wallet.obj"s, "obj"s, 0, "#883344"s, 0.01, 30});
+
+    model::Game game;
+    game.AddMap(map);
+    return game;
+}
+
+// Город из квадратных кварталов: каждая улица разбита на отрезки длиной в один квартал.
+// 158 кварталов по каждой стороне дают 50244 дороги
+model::Map MakeCityMap(int blocks, int block_size) {
+    model::Map map{model::Map::Id{"city"s}, "Synthetic city"s};
+    for (int i = 0; i <= blocks; ++i) {
+        for (int j = 0; j < blocks; ++j) {
+            map.AddRoad(model::Road{model::Road::HORIZONTAL, model::Point{j * block_size, i * block_size}, (j + 1) * block_size});
+            map.AddRoad(model::Road{model::Road::VERTICAL, model::Point{i * block_size, j * block_size}, (j + 1) * block_size});
+        }
+    }
+    return map;
+}
+
+// Сетка из сквозных улиц: каждая улица - одна длинная дорога, поэтому собаки
+// долго идут по ней, не упираясь в конец отрезка
+model::Map MakeStreetMap(int streets, int length) {
+    model::Map map{model::Map::Id{"streets"s}, "Synthetic streets"s};
+    const int step = length / streets;
+    for (int i = 0; i < streets; ++i) {
+        map.AddRoad(model::Road{model::Road::HORIZONTAL, model::Point{0, i * step}, length});
+        map.AddRoad(model::Road{model::Road::VERTICAL, model::Point{i * step, 0}, length});
+    }
+    map.BuildRoadGraph();
+    map.BuildOfficeLayer();
+    return map;
+}
+
+std::vector<std::string> AddPlayers(model::Game& game, size_t num_players) {
+    std::vector<std::string> tokens;
+    tokens.reserve(num_players);
+    for (size_t i = 0; i < num_players; ++i) {
+        auto [token, id] = game.AddPlayer("bench"s, "player"s + std::to_string(i));
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+// Прежняя реализация utils::GetRandomNumber: новый генератор и обращение к random_device на каждый вызов
+template <typename T>
+T LegacyRandomNumber(T minValue, T maxValue) {
+    std::mt19937 engine;
+    std::random_device device;
+    engine.seed(device());
+    std::uniform_int_distribution<T> distribution(minValue, maxValue);
+    return distribution(engine);
+}
+
+}  // namespace
+
+TEST_CASE("Player lookup by auth token", "[benchmark]") {
+    for (size_t num_players : {100, 1000, 10000}) {
+        model::Game game = MakeBenchmarkGame();
+        const auto tokens = AddPlayers(game, num_players);
+
+        size_t next = 0;
+        BENCHMARK("FindPlayerSession, players: "s + std::to_string(num_players)) {
+            return game.FindPlayerSession(tokens[next++ % tokens.size()]).has_value();
+        };
+    }
+}
+
+TEST_CASE("Road graph on a 50k-road map", "[benchmark]") {
+    model::Map map = MakeCityMap(158, 10);
+    REQUIRE(map.GetNumRoads() > 50000);
+
+    BENCHMARK("Build road graph, roads: "s + std::to_string(map.GetNumRoads())) {
+        return model::RoadGraph{map.GetRoads()};
+    };
+
+    map.BuildRoadGraph();
+    map.BuildOfficeLayer();
+    model::Dog dog{&map, false, 3};
+    const model::DogDirection route[] = {model::DogDirection::EAST, model::DogDirection::SOUTH};
+    size_t step = 0;
+    BENCHMARK("Dog move with turns, roads: "s + std::to_string(map.GetNumRoads())) {
+        dog.SetSpeed(route[(step++ / 8) % 2], 4.0);
+        return dog.Move(300);
+    };
+}
+
+TEST_CASE("Loot generation per tick", "[benchmark]") {
+    constexpr size_t num_players = 1000;
+    model::Game game = MakeBenchmarkGame();
+    game.SetLootParameters(5.0, 0.5);
+    const auto tokens = AddPlayers(game, num_players);
+    const auto session = game.FindPlayerSession(tokens.front())->session;
+    const model::Map *map = game.FindMap(model::Map::Id{"bench"s});
+
+    // Каждый трофей - три случайных числа: тип, дорога и позиция на дороге
+    BENCHMARK("Random numbers for "s + std::to_string(num_players) + " loots, per-call random_device (before)"s) {
+        size_t sum = 0;
+        for (size_t i = 0; i < num_players; ++i) {
+            sum += LegacyRandomNumber<size_t>(0, 1) + LegacyRandomNumber<size_t>(0, 1) + LegacyRandomNumber<int>(0, 100);
+        }
+        return sum;
+    };
+
+    BENCHMARK("Random numbers for "s + std::to_string(num_players) + " loots, thread-local generator (after)"s) {
+        size_t sum = 0;
+        for (size_t i = 0; i < num_players; ++i) {
+            sum += utils::GetRandomNumber<size_t>(0, 1) + utils::GetRandomNumber<size_t>(0, 1) + utils::GetRandomNumber<int>(0, 100);
+        }
+        return sum;
+    };
+
+    BENCHMARK_ADVANCED("GenerateLoot, players without loot: "s + std::to_string(num_players))(Catch::Benchmark::Chronometer meter) {
+        std::vector<model::GameSession> sessions(meter.runs(), *session);
+        meter.measure([&sessions, map](int run) {
+            sessions[run].GenerateLoot(60000, map);
+            return sessions[run].GetLootsInfo().size();
+        });
+    };
+}
+
+TEST_CASE("Session tick with many dogs", "[benchmark]") {
+    const model::Map map = MakeStreetMap(100, 10000);
+    for (size_t num_dogs : {1000, 10000, 100000}) {
+        model::GameSession session{"streets"s, 5.0, 0.5};
+        for (size_t i = 0; i < num_dogs; ++i) {
+            auto dog = session.AddPlayer("dog"s + std::to_string(i), const_cast<model::Map*>(&map), true, 3)->GetDog();
+            const bool horizontal = map.GetRoads()[dog->GetPositionOnMap().current_road_index].IsHorizontal();
+            const bool forward = i % 2 == 0;
+            dog->SetSpeed(horizontal ? (forward ? model::DogDirection::EAST : model::DogDirection::WEST)
+                                     : (forward ? model::DogDirection::SOUTH : model::DogDirection::NORTH), 1.0);
+        }
+
+        // Обратная величина среднего времени - число тиков в секунду
+        BENCHMARK("MoveDogs, dogs: "s + std::to_string(num_dogs)) {
+            session.MoveDogs(50);
+            return session.GetNumPlayers();
+        };
+    }
+}
+
+TEST_CASE("State serialization, JSON and binary", "[benchmark]") {
+    const model::Map map = MakeStreetMap(100, 10000);
+    for (size_t num_dogs : {100, 1000, 10000}) {
+        model::GameSession session{"streets"s, 5.0, 0.5};
+        std::vector<model::LootInfo> loots;
+        for (size_t i = 0; i < num_dogs; ++i) {
+            auto dog = session.AddPlayer("dog"s + std::to_string(i), const_cast<model::Map*>(&map), true, 3)->GetDog();
+            dog->SetSpeed(i % 2 == 0 ? model::DogDirection::EAST : model::DogDirection::NORTH, 1.3);
+            const auto pos = dog->GetPosition();
+            loots.emplace_back(static_cast<unsigned>(i), static_cast<unsigned>(i % 3), pos.x + 0.25, pos.y - 0.125);
+        }
+        session.MoveDogs(37);
+        const auto& players = session.GetPlayers();
+
+        const auto json_size = json_serializer::GetPlayersDogInfoResponce(players, loots).size();
+        const auto binary_size = binary_serializer::GetPlayersDogInfoBinary(1, players, loots).size();
+        WARN("dogs: " << num_dogs << ", JSON bytes: " << json_size << ", binary bytes: " << binary_size);
+        CHECK(binary_size < json_size);
+
+        BENCHMARK("GetPlayersDogInfoResponce, dogs: "s + std::to_string(num_dogs)) {
+            return json_serializer::GetPlayersDogInfoResponce(players, loots).size();
+        };
+        BENCHMARK("GetPlayersDogInfoBinary, dogs: "s + std::to_string(num_dogs)) {
+            return binary_serializer::GetPlayersDogInfoBinary(1, players, loots).size();
+        };
+    }
+}
+
+TEST_CASE("JSON responses, boost::json DOM and streaming writer", "[benchmark]") {
+    model::Game game = MakeBenchmarkGame();
+    game.AddMap(MakeCityMap(20, 50));
+    const model::Map& city = game.GetMaps().back();
+    const std::string city_id = *city.GetId();
+
+    const model::Map map = MakeStreetMap(100, 10000);
+    model::GameSession session{"streets"s, 5.0, 0.5};
+    std::vector<model::LootInfo> loots;
+    for (size_t i = 0; i < 1000; ++i) {
+        auto dog = session.AddPlayer("dog"s + std::to_string(i), const_cast<model::Map*>(&map), true, 3)->GetDog();
+        dog->SetSpeed(i % 2 == 0 ? model::DogDirection::EAST : model::DogDirection::NORTH, 1.3);
+        const auto pos = dog->GetPosition();
+        loots.emplace_back(static_cast<unsigned>(i), static_cast<unsigned>(i % 3), pos.x + 0.25, pos.y - 0.125);
+    }
+    session.MoveDogs(37);
+    const auto& players = session.GetPlayers();
+
+    std::vector<model::PlayerRecordItem> records;
+    for (int i = 0; i < 100; ++i) {
+        records.push_back({"id"s + std::to_string(i), "player"s + std::to_string(i), i * 10, 1000 + i * 37});
+    }
+
+    BENCHMARK("State, 1000 dogs, DOM") {
+        return json_dom_reference::GetPlayersDogInfoResponce(players, loots).size();
+    };
+    BENCHMARK("State, 1000 dogs, streaming") {
+        return json_serializer::GetPlayersDogInfoResponce(players, loots).size();
+    };
+    BENCHMARK("Players, 1000 players, DOM") {
+        return json_dom_reference::GetPlayerInfoResponce(players).size();
+    };
+    BENCHMARK("Players, 1000 players, streaming") {
+        return json_serializer::GetPlayerInfoResponce(players).size();
+    };
+    BENCHMARK("Map, "s + std::to_string(city.GetNumRoads()) + " roads, DOM"s) {
+        return json_dom_reference::GetMapContentResponce(game, city_id).size();
+    };
+    BENCHMARK("Map, "s + std::to_string(city.GetNumRoads()) + " roads, streaming"s) {
+        return json_serializer::GetMapContentResponce(game, city_id).size();
+    };
+    BENCHMARK("Maps, DOM") {
+        return json_dom_reference::GetMapListResponce(game).size();
+    };
+    BENCHMARK("Maps, streaming") {
+        return json_serializer::GetMapListResponce(game).size();
+    };
+    BENCHMARK("Records, 100 items, DOM") {
+        return json_dom_reference::MakeRecordsResponce(records).size();
+    };
+    BENCHMARK("Records, 100 items, streaming") {
+        return json_serializer::MakeRecordsResponce(records).size();
+    };
+}
@@ -0,0 +1,237 @@
+#include <catch2/catch_test_macros.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "../src/http_server.h"
+
+using namespace std::literals;
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+using tcp = net::ip::tcp;
+
+namespace {
+
+// Обработчик запросов для проверки сессии: /slow/<n> отвечает через 100 мс из другого потока,
+// /fast/<n> - сразу, /file - содержимым файла через sendfile. Ведёт журнал начала и конца обработки
+class TestHandler {
+public:
+    struct State {
+        net::io_context worker;
+        std::string file_path;
+        std::mutex mutex;
+        std::vector<std::string> events;
+
+        void Log(std::string event) {
+            std::lock_guard lock{mutex};
+            events.push_back(std::move(event));
+        }
+    };
+
+    explicit TestHandler(std::shared_ptr<State> state) : state_{std::move(state)} {}
+
+    template <typename Send>
+    void operator()(http::request<http::string_body>&& req, Send&& send) {
+        if constexpr (std::is_same_v<std::decay_t<Send>, beast::tcp_stream>) {
+            return;
+        } else {
+            const std::string target{req.target()};
+            state_->Log("start " + target);
+            if (target == "/file") {
+                const int fd = ::open(state_->file_path.c_str(), O_RDONLY | O_CLOEXEC);
+                const auto size = static_cast<std::uint64_t>(::lseek(fd, 0, SEEK_END));
+                http::response<http_server::SendfileBody> resp{http::status::ok, req.version()};
+                resp.body().file = std::make_shared<const static_cache::OpenFile>(fd, size, 0);
+                resp.body().parts.push_back({{}, {0, size}});
+                resp.keep_alive(req.keep_alive());
+                resp.prepare_payload();
+                state_->Log("done " + target);
+                return send(std::move(resp));
+            }
+
+            http::response<http::string_body> resp{http::status::ok, req.version()};
+            resp.body() = target;
+            resp.keep_alive(req.keep_alive());
+            resp.prepare_payload();
+            if (target.starts_with("/slow/")) {
+                auto timer = std::make_shared<net::steady_timer>(state_->worker, 100ms);
+                timer->async_wait([timer, state = state_, target, resp = std::move(resp), send](beast::error_code) mutable {
+                    state->Log("done " + target);
+                    send(std::move(resp));
+                });
+                return;
+            }
+            state_->Log("done " + target);
+            send(std::move(resp));
+        }
+    }
+
+private:
+    std::shared_ptr<State> state_;
+};
+
+// Сервер с одним потоком для соединений и одним для отложенных ответов
+class TestServer {
+public:
+    explicit TestServer(std::chrono::milliseconds timeout, std::string file_path = {})
+        : state_{std::make_shared<TestHandler::State>()}, timeout_{timeout} {
+        state_->file_path = std::move(file_path);
+        acceptor_.open(tcp::v4());
+        acceptor_.bind({net::ip::make_address("127.0.0.1"), 0});
+        acceptor_.listen();
+        Accept();
+        threads_.emplace_back([this] { ioc_.run(); });
+        threads_.emplace_back([this] { state_->worker.run(); });
+    }
+
+    ~TestServer() {
+        ioc_.stop();
+        state_->worker.stop();
+    }
+
+    unsigned short GetPort() const { return acceptor_.local_endpoint().port(); }
+
+    std::vector<std::string> GetEvents() const {
+        std::lock_guard lock{state_->mutex};
+        return state_->events;
+    }
+
+private:
+    void Accept() {
+        acceptor_.async_accept(net::make_strand(ioc_), [this](beast::error_code ec, tcp::socket socket) {
+            if (ec)
+                return;
+            std::make_shared<http_server::Session<TestHandler>>(std::move(socket), TestHandler{state_}, timeout_)->Run();
+            Accept();
+        });
+    }
+
+    std::shared_ptr<TestHandler::State> state_;
+    std::chrono::milliseconds timeout_;
+    net::io_context ioc_;
+    net::executor_work_guard<net::io_context::executor_type> work_{ioc_.get_executor()};
+    net::executor_work_guard<net::io_context::executor_type> worker_work_{state_->worker.get_executor()};
+    tcp::acceptor acceptor_{ioc_};
+    std::vector<std::jthread> threads_;
+};
+
+tcp::socket Connect(net::io_context& ioc, unsigned short port) {
+    tcp::socket socket{ioc};
+    socket.connect({net::ip::make_address("127.0.0.1"), port});
+    // Тест не должен зависнуть, если сервер не ответит
+    timeval timeout{5, 0};
+    ::setsockopt(socket.native_handle(), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return socket;
+}
+
+std::string MakeRequests(const std::vector<std::pair<http::verb, std::string>>& requests) {
+    std::string result;
+    for (const auto& [method, target] : requests) {
+        result += std::string(http::to_string(method)) + " " + target + " HTTP/1.1\r\nHost: test\r\nContent-Length: 0\r\n\r\n";
+    }
+    return result;
+}
+
+size_t IndexOf(const std::vector<std::string>& events, const std::string& event) {
+    return std::find(events.begin(), events.end(), event) - events.begin();
+}
+
+}  // namespace
+
+SCENARIO("Pipelined requests") {
+    TestServer server{2s};
+    net::io_context ioc;
+    auto socket = Connect(ioc, server.GetPort());
+
+    WHEN("a client pipelines slow and fast requests, including a POST") {
+        net::write(socket, net::buffer(MakeRequests({{http::verb::get, "/slow/1"},
+                                                     {http::verb::get, "/fast/2"},
+                                                     {http::verb::get, "/slow/3"},
+                                                     {http::verb::post, "/slow/4"},
+                                                     {http::verb::get, "/fast/5"}})));
+
+        std::vector<std::string> bodies;
+        beast::flat_buffer buffer;
+        for (int i = 0; i < 5; ++i) {
+            http::response<http::string_body> response;
+            http::read(socket, buffer, response);
+            bodies.push_back(response.body());
+        }
+
+        THEN("responses come in request order") {
+            CHECK(bodies == std::vector<std::string>{"/slow/1", "/fast/2", "/slow/3", "/slow/4", "/fast/5"});
+        }
+
+        THEN("safe requests are handled concurrently and requests around a POST wait for it") {
+            const auto events = server.GetEvents();
+            CHECK(IndexOf(events, "start /fast/2") < IndexOf(events, "done /slow/1"));
+            CHECK(IndexOf(events, "start /slow/3") < IndexOf(events, "done /slow/1"));
+            CHECK(IndexOf(events, "start /slow/4") > IndexOf(events, "done /slow/3"));
+            CHECK(IndexOf(events, "start /fast/5") > IndexOf(events, "done /slow/4"));
+        }
+    }
+}
+
+SCENARIO("Session timeouts") {
+    WHEN("a client opens a connection and sends nothing") {
+        TestServer server{200ms};
+        net::io_context ioc;
+        auto socket = Connect(ioc, server.GetPort());
+        const auto start = std::chrono::steady_clock::now();
+        char byte;
+        beast::error_code ec;
+        socket.read_some(net::buffer(&byte, 1), ec);
+
+        THEN("the server closes it after the idle timeout") {
+            CHECK(ec == net::error::eof);
+            CHECK(std::chrono::steady_clock::now() - start < 3s);
+        }
+    }
+
+    WHEN("a file download outlasts the timeout while the next request is being read") {
+        const auto path = std::filesystem::temp_directory_path() / ("http_server_tests_" + std::to_string(::getpid()));
+        std::string content(32 * 1024 * 1024, '\0');
+        for (size_t i = 0; i < content.size(); ++i)
+            content[i] = static_cast<char>(i * 31 % 251);
+        std::ofstream(path, std::ios::binary) << content;
+
+        TestServer server{200ms, path.string()};
+        net::io_context ioc;
+        auto socket = Connect(ioc, server.GetPort());
+
+        // Ответ на первый запрос задерживается, поэтому сервер читает дальше, пока его готовят
+        net::write(socket, net::buffer(MakeRequests({{http::verb::get, "/slow/1"}, {http::verb::get, "/file"}})));
+        beast::flat_buffer buffer{64 * 1024};
+        http::response<http::string_body> first;
+        http::read(socket, buffer, first);
+
+        // Второй ответ читаем медленно, чтобы его отправка длилась дольше таймаута
+        std::string received = beast::buffers_to_string(buffer.data());
+        std::array<char, 64 * 1024> chunk;
+        beast::error_code ec;
+        const auto start = std::chrono::steady_clock::now();
+        size_t header_size = std::string::npos;
+        while (!ec && (header_size == std::string::npos || received.size() < header_size + content.size())) {
+            received.append(chunk.data(), socket.read_some(net::buffer(chunk), ec));
+            if (const auto end = received.find("\r\n\r\n"); header_size == std::string::npos && end != std::string::npos)
+                header_size = end + 4;
+            std::this_thread::sleep_for(2ms);
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        std::filesystem::remove(path);
+
+        THEN("the whole file arrives") {
+            CHECK(first.body() == "/slow/1");
+            REQUIRE_FALSE(ec);
+            CHECK(elapsed > 200ms);
+            CHECK(received.starts_with("HTTP/1.1 200 OK\r\n"));
+            CHECK(received.compare(header_size, std::string::npos, content) == 0);
+        }
+    }
+}
@@ -0,0 +1,304 @@
+#pragma once
+// Прежняя реализация ответов json_serializer через дерево boost::json. Используется
+// как эталон: потоковая запись должна давать тот же вывод байт в байт
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <boost/json.hpp>
+#include "../src/game_session.h"
+#include "../src/state_history.h"
+
+namespace json_dom_reference {
+
+namespace json = boost::json;
+using model::DogDirection;
+
+inline std::string GetPlayerInfoResponce(const std::vector<std::shared_ptr<model::Player>> &players_info)
+{
+    json::object resp_object;
+
+    for (auto &player : players_info)
+    {
+        json::object name_object;
+        name_object["name"] = player->GetName();
+
+        resp_object[std::to_string(player->GetId())] = name_object;
+    }
+
+    return json::serialize(resp_object);
+}
+
+inline json::array SerializeDogBag(const std::vector<model::LootInfo> &loots)
+{
+    json::array bag_ar;
+
+    for (const auto &cur_loot : loots)
+    {
+        json::object loot_object;
+
+        loot_object["id"] = cur_loot.id;
+        loot_object["type"] = cur_loot.type;
+
+        bag_ar.emplace_back(loot_object);
+    }
+
+    return bag_ar;
+}
+
+inline json::object SerializePlayers(const std::vector<std::shared_ptr<model::Player>> &players)
+{
+    json::object players_object;
+
+    for (auto &player : players)
+    {
+        auto dog = player->GetDog();
+
+        json::object dog_object;
+        json::array pos_ar, speed_ar;
+
+        auto pos = dog->GetPosition();
+        pos_ar.emplace_back(pos.x);
+        pos_ar.emplace_back(pos.y);
+
+        dog_object["pos"] = pos_ar;
+
+        auto speed = dog->GetSpeed();
+        speed_ar.emplace_back(speed.vx);
+        speed_ar.emplace_back(speed.vy);
+
+        dog_object["speed"] = speed_ar;
+
+        DogDirection dir = dog->GetDirection();
+        dog_object["dir"] = model::ConvertDogDirectionToString(dir);
+
+        dog_object["bag"] = SerializeDogBag(dog->GetGatheredLoot());
+        dog_object["score"] = dog->GetScore();
+        players_object[std::to_string(player->GetId())] = dog_object;
+    }
+
+    return players_object;
+}
+
+inline json::object SerializeLoots(const std::vector<model::LootInfo> &loots)
+{
+    json::object loots_object;
+
+    for (size_t i = 0; i < loots.size(); ++i)
+    {
+        json::object loot_object;
+        json::array pos_ar;
+
+        pos_ar.emplace_back(loots[i].x);
+        pos_ar.emplace_back(loots[i].y);
+
+        loot_object["pos"] = pos_ar;
+        loot_object["type"] = loots[i].type;
+        loots_object[std::to_string(i)] = loot_object;
+    }
+
+    return loots_object;
+}
+
+inline std::string GetPlayersDogInfoResponce(const std::vector<std::shared_ptr<model::Player>> &players, const std::vector<model::LootInfo> &loots)
+{
+    json::object resp_object;
+
+    resp_object["players"] = SerializePlayers(players);
+    resp_object["lostObjects"] = SerializeLoots(loots);
+    return json::serialize(resp_object);
+}
+// В потоке версий трофеи адресуются постоянными идентификаторами, а не номером в списке
+inline json::object SerializeLootsById(const std::vector<model::LootInfo> &loots, const std::vector<unsigned> *ids)
+{
+    json::object loots_object;
+
+    for (const auto &loot : loots)
+    {
+        if (ids && !std::binary_search(ids->begin(), ids->end(), loot.id))
+            continue;
+
+        json::object loot_object;
+        json::array pos_ar;
+
+        pos_ar.emplace_back(loot.x);
+        pos_ar.emplace_back(loot.y);
+
+        loot_object["pos"] = pos_ar;
+        loot_object["type"] = loot.type;
+        loots_object[std::to_string(loot.id)] = loot_object;
+    }
+
+    return loots_object;
+}
+
+inline json::array SerializeIds(const std::vector<unsigned> &ids)
+{
+    json::array ids_ar;
+    for (auto id : ids)
+        ids_ar.emplace_back(id);
+    return ids_ar;
+}
+
+inline std::string GetPlayersDogDeltaResponce(std::uint64_t version, const std::vector<std::shared_ptr<model::Player>> &players,
+                                       const std::vector<model::LootInfo> &loots, const model::StateDelta *delta)
+{
+    json::object resp_object;
+    resp_object["tick"] = version;
+    resp_object["full"] = delta == nullptr;
+
+    if (!delta)
+    {
+        resp_object["players"] = SerializePlayers(players);
+        resp_object["lostObjects"] = SerializeLootsById(loots, nullptr);
+        return json::serialize(resp_object);
+    }
+
+    std::vector<std::shared_ptr<model::Player>> changed_players;
+    for (const auto &player : players)
+    {
+        if (std::binary_search(delta->changed_players.begin(), delta->changed_players.end(), player->GetId()))
+            changed_players.push_back(player);
+    }
+
+    resp_object["players"] = SerializePlayers(changed_players);
+    resp_object["removedPlayers"] = SerializeIds(delta->removed_players);
+    resp_object["lostObjects"] = SerializeLootsById(loots, &delta->added_loots);
+    resp_object["removedObjects"] = SerializeIds(delta->removed_loots);
+    return json::serialize(resp_object);
+}
+
+inline void SerializeOffices(const model::Map &map, json::object &root)
+{
+    json::array offices_ar;
+    for (const auto &office : map.GetOffices())
+    {
+        json::object office_obj;
+
+        office_obj["id"] = *office.GetId();
+        office_obj["x"] = office.GetPosition().x;
+        office_obj["y"] = office.GetPosition().y;
+        office_obj["offsetX"] = office.GetOffset().dx;
+        office_obj["offsetY"] = office.GetOffset().dy;
+
+        offices_ar.emplace_back(office_obj);
+    }
+    root["offices"] = offices_ar;
+}
+
+inline void SerializeBuildings(const model::Map &map, json::object &root)
+{
+    json::array buildings_ar;
+    for (const auto &building : map.GetBuildings())
+    {
+        json::object building_obj;
+
+        const auto &bounds = building.GetBounds();
+
+        building_obj["x"] = bounds.position.x;
+        building_obj["y"] = bounds.position.y;
+        building_obj["w"] = bounds.size.width;
+        building_obj["h"] = bounds.size.height;
+
+        buildings_ar.emplace_back(building_obj);
+    }
+    root["buildings"] = buildings_ar;
+}
+
+inline void SerializeRoads(const model::Map &map, json::object &root)
+{
+    json::array roads_ar;
+    for (const auto &road : map.GetRoads())
+    {
+        json::object road_obj;
+
+        model::Point start = road.GetStart();
+        model::Point end = road.GetEnd();
+
+        road_obj["x0"] = start.x;
+        road_obj["y0"] = start.y;
+
+        if (road.IsHorizontal())
+            road_obj["x1"] = end.x;
+        else
+            road_obj["y1"] = end.y;
+
+        roads_ar.emplace_back(road_obj);
+    }
+    root["roads"] = roads_ar;
+}
+
+inline void SerializeLoots(const model::Map &map, json::object &root)
+{
+    json::array loots_ar;
+    for (const auto &loot : map.GetLoots())
+    {
+        json::object loot_obj;
+
+        loot_obj["name"] = loot.GetName();
+        loot_obj["file"] = loot.GetFile();
+        loot_obj["type"] = loot.GetType();
+
+        if (loot.GetRotation() >= 0)
+            loot_obj["rotation"] = loot.GetRotation();
+
+        if (!loot.GetColor().empty())
+            loot_obj["color"] = loot.GetColor();
+
+        loot_obj["scale"] = loot.GetScale();
+        loot_obj["value"] = loot.GetScore();
+        loots_ar.emplace_back(loot_obj);
+    }
+    root["lootTypes"] = loots_ar;
+}
+
+inline std::string GetMapListResponce(const model::Game &game)
+{
+    json::array map_ar;
+    for (const auto &map : game.GetMaps())
+    {
+        json::object map_obj;
+
+        map_obj["id"] = *map.GetId();
+        map_obj["name"] = map.GetName();
+        map_ar.emplace_back(map_obj);
+    }
+
+    return json::serialize(map_ar);
+}
+
+inline std::string GetMapContentResponce(const model::Game &game, const std::string &map_id)
+{
+    const model::Map *mapFound = game.FindMap(model::Map::Id(map_id));
+
+    if (!mapFound)
+        return ("");
+
+    json::object root;
+
+    root["id"] = *mapFound->GetId();
+    root["name"] = mapFound->GetName();
+
+    SerializeRoads(*mapFound, root);
+    SerializeBuildings(*mapFound, root);
+    SerializeOffices(*mapFound, root);
+    SerializeLoots(*mapFound, root);
+    return json::serialize(root);
+}
+
+inline std::string MakeRecordsResponce(const std::vector<model::PlayerRecordItem> &records)
+{
+    json::array map_ar;
+    for (const auto &record : records)
+    {
+        json::object map_obj;
+
+        map_obj["name"] = record.name;
+        map_obj["score"] = record.score;
+        map_obj["playTime"] = (double)record.playTime / 1000;
+        map_ar.emplace_back(map_obj);
+    }
+
+    return json::serialize(map_ar);
+}
+
+}  // namespace json_dom_reference
@@ -0,0 +1,136 @@
+#include <cstring>
+#include <limits>
+#include <random>
+#include <catch2/catch_test_macros.hpp>
+#include <boost/json.hpp>
+#include "../src/json_writer.h"
+#include "../src/json_serializer.h"
+#include "json_dom_reference.h"
+
+using namespace std::literals;
+namespace json = boost::json;
+using json_serializer::JsonWriter;
+
+namespace {
+
+template <typename Write>
+std::string WriteValue(Write write) {
+    std::string out;
+    JsonWriter writer(out);
+    write(writer);
+    return out;
+}
+
+model::Map MakeMap() {
+    model::Map map{model::Map::Id{"map\"1"s}, "Карта \\ \t1"s};
+    map.AddRoad(model::Road{model::Road::HORIZONTAL, model::Point{0, 0}, 40});
+    map.AddRoad(model::Road{model::Road::VERTICAL, model::Point{40, 0}, 30});
+    map.AddRoad(model::Road{model::Road::HORIZONTAL, model::Point{40, 30}, 0});
+    map.AddBuilding(model::Building{model::Rectangle{model::Point{5, 5}, model::Size{30, 20}}});
+    map.AddOffice(model::Office{model::Office::Id{"o0"s}, model::Point{40, 30}, model::Offset{5, -5}});
+    map.AddLoot(model::Loot{"key"s, "assets/key.obj"s, "obj"s, 90, "#338844"s, 0.03, 10});
+    map.AddLoot(model::Loot{"wallet"s, "assets/wallet.obj"s, "obj"s, -1, ""s, 0.01, 30});
+    map.BuildRoadGraph();
+    map.BuildOfficeLayer();
+    return map;
+}
+
+}  // namespace
+
+TEST_CASE("JsonWriter scalars match json::serialize") {
+    SECTION("doubles") {
+        std::vector<double> values{0.0, -0.0, 1.0, 40.0, 1.5, 0.1, -2.5, 123.456, 1e21, 1e-7, 5e-324,
+                                   std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest()};
+        std::mt19937_64 engine{7};
+        for (int i = 0; i < 10000; ++i) {
+            const auto bits = engine();
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            if (std::isfinite(value)) {
+                values.push_back(value);
+            }
+        }
+        std::uniform_real_distribution<double> coord{-1000.0, 1000.0};
+        for (int i = 0; i < 10000; ++i) {
+            values.push_back(coord(engine));
+        }
+
+        for (double value : values) {
+            CHECK(WriteValue([value](JsonWriter& w) { w.Double(value); }) == json::serialize(json::value(value)));
+        }
+    }
+    SECTION("integers") {
+        for (std::int64_t value : {std::int64_t{0}, std::int64_t{-1}, std::int64_t{42}, std::numeric_limits<std::int64_t>::min(),
+                                   std::numeric_limits<std::int64_t>::max()}) {
+            CHECK(WriteValue([value](JsonWriter& w) { w.Int(value); }) == json::serialize(json::value(value)));
+        }
+        for (std::uint64_t value : {std::uint64_t{0}, std::uint64_t{7}, std::numeric_limits<std::uint64_t>::max()}) {
+            CHECK(WriteValue([value](JsonWriter& w) { w.Uint(value); }) == json::serialize(json::value(value)));
+        }
+    }
+    SECTION("strings") {
+        std::string control;
+        for (char c = 0; c < 0x20; ++c) {
+            control.push_back(c);
+        }
+        for (std::string value : {""s, "plain"s, "quote \" and \\ backslash"s, "/slash"s, "Юникод ✓"s, control, "\x7f"s}) {
+            CHECK(WriteValue([&value](JsonWriter& w) { w.String(value); }) == json::serialize(json::value(value)));
+        }
+    }
+    SECTION("nested containers") {
+        json::object expected;
+        expected["a"] = json::array{1, 2.5, "x", true, nullptr};
+        expected["7"] = json::object{};
+        expected["e"] = json::array{};
+
+        const auto written = WriteValue([](JsonWriter& w) {
+            w.BeginObject();
+            w.Key("a").BeginArray().Int(1).Double(2.5).String("x").Bool(true).Null().EndArray();
+            w.Key(7).BeginObject().EndObject();
+            w.Key("e").BeginArray().EndArray();
+            w.EndObject();
+        });
+        CHECK(written == json::serialize(expected));
+    }
+}
+
+TEST_CASE("Streaming responses match the boost::json DOM responses") {
+    model::Game game;
+    game.AddMap(MakeMap());
+    game.AddMap(model::Map{model::Map::Id{"second"s}, "Вторая"s});
+    const model::Map& map = game.GetMaps().front();
+
+    model::GameSession session{*map.GetId(), 5.0, 0.5};
+    for (int i = 0; i < 20; ++i) {
+        auto dog = session.AddPlayer("player \""s + std::to_string(i), const_cast<model::Map*>(&map), true, 3)->GetDog();
+        dog->SetSpeed(i % 2 == 0 ? model::DogDirection::EAST : model::DogDirection::SOUTH, 1.3 + i * 0.1);
+    }
+    session.MoveDogs(137);
+
+    model::LootStorage storage;
+    for (unsigned i = 0; i < 10; ++i) {
+        storage.Add(model::LootInfo{0, i % 2, 0.3 * i, 30.0 - 0.7 * i});
+    }
+    const auto& loots = storage.GetLoots();
+    const auto& players = session.GetPlayers();
+
+    CHECK(json_serializer::GetPlayerInfoResponce(players) == json_dom_reference::GetPlayerInfoResponce(players));
+    CHECK(json_serializer::GetPlayersDogInfoResponce(players, loots) == json_dom_reference::GetPlayersDogInfoResponce(players, loots));
+    CHECK(json_serializer::GetPlayersDogDeltaResponce(3, players, loots, nullptr) ==
+          json_dom_reference::GetPlayersDogDeltaResponce(3, players, loots, nullptr));
+
+    model::StateDelta delta;
+    delta.changed_players = {1, 4, 5};
+    delta.removed_players = {100, 200};
+    delta.added_loots = {loots[2].id, loots[7].id};
+    delta.removed_loots = {12345};
+    CHECK(json_serializer::GetPlayersDogDeltaResponce(4, players, loots, &delta) ==
+          json_dom_reference::GetPlayersDogDeltaResponce(4, players, loots, &delta));
+
+    CHECK(json_serializer::GetMapListResponce(game) == json_dom_reference::GetMapListResponce(game));
+    CHECK(json_serializer::GetMapContentResponce(game, *map.GetId()) == json_dom_reference::GetMapContentResponce(game, *map.GetId()));
+    CHECK(json_serializer::GetMapContentResponce(game, "second"s) == json_dom_reference::GetMapContentResponce(game, "second"s));
+
+    const std::vector<model::PlayerRecordItem> records{{"id0"s, "Шарик"s, 30, 12345}, {"id1"s, "Rex \"the dog\""s, 0, 60000}};
+    CHECK(json_serializer::MakeRecordsResponce(records) == json_dom_reference::MakeRecordsResponce(records));
+}
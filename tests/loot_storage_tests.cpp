@@ -0,0 +1,92 @@
+#include <set>
+#include <sstream>
+#include <catch2/catch_test_macros.hpp>
+#include "../src/loot_storage.h"
+#include "../src/model_serialization.h"
+
+using model::LootInfo;
+using model::LootStorage;
+
+SCENARIO("Loot storage") {
+    LootStorage storage;
+    const auto first_id = storage.Add(LootInfo{0, 1, 1.0, 2.0}).id;
+    const auto second_id = storage.Add(LootInfo{0, 2, 3.0, 4.0}).id;
+    const auto third_id = storage.Add(LootInfo{0, 3, 5.0, 6.0}).id;
+
+    WHEN("loots are added") {
+        THEN("they get distinct ids and can be found by id") {
+            CHECK(first_id != second_id);
+            CHECK(second_id != third_id);
+            REQUIRE(storage.Find(second_id));
+            CHECK(storage.Find(second_id)->type == 2);
+            CHECK(storage.Size() == 3);
+        }
+    }
+    WHEN("a loot is removed") {
+        REQUIRE(storage.Remove(first_id));
+        THEN("the other loots stay dense and keep their ids") {
+            CHECK(storage.Size() == 2);
+            CHECK_FALSE(storage.Find(first_id));
+            CHECK_FALSE(storage.Remove(first_id));
+            REQUIRE(storage.Find(third_id));
+            CHECK(storage.Find(third_id)->x == 5.0);
+            for (const auto &loot : storage.GetLoots()) {
+                CHECK(storage.Find(loot.id) == &loot);
+            }
+        }
+        THEN("the freed slot gets a new id") {
+            const auto new_id = storage.Add(LootInfo{0, 4, 7.0, 8.0}).id;
+            CHECK(new_id != first_id);
+            CHECK_FALSE(storage.Find(first_id));
+            REQUIRE(storage.Find(new_id));
+            CHECK(storage.Find(new_id)->type == 4);
+        }
+    }
+    WHEN("loots are picked up and spawned again many times") {
+        // Свободные слоты выдаются в обратном порядке, поэтому один слот
+        // проходит все свои поколения
+        std::set<LootStorage::Id> ids{first_id, second_id, third_id};
+        auto id = third_id;
+        bool unique = true;
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(storage.Remove(id));
+            id = storage.Add(LootInfo{0, 4, 7.0, 8.0}).id;
+            unique = unique && ids.insert(id).second;
+        }
+
+        THEN("ids of removed loots are never given out again") {
+            CHECK(unique);
+            CHECK(storage.Size() == 3);
+            CHECK_FALSE(storage.Find(third_id));
+            REQUIRE(storage.Find(id));
+            CHECK(storage.Find(id)->type == 4);
+        }
+    }
+    WHEN("a game session state is saved and restored") {
+        storage.Remove(second_id);
+        model::GameSessionState state;
+        state.map_id_ = "map1";
+        state.player_id_ = 1;
+        state.loots_state_ = storage;
+
+        std::stringstream ss;
+        {
+            boost::archive::text_oarchive oa{ss};
+            oa << state;
+        }
+        model::GameSessionState restored;
+        boost::archive::text_iarchive ia{ss};
+        ia >> restored;
+
+        THEN("loots keep their ids and freed slots are not reused with old ids") {
+            auto &loots = restored.loots_state_;
+            REQUIRE(loots.Size() == 2);
+            REQUIRE(loots.Find(first_id));
+            CHECK(loots.Find(first_id)->type == 1);
+            REQUIRE(loots.Find(third_id));
+            CHECK(loots.Find(third_id)->y == 6.0);
+            CHECK_FALSE(loots.Find(second_id));
+            CHECK(loots.Add(LootInfo{0, 5, 0.0, 0.0}).id != second_id);
+        }
+    }
+}
@@ -0,0 +1,197 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "../src/road_graph.h"
+
+using model::Point;
+using model::Road;
+using model::RoadGraph;
+using model::RoadInfo;
+
+namespace {
+
+struct Neighbours {
+    std::vector<std::uint32_t> adjacent;
+    std::vector<std::uint32_t> crossed;
+};
+
+bool SamePoint(Point lhs, Point rhs) {
+    return lhs.x == rhs.x && lhs.y == rhs.y;
+}
+
+// Эталон - прежнее построение графа перебором всех пар дорог. Дороги одного
+// направления с общим концом смежны, перпендикулярные - пересекаются, если
+// их отрезки имеют общую точку
+std::vector<Neighbours> BuildReference(const model::Map::Roads& roads) {
+    std::vector<Neighbours> result(roads.size());
+    for (size_t i = 0; i < roads.size(); ++i) {
+        for (size_t j = i + 1; j < roads.size(); ++j) {
+            const Road& a = roads[i];
+            const Road& b = roads[j];
+            const bool same_direction = (a.IsHorizontal() && b.IsHorizontal()) || (a.IsVertical() && b.IsVertical());
+            if (same_direction && (SamePoint(a.GetStart(), b.GetStart()) || SamePoint(a.GetStart(), b.GetEnd()) ||
+                                   SamePoint(a.GetEnd(), b.GetStart()) || SamePoint(a.GetEnd(), b.GetEnd()))) {
+                result[i].adjacent.push_back(static_cast<std::uint32_t>(j));
+                result[j].adjacent.push_back(static_cast<std::uint32_t>(i));
+                continue;
+            }
+            if (a.IsHorizontal() == b.IsHorizontal())
+                continue;
+
+            const Road& horizontal = a.IsHorizontal() ? a : b;
+            const Road& vertical = a.IsHorizontal() ? b : a;
+            const auto [x_min, x_max] = std::minmax({horizontal.GetStart().x, horizontal.GetEnd().x});
+            const auto [y_min, y_max] = std::minmax({vertical.GetStart().y, vertical.GetEnd().y});
+            const auto x = vertical.GetStart().x;
+            const auto y = horizontal.GetStart().y;
+            if (x_min <= x && x <= x_max && y_min <= y && y <= y_max) {
+                result[i].crossed.push_back(static_cast<std::uint32_t>(j));
+                result[j].crossed.push_back(static_cast<std::uint32_t>(i));
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<std::uint32_t> Indices(std::span<const RoadInfo> roads) {
+    std::vector<std::uint32_t> result;
+    for (const auto& road : roads)
+        result.push_back(road.road_index);
+    return result;
+}
+
+std::vector<std::uint32_t> Sorted(std::vector<std::uint32_t> indices) {
+    std::sort(indices.begin(), indices.end());
+    return indices;
+}
+
+model::Coord GetCrossCoord(const Road& road) {
+    return road.IsVertical() ? road.GetStart().x : road.GetStart().y;
+}
+
+void CheckMatchesReference(const model::Map::Roads& roads) {
+    const RoadGraph graph{roads};
+    const auto reference = BuildReference(roads);
+    REQUIRE(graph.GetNumRoads() == roads.size());
+    for (size_t i = 0; i < roads.size(); ++i) {
+        INFO("road " << i);
+        CHECK(Indices(graph.GetAdjacentRoads(i)) == Sorted(reference[i].adjacent));
+        const auto crossed = Indices(graph.GetCrossRoads(i));
+        CHECK(Sorted(crossed) == Sorted(reference[i].crossed));
+        CHECK(std::is_sorted(crossed.begin(), crossed.end(), [&roads](auto lhs, auto rhs) {
+            return GetCrossCoord(roads[lhs]) < GetCrossCoord(roads[rhs]);
+        }));
+        for (const auto& road : graph.GetAdjacentRoads(i))
+            CHECK(road.road_type == model::RoadType::Adjacent);
+        for (const auto& road : graph.GetCrossRoads(i))
+            CHECK(road.road_type == model::RoadType::Crossed);
+    }
+}
+
+}  // namespace
+
+SCENARIO("Road graph") {
+    WHEN("a road ends on the middle of a perpendicular road") {
+        const model::Map::Roads roads{Road{Road::HORIZONTAL, Point{0, 0}, 10},
+                                      Road{Road::VERTICAL, Point{5, 0}, 10},
+                                      Road{Road::VERTICAL, Point{5, -10}, -1}};
+        const RoadGraph graph{roads};
+
+        THEN("the roads of a T-junction cross, and a road stopping short of it does not") {
+            CHECK(Indices(graph.GetCrossRoads(0)) == std::vector<std::uint32_t>{1});
+            CHECK(Indices(graph.GetCrossRoads(1)) == std::vector<std::uint32_t>{0});
+            CHECK(graph.GetCrossRoads(2).empty());
+            CHECK(graph.GetAdjacentRoads(0).empty());
+            CHECK(graph.GetAdjacentRoads(1).empty());
+            CHECK(graph.GetAdjacentRoads(2).empty());
+        }
+    }
+
+    WHEN("roads of the same direction touch") {
+        const model::Map::Roads roads{Road{Road::HORIZONTAL, Point{0, 0}, 10},
+                                      Road{Road::HORIZONTAL, Point{20, 0}, 10},
+                                      Road{Road::HORIZONTAL, Point{5, 0}, 15},
+                                      Road{Road::VERTICAL, Point{20, 0}, 10},
+                                      Road{Road::VERTICAL, Point{20, 20}, 10}};
+        const RoadGraph graph{roads};
+
+        THEN("roads sharing an end are adjacent in both directions, overlapping ones are not") {
+            CHECK(Indices(graph.GetAdjacentRoads(0)) == std::vector<std::uint32_t>{1});
+            CHECK(Indices(graph.GetAdjacentRoads(1)) == std::vector<std::uint32_t>{0});
+            CHECK(graph.GetAdjacentRoads(2).empty());
+            CHECK(Indices(graph.GetAdjacentRoads(3)) == std::vector<std::uint32_t>{4});
+            CHECK(Indices(graph.GetAdjacentRoads(4)) == std::vector<std::uint32_t>{3});
+        }
+
+        THEN("the corner of perpendicular roads is a crossing") {
+            CHECK(Indices(graph.GetCrossRoads(1)) == std::vector<std::uint32_t>{3});
+            CHECK(Indices(graph.GetCrossRoads(3)) == std::vector<std::uint32_t>{1});
+            CHECK(graph.GetCrossRoads(4).empty());
+        }
+    }
+
+    WHEN("a map has a road of zero length") {
+        const model::Map::Roads roads{Road{Road::HORIZONTAL, Point{5, 5}, 5},
+                                      Road{Road::VERTICAL, Point{5, 0}, 10},
+                                      Road{Road::HORIZONTAL, Point{5, 5}, 15},
+                                      Road{Road::HORIZONTAL, Point{0, 5}, 3}};
+        const RoadGraph graph{roads};
+
+        THEN("it is both horizontal and vertical for its neighbours") {
+            CHECK(Indices(graph.GetCrossRoads(0)) == std::vector<std::uint32_t>{1});
+            CHECK(Indices(graph.GetAdjacentRoads(0)) == std::vector<std::uint32_t>{2});
+            CHECK(Sorted(Indices(graph.GetCrossRoads(1))) == std::vector<std::uint32_t>{0, 2});
+            CHECK(graph.GetCrossRoads(3).empty());
+            CHECK(graph.GetAdjacentRoads(3).empty());
+        }
+        THEN("the graph matches the reference") {
+            CheckMatchesReference(roads);
+        }
+    }
+
+    WHEN("crossings are searched by coordinate") {
+        const model::Map::Roads roads{Road{Road::HORIZONTAL, Point{0, 0}, 10},
+                                      Road{Road::VERTICAL, Point{7, -5}, 5},
+                                      Road{Road::VERTICAL, Point{0, 0}, 5},
+                                      Road{Road::VERTICAL, Point{10, 0}, -5},
+                                      Road{Road::VERTICAL, Point{3, 5}, -5}};
+        const RoadGraph graph{roads};
+
+        THEN("crossings are ordered by coordinate and the range includes its bounds") {
+            CHECK(Indices(graph.GetCrossRoads(0)) == std::vector<std::uint32_t>{2, 4, 1, 3});
+            CHECK(Indices(graph.GetCrossRoads(0, 3.0, 7.0)) == std::vector<std::uint32_t>{4, 1});
+            CHECK(Indices(graph.GetCrossRoads(0, 2.9, 7.1)) == std::vector<std::uint32_t>{4, 1});
+            CHECK(graph.GetCrossRoads(0, 3.1, 6.9).empty());
+            CHECK(Indices(graph.GetCrossRoads(0, -5.0, 0.0)) == std::vector<std::uint32_t>{2});
+            CHECK(Indices(graph.GetCrossRoads(0, 10.0, 10.0)) == std::vector<std::uint32_t>{3});
+            CHECK(graph.GetCrossRoads(0, 10.5, 20.0).empty());
+            CHECK(graph.GetCrossRoads(0, -3.0, -1.0).empty());
+            CHECK(Indices(graph.GetCrossRoads(0, 0.0, 10.0)) == std::vector<std::uint32_t>{2, 4, 1, 3});
+            CHECK(graph.GetCrossRoads(0, 7.0, 3.0).empty());
+        }
+        THEN("a vertical road finds its crossings by y") {
+            CHECK(Indices(graph.GetCrossRoads(1, 0.0, 0.0)) == std::vector<std::uint32_t>{0});
+            CHECK(graph.GetCrossRoads(1, 0.5, 5.0).empty());
+        }
+    }
+
+    WHEN("a map is made of random short roads") {
+        THEN("the graph matches the reference") {
+            std::mt19937 random{42};
+            std::uniform_int_distribution<int> coord{0, 40};
+            std::uniform_int_distribution<int> length{-8, 8};
+            for (int run = 0; run < 5; ++run) {
+                model::Map::Roads roads;
+                for (int i = 0; i < 300; ++i) {
+                    const Point start{coord(random), coord(random)};
+                    if (random() % 2)
+                        roads.emplace_back(Road::HORIZONTAL, start, start.x + length(random));
+                    else
+                        roads.emplace_back(Road::VERTICAL, start, start.y + length(random));
+                }
+                CheckMatchesReference(roads);
+            }
+        }
+    }
+}
@@ -0,0 +1,35 @@
+#include <random>
+#include <catch2/catch_test_macros.hpp>
+#include "../src/spatial_grid.h"
+
+using model::SpatialGrid;
+
+SCENARIO("Spatial grid") {
+    GIVEN("points scattered over a large map, including negative coordinates") {
+        std::mt19937 engine{42};
+        std::uniform_real_distribution<double> coord{-200.0, 800.0};
+        std::vector<geom::Point2D> points;
+        for (int i = 0; i < 2000; ++i) {
+            points.emplace_back(coord(engine), coord(engine));
+        }
+        const SpatialGrid grid{25.0, points};
+
+        THEN("a query returns exactly the points within the radius, in ascending order") {
+            for (int i = 0; i < 200; ++i) {
+                const geom::Point2D center{coord(engine), coord(engine)};
+                std::vector<size_t> expected;
+                for (size_t j = 0; j < points.size(); ++j) {
+                    const double dx = points[j].x - center.x, dy = points[j].y - center.y;
+                    if (dx * dx + dy * dy <= 25.0 * 25.0) {
+                        expected.push_back(j);
+                    }
+                }
+                CHECK(grid.Query(center, 25.0) == expected);
+            }
+        }
+        THEN("a point on the circle boundary is included") {
+            const SpatialGrid small{10.0, {{0.0, 0.0}, {10.0, 0.0}, {10.5, 0.0}}};
+            CHECK(small.Query({0.0, 0.0}, 10.0) == std::vector<size_t>{0, 1});
+        }
+    }
+}
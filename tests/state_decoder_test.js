@@ -0,0 +1,50 @@
+// Checks static/js/state_decoder.js against the golden binary messages in tests/data.
+// The same files are produced byte for byte by the C++ encoder in tests/binary_serializer_tests.cpp.
+// Run with: node tests/state_decoder_test.js
+
+const assert = require('assert');
+const fs = require('fs');
+const path = require('path');
+const dogStoryBinary = require('../static/js/state_decoder.js');
+
+function readGolden(name) {
+  const text = fs.readFileSync(path.join(__dirname, 'data', name), 'utf8');
+  const bytes = [];
+  for (const line of text.split('\n')) {
+    for (const word of line.split('#')[0].split(/\s+/)) {
+      if (word) {
+        bytes.push(parseInt(word, 16));
+      }
+    }
+  }
+  return new Uint8Array(bytes);
+}
+
+const lootTypes = [{ name: 'key' }, { name: 'wallet' }, { name: 'bone' }, { name: 'ball' }];
+
+const state = dogStoryBinary.decodeState(readGolden('binary_state.hex'));
+assert.deepStrictEqual(state, {
+  tick: 300,
+  players: {
+    200: {
+      pos: [-1.5, 2.25],
+      speed: [0, 0],
+      dir: '',
+      bag: [{ id: 5, type: 1 }, { id: 1048577, type: 2 }],
+      score: 130
+    },
+    7: { pos: [10, 0.4], speed: [-2.5, 0], dir: 'L', bag: [], score: 0 }
+  },
+  lostObjects: { 0: { type: 3, pos: [-0.5, 10] } }
+});
+
+const described = dogStoryBinary.decodeState(readGolden('binary_state.hex'), lootTypes);
+assert.deepStrictEqual(described.players[200].bag[1].lootType, { name: 'bone' });
+assert.deepStrictEqual(described.lostObjects[0].lootType, { name: 'ball' });
+
+const players = dogStoryBinary.decodePlayers(readGolden('binary_players.hex'));
+assert.deepStrictEqual(players, { 200: { name: 'Шарик' }, 7: { name: 'Rex' } });
+
+assert.throws(() => dogStoryBinary.decodePlayers(readGolden('binary_state.hex')), /message kind/);
+
+console.log('state_decoder: all checks passed');
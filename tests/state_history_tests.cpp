@@ -0,0 +1,84 @@
+#include <catch2/catch_test_macros.hpp>
+#include "../src/game_session.h"
+#include "../src/state_history.h"
+#include "test_utils.h"
+
+using namespace std::literals;
+using model::StateHistory;
+
+SCENARIO("State history") {
+    model::Map map = MakeOneRoadMap();
+    model::GameSession session{"map"s, 5.0, 0.5};
+    const auto first = session.AddPlayer("first"s, &map, false, 3);
+    const auto second = session.AddPlayer("second"s, &map, false, 3);
+    model::LootStorage loots;
+    const auto kept_loot = loots.Add(model::LootInfo{0, 0, 10.0, 0.0}).id;
+    const auto taken_loot = loots.Add(model::LootInfo{0, 0, 20.0, 0.0}).id;
+
+    StateHistory history{4};
+    REQUIRE(history.Commit(session.GetPlayers(), loots) == 1);
+
+    WHEN("nothing changes") {
+        REQUIRE(history.Commit(session.GetPlayers(), loots) == 2);
+        THEN("the delta from the previous version is empty") {
+            const auto delta = history.GetDelta(1);
+            REQUIRE(delta);
+            CHECK(delta->changed_players.empty());
+            CHECK(delta->removed_players.empty());
+            CHECK(delta->added_loots.empty());
+            CHECK(delta->removed_loots.empty());
+        }
+        THEN("the delta from the start contains the whole state") {
+            const auto delta = history.GetDelta(0);
+            REQUIRE(delta);
+            CHECK(delta->changed_players == std::vector<unsigned>{first->GetId(), second->GetId()});
+            CHECK(delta->added_loots.size() == 2);
+        }
+    }
+    WHEN("a dog moves and a loot is taken") {
+        first->GetDog()->SetSpeed(model::DogDirection::EAST, 1.0);
+        session.MoveDogs(1000);
+        loots.Remove(taken_loot);
+        history.Commit(session.GetPlayers(), loots);
+        THEN("only the changed dog and the removed loot are reported") {
+            const auto delta = history.GetDelta(1);
+            REQUIRE(delta);
+            CHECK(delta->changed_players == std::vector<unsigned>{first->GetId()});
+            CHECK(delta->removed_loots == std::vector<model::LootStorage::Id>{taken_loot});
+            CHECK(delta->added_loots.empty());
+        }
+    }
+    WHEN("a loot appears and disappears between two client polls") {
+        const auto short_lived = loots.Add(model::LootInfo{0, 0, 30.0, 0.0}).id;
+        history.Commit(session.GetPlayers(), loots);
+        loots.Remove(short_lived);
+        history.Commit(session.GetPlayers(), loots);
+        THEN("the client does not hear about it") {
+            const auto delta = history.GetDelta(1);
+            REQUIRE(delta);
+            CHECK(delta->added_loots.empty());
+            CHECK(delta->removed_loots.empty());
+        }
+    }
+    WHEN("a player leaves") {
+        session.DeleteRetiredPlayers({second});
+        history.Commit(session.GetPlayers(), loots);
+        THEN("it is reported as removed") {
+            const auto delta = history.GetDelta(1);
+            REQUIRE(delta);
+            CHECK(delta->removed_players == std::vector<unsigned>{second->GetId()});
+            CHECK(delta->changed_players.empty());
+        }
+    }
+    WHEN("the client version falls out of the ring") {
+        for (int i = 0; i < 5; ++i) {
+            history.Commit(session.GetPlayers(), loots);
+        }
+        THEN("no delta is available and a full state is required") {
+            CHECK_FALSE(history.GetDelta(1));
+            CHECK(history.GetDelta(2));
+            CHECK_FALSE(history.GetDelta(history.GetVersion() + 1));
+        }
+    }
+    CHECK(loots.Find(kept_loot));
+}
@@ -0,0 +1,205 @@
+#include <catch2/catch_test_macros.hpp>
+#include <fstream>
+#include <unistd.h>
+#include "../src/static_cache.h"
+
+using namespace std::literals;
+namespace fs = std::filesystem;
+
+namespace {
+
+struct TempDir {
+    TempDir() : path{fs::temp_directory_path() / ("static_cache_tests_"s + std::to_string(::getpid()))} {
+        fs::remove_all(path);
+        fs::create_directories(path / "js");
+    }
+    ~TempDir() {
+        std::error_code ec;
+        fs::remove_all(path, ec);
+    }
+
+    void Write(const std::string& name, const std::string& content) const {
+        std::ofstream(path / name, std::ios::binary) << content;
+    }
+
+    fs::path path;
+};
+
+std::string MakeScript(char fill, size_t size) {
+    std::string script;
+    while (script.size() < size) {
+        script += "let value_"s + fill + std::to_string(script.size()) + " = "s + std::to_string(script.size() * 7919) + ";\n"s;
+    }
+    return script;
+}
+
+}  // namespace
+
+SCENARIO("Static file cache") {
+    TempDir dir;
+    dir.Write("index.html", "<html>"s + std::string(2000, ' ') + "</html>"s);
+    dir.Write("js/app.js", MakeScript('a', 4000));
+    dir.Write("icon.png", std::string(3000, 'p'));
+    dir.Write("file with spaces.html", "spaces");
+
+    GIVEN("a cache large enough for the whole directory") {
+        static_cache::StaticCache cache(dir.path, 1 << 20);
+
+        THEN("files are preloaded with compressed variants and validators") {
+            CHECK(cache.GetSize() > 0);
+            const auto file = cache.Get("/index.html");
+            REQUIRE(file);
+            CHECK(file->response.body->size() == 2013);
+            CHECK(file->response.gzip_body);
+            CHECK(file->response.brotli_body);
+            CHECK(static_cache::ParseHttpDate(file->last_modified) == file->modified_time);
+        }
+        THEN("already compressed formats are kept as is") {
+            const auto file = cache.Get("/icon.png");
+            REQUIRE(file);
+            CHECK_FALSE(file->response.gzip_body);
+            CHECK_FALSE(file->response.brotli_body);
+        }
+        THEN("targets are decoded and query parameters are ignored") {
+            CHECK(cache.Get("/file%20with%20spaces.html"));
+            CHECK(cache.Get("/js/app.js?v=2") == cache.Get("/js//./app.js"));
+        }
+        THEN("paths outside of the directory are rejected") {
+            CHECK_FALSE(cache.Get("/../static_cache_tests.cpp"));
+            CHECK_FALSE(cache.Get("/js/%2e%2e/%2e%2e/etc/passwd"));
+            CHECK_FALSE(cache.ResolvePath("/js/../../etc/passwd"));
+            CHECK(cache.ResolvePath("/js/app.js") == dir.path / "js/app.js");
+        }
+        THEN("missing files are not found") {
+            CHECK_FALSE(cache.Get("/missing.html"));
+            CHECK_FALSE(cache.Get("/js"));
+        }
+
+        WHEN("a file changes and is invalidated") {
+            const auto before = cache.Get("/js/app.js");
+            dir.Write("js/app.js", "changed");
+            cache.Invalidate(dir.path / "js");
+
+            THEN("the next request reads it again") {
+                const auto after = cache.Get("/js/app.js");
+                REQUIRE(after);
+                CHECK(*after->response.body == "changed"s);
+                CHECK(after->response.etag != before->response.etag);
+                CHECK(*before->response.body != "changed"s);
+            }
+        }
+
+        WHEN("a file is requested after it has left the cache") {
+            const auto before = cache.Get("/index.html");
+            cache.Invalidate(dir.path / "index.html");
+            const auto first = cache.Get("/index.html");
+            const auto second = cache.Get("/index.html");
+
+            THEN("it is served at once without compression, and concurrent requests share the loaded file") {
+                REQUIRE(first);
+                CHECK(*first->response.body == *before->response.body);
+                CHECK(first->response.etag == before->response.etag);
+                CHECK_FALSE(first->response.gzip_body);
+                CHECK_FALSE(first->response.brotli_body);
+                CHECK(second->response.body == first->response.body);
+            }
+            THEN("its compressed variants are built in the background") {
+                cache.WaitCompressed();
+                const auto compressed = cache.Get("/index.html");
+                REQUIRE(compressed);
+                CHECK(compressed->response.body == first->response.body);
+                CHECK(compressed->response.gzip_etag == before->response.gzip_etag);
+                CHECK(compressed->response.brotli_etag == before->response.brotli_etag);
+                CHECK(compressed->size == before->size);
+            }
+        }
+    }
+
+    GIVEN("a small cache") {
+        constexpr size_t capacity = 16 * 1024;
+        for (char fill = 'a'; fill <= 'p'; ++fill) {
+            dir.Write("js/"s + fill + ".js"s, MakeScript(fill, 1500));
+        }
+        static_cache::StaticCache cache(dir.path, capacity);
+
+        THEN("it never grows past its capacity and keeps recently requested files") {
+            for (char fill = 'a'; fill <= 'p'; ++fill) {
+                REQUIRE(cache.Get("/js/"s + fill + ".js"s));
+                CHECK(cache.GetSize() <= capacity);
+            }
+            cache.WaitCompressed();
+            CHECK(cache.GetSize() <= capacity);
+            const auto size = cache.GetSize();
+            cache.Get("/js/p.js");
+            CHECK(cache.GetSize() == size);
+        }
+        THEN("files larger than a share of the capacity are served from disk") {
+            dir.Write("big.js", MakeScript('z', capacity / static_cache::StaticCache::maxFileShare + 1));
+            CHECK_FALSE(cache.Get("/big.js"));
+            CHECK(fs::exists(*cache.ResolvePath("/big.js")));
+        }
+    }
+}
+
+SCENARIO("HTTP dates") {
+    CHECK(static_cache::FormatHttpDate(784111777) == "Sun, 06 Nov 1994 08:49:37 GMT"s);
+    CHECK(static_cache::ParseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT") == std::time_t{784111777});
+    CHECK_FALSE(static_cache::ParseHttpDate("yesterday"));
+    CHECK_FALSE(static_cache::ParseHttpDate(""));
+}
+
+SCENARIO("Open file cache") {
+    TempDir dir;
+    dir.Write("js/app.js", MakeScript('a', 4000));
+
+    GIVEN("a cache of two descriptors") {
+        static_cache::OpenFileCache cache(dir.path, 2);
+
+        THEN("a file is opened once and described by its size and modification time") {
+            const auto file = cache.Open("js/app.js");
+            REQUIRE(file);
+            CHECK(file->fd >= 0);
+            CHECK(file->size == fs::file_size(dir.path / "js/app.js"));
+            CHECK(static_cache::ParseHttpDate(file->last_modified) == file->modified_time);
+            CHECK(file->etag.front() == '"');
+            CHECK(cache.Open("js/app.js") == file);
+        }
+        THEN("directories and missing files are not opened") {
+            CHECK_FALSE(cache.Open("js"));
+            CHECK_FALSE(cache.Open("js/missing.js"));
+            CHECK(cache.GetSize() == 0);
+        }
+        THEN("it keeps no more than two descriptors") {
+            for (char fill = 'a'; fill <= 'e'; ++fill) {
+                dir.Write("js/"s + fill + ".js"s, "x"s);
+                REQUIRE(cache.Open("js/"s + fill + ".js"s));
+            }
+            CHECK(cache.GetSize() == 2);
+        }
+        WHEN("a file is replaced and its directory is invalidated") {
+            const auto before = cache.Open("js/app.js");
+            fs::remove(dir.path / "js/app.js");
+            dir.Write("js/app.js", "changed");
+            cache.Invalidate("js");
+
+            THEN("the new file is opened, while the old descriptor stays valid for pending responses") {
+                const auto after = cache.Open("js/app.js");
+                REQUIRE(after);
+                CHECK(after != before);
+                CHECK(after->size == 7);
+                CHECK(::lseek(before->fd, 0, SEEK_END) == static_cast<off_t>(before->size));
+            }
+        }
+    }
+
+    GIVEN("a static cache too small to keep the file in memory") {
+        static_cache::StaticCache cache(dir.path, 1024);
+
+        THEN("the file is served from disk instead") {
+            CHECK_FALSE(cache.Get("/js/app.js"));
+            const auto file = cache.Open("/js/app.js?v=1");
+            REQUIRE(file);
+            CHECK_FALSE(cache.Open("/js/../../app.js"));
+        }
+    }
+}
@@ -1,9 +1,11 @@
+#pragma once
 #include <cmath>
 #include <functional>
 #include <sstream>
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_templated.hpp>
 #include "../src/collision_detector.h"
+#include "../src/model.h"
 
 namespace Catch {
 template<>
@@ -19,6 +21,15 @@ struct StringMaker<collision_detector::GatheringEvent> {
 
 namespace {
 
+// Карта из одной горизонтальной дороги длиной 100 с построенными графом дорог и слоем офисов
+inline model::Map MakeOneRoadMap() {
+    model::Map map{model::Map::Id{std::string{"map"}}, std::string{"Map"}};
+    map.AddRoad(model::Road{model::Road::HORIZONTAL, model::Point{0, 0}, 100});
+    map.BuildRoadGraph();
+    map.BuildOfficeLayer();
+    return map;
+}
+
 template <typename Range, typename Predicate>
 struct RangeMatcher : Catch::Matchers::MatcherGenericBase {
        RangeMatcher(Range const& range, Predicate predicate)